@@ -0,0 +1,308 @@
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include "Cooker.h"
+#include "Image.h"
+#include "../ShipShoot/AssetArchive.h"
+#include "../ShipShoot/AudioMix.h"
+#include "../ShipShoot/WavFile.h"
+
+using namespace std;
+
+const char* Cooker::COOKED_DIR = "cooked";
+const char* Cooker::MANIFEST_NAME = "cooked/manifest.txt";
+
+//bump this when the cooking code changes what it outputs so everything gets cooked again
+static const char COOKER_VERSION[] = "shipshoot-cooker-1";
+
+//FNV-1a, same as the archive uses for names
+static uint64_t HashBytes(const void* p, size_t numBytes, uint64_t hash = 14695981039346656037ull)
+{
+	const uint8_t* pBytes = static_cast<const uint8_t*>(p);
+	for (size_t i = 0; i < numBytes; ++i)
+	{
+		hash ^= pBytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+static uint64_t HashString(const std::string& s, uint64_t hash)
+{
+	//include the terminator so "ab"+"c" and "a"+"bc" differ
+	return HashBytes(s.c_str(), s.size() + 1, hash);
+}
+
+//the options each kind takes, anything else in a recipe is a mistake
+static bool CheckParam(const std::string& kind, const std::string& key, const std::string& value, std::string& error)
+{
+	const char* pEnd = value.c_str() + value.size();
+	char* pParsed = nullptr;
+	if (key == "mips" && kind != "sound")
+	{
+		if (value != "0" && value != "1")
+			error = "mips must be 0 or 1";
+	}
+	else if (key == "scale" && kind == "sprite")
+	{
+		float scale = strtof(value.c_str(), &pParsed);
+		if (value.empty() || pParsed != pEnd || !isfinite(scale) || scale <= 0)
+			error = "scale must be a number more than 0";
+	}
+	else if (key == "rate" && kind == "sound")
+	{
+		unsigned long rate = strtoul(value.c_str(), &pParsed, 10);
+		if (value.empty() || !isdigit(static_cast<unsigned char>(value[0])) || pParsed != pEnd || rate < 1000 || rate > 384000)
+			error = "rate must be a whole number of hz from 1000 to 384000";
+	}
+	else
+		error = "unknown option " + key + " for " + kind;
+	return error.empty();
+}
+
+Cooker::Cooker(const std::string& rootDir)
+	: mRootDir(rootDir)
+{
+}
+
+bool Cooker::LoadRecipe(const std::string& fileName, std::string* pError)
+{
+	ifstream in(mRootDir + "/" + fileName);
+	if (!in)
+	{
+		if (pError)
+			*pError = "cannot open " + fileName;
+		return false;
+	}
+	mJobs.clear();
+	string line;
+	int lineNum = 0;
+	while (getline(in, line))
+	{
+		++lineNum;
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		size_t first = line.find_first_not_of(" \t");
+		if (first == string::npos || line[first] == '#')
+			continue;
+		istringstream fields(line);
+		Job job;
+		job.line = lineNum;
+		fields >> job.kind >> job.input >> job.output;
+		string kv;
+		while (fields >> kv)
+		{
+			size_t eq = kv.find('=');
+			if (eq == string::npos)
+			{
+				if (pError)
+					*pError = fileName + "(" + to_string(lineNum) + "): expected key=value, got " + kv;
+				return false;
+			}
+			job.params[kv.substr(0, eq)] = kv.substr(eq + 1);
+		}
+		if (job.output.empty() || (job.kind != "texture" && job.kind != "sprite" && job.kind != "sound"))
+		{
+			if (pError)
+				*pError = fileName + "(" + to_string(lineNum) + "): expected texture|sprite|sound input output";
+			return false;
+		}
+		//checked here so a bad value can't throw on a worker thread later
+		for (auto& param : job.params)
+		{
+			string error;
+			if (!CheckParam(job.kind, param.first, param.second, error))
+			{
+				if (pError)
+					*pError = fileName + "(" + to_string(lineNum) + "): " + error;
+				return false;
+			}
+		}
+		mJobs.push_back(job);
+	}
+	return true;
+}
+
+std::string Cooker::GetParam(const Job& job, const std::string& key, const std::string& def) const
+{
+	auto it = job.params.find(key);
+	return it == job.params.end() ? def : it->second;
+}
+
+bool Cooker::Hash(const Job& job, uint64_t& hash, std::string& error) const
+{
+	ifstream in(mRootDir + "/" + job.input, ios::binary);
+	if (!in)
+	{
+		error = "cannot open " + job.input;
+		return false;
+	}
+	vector<char> bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+	hash = HashString(COOKER_VERSION, 14695981039346656037ull);
+	hash = HashString(job.kind, hash);
+	hash = HashString(AssetArchive::Normalise(job.output), hash);
+	for (auto& p : job.params)
+	{
+		hash = HashString(p.first, hash);
+		hash = HashString(p.second, hash);
+	}
+	hash = HashBytes(bytes.data(), bytes.size(), hash);
+	return true;
+}
+
+bool Cooker::Run(unsigned int numThreads, bool force)
+{
+	AssetManifest previous;
+	previous.Load(mRootDir + "/" + MANIFEST_NAME);
+
+	mResults.assign(mJobs.size(), Result());
+	numThreads = max(1u, min(numThreads, static_cast<unsigned int>(mJobs.size())));
+	atomic<size_t> next{ 0 };
+	mutex logLock;
+	auto worker = [&]() {
+		for (size_t i = next++; i < mJobs.size(); i = next++)
+		{
+			Result& r = mResults[i];
+			auto t0 = chrono::steady_clock::now();
+			Cook(mJobs[i], previous, force, r);
+			r.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+			lock_guard<mutex> lock(logLock);
+			if (r.status == Result::FAILED)
+				cout << "FAILED  " << mJobs[i].output << ": " << r.error << "\n";
+			else if (r.status == Result::COOKED)
+				cout << "cooked  " << mJobs[i].output << " (" << static_cast<int>(r.ms) << "ms)\n";
+		}
+	};
+	vector<thread> threads;
+	for (unsigned int i = 1; i < numThreads; ++i)
+		threads.emplace_back(worker);
+	worker();
+	for (auto& t : threads)
+		t.join();
+
+	//anything that failed keeps its old entry so the game still finds the last good cook
+	AssetManifest manifest;
+	bool ok = true;
+	for (size_t i = 0; i < mJobs.size(); ++i)
+	{
+		if (mResults[i].status != Result::FAILED)
+			manifest.Set(mResults[i].entry);
+		else
+		{
+			ok = false;
+			if (const AssetManifest::Entry* pOld = previous.Find(mJobs[i].output))
+				manifest.Set(*pOld);
+		}
+	}
+	if (!manifest.Save(mRootDir + "/" + MANIFEST_NAME))
+	{
+		cout << "FAILED  cannot write " << MANIFEST_NAME << "\n";
+		ok = false;
+	}
+	return ok;
+}
+
+void Cooker::Cook(const Job& job, const AssetManifest& previous, bool force, Result& result) const
+{
+	AssetManifest::Entry& e = result.entry;
+	e.source = AssetArchive::Normalise(job.output);
+	e.cooked = string(COOKED_DIR) + "/" + e.source;
+	e.kind = job.kind;
+	if (!Hash(job, e.hash, result.error))
+	{
+		result.status = Result::FAILED;
+		return;
+	}
+
+	string outFile = mRootDir + "/" + e.cooked;
+	const AssetManifest::Entry* pOld = previous.Find(e.source);
+	error_code ec;
+	if (!force && pOld && pOld->hash == e.hash && pOld->cooked == e.cooked && filesystem::exists(outFile, ec))
+	{
+		e = *pOld;
+		result.status = Result::UP_TO_DATE;
+		return;
+	}
+
+	filesystem::create_directories(filesystem::path(outFile).parent_path(), ec);
+	bool ok = job.kind == "sound" ? CookSound(job, outFile, result) : CookImage(job, outFile, result);
+	result.status = ok ? Result::COOKED : Result::FAILED;
+}
+
+bool Cooker::CookImage(const Job& job, const std::string& outFile, Result& result) const
+{
+	Image src;
+	if (!ReadImage(mRootDir + "/" + job.input, src, &result.error))
+	{
+		result.error = job.input + ": " + result.error;
+		return false;
+	}
+	//the game keeps thinking of it at its original size
+	result.entry.width = src.width;
+	result.entry.height = src.height;
+
+	Image top;
+	if (job.kind == "sprite")
+	{
+		//no point keeping pixels that get thrown away every time it's drawn, LoadRecipe checked it's a number
+		float scale = stof(GetParam(job, "scale", "1"));
+		unsigned int w = max(1u, static_cast<unsigned int>(lround(src.width * scale)));
+		unsigned int h = max(1u, static_cast<unsigned int>(lround(src.height * scale)));
+		top = (w == src.width && h == src.height) ? src : Resize(src, w, h);
+	}
+	else
+		top = src;
+
+	vector<Image> mips;
+	if (GetParam(job, "mips", job.kind == "sprite" ? "0" : "1") != "0")
+		BuildMips(top, mips);
+	else
+		mips.push_back(top);
+	if (!WriteDDS(outFile, mips))
+	{
+		result.error = "cannot write " + outFile;
+		return false;
+	}
+	return true;
+}
+
+bool Cooker::CookSound(const Job& job, const std::string& outFile, Result& result) const
+{
+	ifstream in(mRootDir + "/" + job.input, ios::binary);
+	vector<uint8_t> bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+	WavFile::Data wav;
+	if (!WavFile::Decode(bytes.data(), bytes.size(), wav, 2, &result.error))
+	{
+		result.error = job.input + ": " + result.error;
+		return false;
+	}
+	//LoadRecipe checked it's a number
+	unsigned int rate = static_cast<unsigned int>(stoul(GetParam(job, "rate", "48000")));
+	vector<float> samples;
+	if (wav.rate == rate)
+		samples.swap(wav.samples);
+	else
+	{
+		AudioMix::PolyphaseResampler resampler(wav.rate, rate);
+		resampler.Process(wav.samples.data(), wav.numFrames, wav.numChannels, samples);
+	}
+	unsigned int numFrames = static_cast<unsigned int>(samples.size() / wav.numChannels);
+	vector<int16_t> pcm(samples.size());
+	AudioMix::FloatToInt16(samples.data(), pcm.data(), static_cast<unsigned int>(samples.size()));
+	if (!WavFile::Write16(outFile, pcm.data(), numFrames, wav.numChannels, rate))
+	{
+		result.error = "cannot write " + outFile;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "../ShipShoot/AssetManifest.h"
+
+/*
+Turns source art and audio into what the game actually wants to load.
+A recipe lists one asset per line:
+	kind	input	output	[key=value ...]
+kind is texture (keeps its size, builds mips), sprite (shrunk to the
+scale it's drawn at) or sound (16bit pcm at the mixer rate). Everything
+that goes into a job is hashed and only assets whose hash changed since
+the last manifest, or whose output has gone, are cooked again. Jobs run
+on as many threads as asked for.
+*/
+class Cooker
+{
+public:
+	struct Job
+	{
+		std::string kind, input, output;
+		std::map<std::string, std::string> params;
+		int line = 0;
+	};
+	struct Result
+	{
+		enum Status { COOKED, UP_TO_DATE, FAILED };
+		Status status = FAILED;
+		AssetManifest::Entry entry;
+		std::string error;
+		double ms = 0;
+	};
+
+	//everything is relative to this, normally the game's bin folder
+	explicit Cooker(const std::string& rootDir);
+	bool LoadRecipe(const std::string& fileName, std::string* pError);
+	const std::vector<Job>& GetJobs() const { return mJobs; }
+	//cook whatever changed, returns false if any job failed
+	bool Run(unsigned int numThreads, bool force);
+	const std::vector<Result>& GetResults() const { return mResults; }
+	//where the cooked files and the manifest go
+	static const char* COOKED_DIR;
+	static const char* MANIFEST_NAME;
+private:
+	bool Hash(const Job& job, uint64_t& hash, std::string& error) const;
+	void Cook(const Job& job, const AssetManifest& previous, bool force, Result& result) const;
+	bool CookImage(const Job& job, const std::string& outFile, Result& result) const;
+	bool CookSound(const Job& job, const std::string& outFile, Result& result) const;
+	std::string GetParam(const Job& job, const std::string& key, const std::string& def) const;
+
+	std::string mRootDir;
+	std::vector<Job> mJobs;
+	std::vector<Result> mResults;		//one per job
+};
@@ -0,0 +1,427 @@
+#include <cassert>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <wincodec.h>
+#endif
+
+#include "Image.h"
+
+using namespace std;
+
+static uint32_t Read32(const uint8_t* p)
+{
+	uint32_t v;
+	memcpy(&v, p, 4);
+	return v;
+}
+
+static void SetError(std::string* pError, const char* msg)
+{
+	if (pError)
+		*pError = msg;
+}
+
+//**************************************************************************************************
+//dds decoding
+
+//565 colour to 8bit rgb
+static void Unpack565(uint16_t c, uint8_t* pRGB)
+{
+	pRGB[0] = static_cast<uint8_t>(((c >> 11) & 31) * 255 / 31);
+	pRGB[1] = static_cast<uint8_t>(((c >> 5) & 63) * 255 / 63);
+	pRGB[2] = static_cast<uint8_t>((c & 31) * 255 / 31);
+}
+
+//the colour half of a DXT block, 4x4 pixels written as rgba into pOut
+static void DecodeColourBlock(const uint8_t* pBlock, bool dxt1, uint8_t pOut[16][4])
+{
+	uint16_t c0 = static_cast<uint16_t>(pBlock[0] | (pBlock[1] << 8));
+	uint16_t c1 = static_cast<uint16_t>(pBlock[2] | (pBlock[3] << 8));
+	uint8_t pal[4][4];
+	Unpack565(c0, pal[0]);
+	Unpack565(c1, pal[1]);
+	pal[0][3] = pal[1][3] = pal[2][3] = pal[3][3] = 255;
+	for (int i = 0; i < 3; ++i)
+	{
+		if (!dxt1 || c0 > c1)
+		{
+			pal[2][i] = static_cast<uint8_t>((2 * pal[0][i] + pal[1][i]) / 3);
+			pal[3][i] = static_cast<uint8_t>((pal[0][i] + 2 * pal[1][i]) / 3);
+		}
+		else
+		{
+			//DXT1 three colour mode, the last one is see-through
+			pal[2][i] = static_cast<uint8_t>((pal[0][i] + pal[1][i]) / 2);
+			pal[3][i] = 0;
+		}
+	}
+	if (dxt1 && c0 <= c1)
+		pal[3][3] = 0;
+	uint32_t bits = Read32(pBlock + 4);
+	for (int p = 0; p < 16; ++p)
+		memcpy(pOut[p], pal[(bits >> (p * 2)) & 3], 4);
+}
+
+//DXT5 interpolated alpha
+static void DecodeAlphaBlock(const uint8_t* pBlock, uint8_t pOut[16][4])
+{
+	uint8_t a[8];
+	a[0] = pBlock[0];
+	a[1] = pBlock[1];
+	if (a[0] > a[1])
+	{
+		for (int i = 1; i < 7; ++i)
+			a[i + 1] = static_cast<uint8_t>(((7 - i) * a[0] + i * a[1]) / 7);
+	}
+	else
+	{
+		for (int i = 1; i < 5; ++i)
+			a[i + 1] = static_cast<uint8_t>(((5 - i) * a[0] + i * a[1]) / 5);
+		a[6] = 0;
+		a[7] = 255;
+	}
+	uint64_t bits = 0;
+	for (int i = 0; i < 6; ++i)
+		bits |= static_cast<uint64_t>(pBlock[2 + i]) << (8 * i);
+	for (int p = 0; p < 16; ++p)
+		pOut[p][3] = a[(bits >> (p * 3)) & 7];
+}
+
+static void DecodeBlocks(const uint8_t* pData, size_t numBytes, int dxt, Image& image)
+{
+	unsigned int bw = (image.width + 3) / 4, bh = (image.height + 3) / 4;
+	size_t blockBytes = dxt == 1 ? 8 : 16;
+	assert(numBytes >= bw * bh * blockBytes);
+	uint8_t px[16][4];
+	for (unsigned int by = 0; by < bh; ++by)
+	{
+		for (unsigned int bx = 0; bx < bw; ++bx)
+		{
+			const uint8_t* pBlock = pData + (by * bw + bx) * blockBytes;
+			if (dxt == 1)
+				DecodeColourBlock(pBlock, true, px);
+			else
+			{
+				DecodeColourBlock(pBlock + 8, false, px);
+				if (dxt == 3)
+				{
+					//explicit 4bit alpha
+					for (int p = 0; p < 16; ++p)
+						px[p][3] = static_cast<uint8_t>(((pBlock[p / 2] >> ((p & 1) * 4)) & 15) * 17);
+				}
+				else
+					DecodeAlphaBlock(pBlock, px);
+			}
+			for (int p = 0; p < 16; ++p)
+			{
+				unsigned int x = bx * 4 + (p & 3), y = by * 4 + p / 4;
+				if (x < image.width && y < image.height)
+					memcpy(&image.rgba[(y * image.width + x) * 4], px[p], 4);
+			}
+		}
+	}
+}
+
+//pull one channel out of a pixel using its bit mask and stretch it to 8 bits
+static uint8_t ExtractChannel(uint32_t pixel, uint32_t mask, uint8_t missing)
+{
+	if (!mask)
+		return missing;
+	int shift = 0;
+	while (!(mask & (1u << shift)))
+		++shift;
+	uint32_t max = mask >> shift;
+	return static_cast<uint8_t>(((pixel & mask) >> shift) * 255 / max);
+}
+
+bool DecodeDDS(const uint8_t* pBytes, size_t numBytes, Image& image, std::string* pError)
+{
+	if (numBytes < 128 || memcmp(pBytes, "DDS ", 4) != 0 || Read32(pBytes + 4) != 124)
+	{
+		SetError(pError, "not a dds file");
+		return false;
+	}
+	image.height = Read32(pBytes + 12);
+	image.width = Read32(pBytes + 16);
+	uint32_t pfFlags = Read32(pBytes + 80);
+	uint32_t fourCC = Read32(pBytes + 84);
+	uint32_t bitCount = Read32(pBytes + 88);
+	uint32_t masks[4]{ Read32(pBytes + 92), Read32(pBytes + 96), Read32(pBytes + 100), Read32(pBytes + 104) };
+	const uint8_t* pData = pBytes + 128;
+	int dxt = 0;
+	bool swapRB = false;
+	if (pfFlags & 0x4)	//DDPF_FOURCC
+	{
+		if (fourCC == Read32(reinterpret_cast<const uint8_t*>("DXT1")))
+			dxt = 1;
+		else if (fourCC == Read32(reinterpret_cast<const uint8_t*>("DXT2")) || fourCC == Read32(reinterpret_cast<const uint8_t*>("DXT3")))
+			dxt = 3;
+		else if (fourCC == Read32(reinterpret_cast<const uint8_t*>("DXT4")) || fourCC == Read32(reinterpret_cast<const uint8_t*>("DXT5")))
+			dxt = 5;
+		else if (fourCC == Read32(reinterpret_cast<const uint8_t*>("DX10")) && numBytes >= 148)
+		{
+			//the newer header just says which DXGI_FORMAT
+			pData += 20;
+			switch (Read32(pBytes + 128))
+			{
+			case 71: case 72: dxt = 1; break;
+			case 74: case 75: dxt = 3; break;
+			case 77: case 78: dxt = 5; break;
+			case 87: case 91:	//B8G8R8A8, the same with red and blue swapped
+				swapRB = true;
+				[[fallthrough]];
+			case 28: case 29:
+				bitCount = 32;
+				masks[0] = 0x000000ff; masks[1] = 0x0000ff00; masks[2] = 0x00ff0000; masks[3] = 0xff000000;
+				if (swapRB)
+					swap(masks[0], masks[2]);
+				pfFlags = 0x41;
+				break;
+			default:
+				SetError(pError, "unsupported DX10 dds format");
+				return false;
+			}
+		}
+		else
+		{
+			SetError(pError, "unsupported dds compression");
+			return false;
+		}
+	}
+	if (!(pfFlags & 0x1))	//DDPF_ALPHAPIXELS
+		masks[3] = 0;
+
+	size_t avail = numBytes - (pData - pBytes);
+	image.rgba.assign(static_cast<size_t>(image.width) * image.height * 4, 255);
+	if (dxt)
+	{
+		size_t need = ((image.width + 3) / 4) * ((image.height + 3) / 4) * (dxt == 1 ? 8 : 16);
+		if (avail < need)
+		{
+			SetError(pError, "dds file is too short");
+			return false;
+		}
+		DecodeBlocks(pData, avail, dxt, image);
+		return true;
+	}
+	if (!(pfFlags & 0x40) || (bitCount != 32 && bitCount != 24))	//DDPF_RGB
+	{
+		SetError(pError, "unsupported dds pixel format");
+		return false;
+	}
+	size_t bpp = bitCount / 8;
+	if (avail < static_cast<size_t>(image.width) * image.height * bpp)
+	{
+		SetError(pError, "dds file is too short");
+		return false;
+	}
+	for (size_t i = 0; i < static_cast<size_t>(image.width) * image.height; ++i)
+	{
+		uint32_t pixel = 0;
+		memcpy(&pixel, pData + i * bpp, bpp);
+		uint8_t* pOut = &image.rgba[i * 4];
+		for (int c = 0; c < 4; ++c)
+			pOut[c] = ExtractChannel(pixel, masks[c], 255);
+	}
+	return true;
+}
+
+//**************************************************************************************************
+//everything else goes through the windows imaging component
+
+#ifdef _WIN32
+template<typename T> static void SafeRelease(T*& p)
+{
+	if (p)
+		p->Release();
+	p = nullptr;
+}
+
+static bool ReadWIC(const std::string& fileName, Image& image, std::string* pError)
+{
+	//every thread that uses COM has to say so, the cooker runs jobs on lots of them
+	static thread_local bool sComReady = SUCCEEDED(CoInitializeEx(nullptr, COINIT_MULTITHREADED));
+	if (!sComReady)
+	{
+		SetError(pError, "COM would not start");
+		return false;
+	}
+	IWICImagingFactory* pFactory = nullptr;
+	IWICBitmapDecoder* pDecoder = nullptr;
+	IWICBitmapFrameDecode* pFrame = nullptr;
+	IWICFormatConverter* pConverter = nullptr;
+	wstring ws(fileName.begin(), fileName.end());
+	UINT w = 0, h = 0;
+	bool ok = SUCCEEDED(CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&pFactory))) &&
+		SUCCEEDED(pFactory->CreateDecoderFromFilename(ws.c_str(), nullptr, GENERIC_READ, WICDecodeMetadataCacheOnDemand, &pDecoder)) &&
+		SUCCEEDED(pDecoder->GetFrame(0, &pFrame)) &&
+		SUCCEEDED(pFactory->CreateFormatConverter(&pConverter)) &&
+		SUCCEEDED(pConverter->Initialize(pFrame, GUID_WICPixelFormat32bppRGBA, WICBitmapDitherTypeNone, nullptr, 0, WICBitmapPaletteTypeCustom)) &&
+		SUCCEEDED(pConverter->GetSize(&w, &h));
+	if (ok)
+	{
+		image.width = w;
+		image.height = h;
+		image.rgba.resize(static_cast<size_t>(w) * h * 4);
+		ok = SUCCEEDED(pConverter->CopyPixels(nullptr, w * 4, static_cast<UINT>(image.rgba.size()), image.rgba.data()));
+	}
+	SafeRelease(pConverter);
+	SafeRelease(pFrame);
+	SafeRelease(pDecoder);
+	SafeRelease(pFactory);
+	if (!ok)
+		SetError(pError, "WIC could not decode it");
+	return ok;
+}
+#endif
+
+bool ReadImage(const std::string& fileName, Image& image, std::string* pError)
+{
+	ifstream in(fileName, ios::binary);
+	if (!in)
+	{
+		SetError(pError, "cannot open");
+		return false;
+	}
+	vector<uint8_t> bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+	if (bytes.size() >= 4 && memcmp(bytes.data(), "DDS ", 4) == 0)
+		return DecodeDDS(bytes.data(), bytes.size(), image, pError);
+#ifdef _WIN32
+	return ReadWIC(fileName, image, pError);
+#else
+	SetError(pError, "only dds can be read without WIC");
+	return false;
+#endif
+}
+
+//**************************************************************************************************
+//resizing
+
+/*
+Shrink (or grow) one axis at a time. Each output pixel is the average of
+the source pixels it covers, partly covered ones count for the part that's
+covered. Works on premultiplied floats so colour is weighted by alpha.
+*/
+static void ResampleAxis(const vector<float>& src, unsigned int srcLen, unsigned int otherLen, bool alongX,
+	vector<float>& dst, unsigned int dstLen)
+{
+	dst.assign(static_cast<size_t>(dstLen) * otherLen * 4, 0.f);
+	double ratio = srcLen / (double)dstLen;
+	for (unsigned int d = 0; d < dstLen; ++d)
+	{
+		double start = d * ratio, end = (d + 1) * ratio;
+		if (ratio < 1)
+		{
+			//growing, just sample the middle of the pixel
+			start = (d + 0.5) * ratio;
+			end = start;
+		}
+		unsigned int s0 = static_cast<unsigned int>(start);
+		unsigned int s1 = static_cast<unsigned int>(ceil(end));
+		if (s1 <= s0)
+			s1 = s0 + 1;
+		if (s1 > srcLen)
+			s1 = srcLen;
+		for (unsigned int s = s0; s < s1; ++s)
+		{
+			double w = ratio < 1 ? 1.0 : (min<double>(s + 1, end) - max<double>(s, start)) / ratio;
+			if (w <= 0)
+				continue;
+			for (unsigned int o = 0; o < otherLen; ++o)
+			{
+				size_t si = alongX ? (static_cast<size_t>(o) * srcLen + s) : (static_cast<size_t>(s) * otherLen + o);
+				size_t di = alongX ? (static_cast<size_t>(o) * dstLen + d) : (static_cast<size_t>(d) * otherLen + o);
+				for (int c = 0; c < 4; ++c)
+					dst[di * 4 + c] += static_cast<float>(src[si * 4 + c] * w);
+			}
+		}
+	}
+}
+
+Image Resize(const Image& src, unsigned int width, unsigned int height)
+{
+	assert(!src.Empty() && width > 0 && height > 0);
+	size_t n = static_cast<size_t>(src.width) * src.height;
+	vector<float> pre(n * 4);
+	for (size_t i = 0; i < n; ++i)
+	{
+		float a = src.rgba[i * 4 + 3] / 255.f;
+		for (int c = 0; c < 3; ++c)
+			pre[i * 4 + c] = src.rgba[i * 4 + c] / 255.f * a;
+		pre[i * 4 + 3] = a;
+	}
+	vector<float> horiz, both;
+	ResampleAxis(pre, src.width, src.height, true, horiz, width);
+	ResampleAxis(horiz, src.height, width, false, both, height);
+
+	Image out;
+	out.width = width;
+	out.height = height;
+	out.rgba.resize(static_cast<size_t>(width) * height * 4);
+	for (size_t i = 0; i < static_cast<size_t>(width) * height; ++i)
+	{
+		float a = both[i * 4 + 3];
+		for (int c = 0; c < 3; ++c)
+		{
+			float v = a > 0 ? both[i * 4 + c] / a : 0.f;
+			out.rgba[i * 4 + c] = static_cast<uint8_t>(min(max(v, 0.f), 1.f) * 255.f + 0.5f);
+		}
+		out.rgba[i * 4 + 3] = static_cast<uint8_t>(min(max(a, 0.f), 1.f) * 255.f + 0.5f);
+	}
+	return out;
+}
+
+void BuildMips(const Image& top, std::vector<Image>& mips)
+{
+	mips.clear();
+	mips.push_back(top);
+	while (mips.back().width > 1 || mips.back().height > 1)
+	{
+		const Image& last = mips.back();
+		mips.push_back(Resize(last, max(1u, last.width / 2), max(1u, last.height / 2)));
+	}
+}
+
+//**************************************************************************************************
+//writing
+
+bool WriteDDS(const std::string& fileName, const std::vector<Image>& mips)
+{
+	assert(!mips.empty() && !mips[0].Empty());
+	ofstream out(fileName, ios::binary | ios::trunc);
+	if (!out)
+		return false;
+	uint32_t header[32] = {};
+	memcpy(&header[0], "DDS ", 4);
+	header[1] = 124;
+	header[2] = 0x1 | 0x2 | 0x4 | 0x8 | 0x1000 | (mips.size() > 1 ? 0x20000 : 0);	//caps, height, width, pitch, pixelformat, mipcount
+	header[3] = mips[0].height;
+	header[4] = mips[0].width;
+	header[5] = mips[0].width * 4;
+	header[7] = static_cast<uint32_t>(mips.size());
+	header[19] = 32;			//pixel format size
+	header[20] = 0x40 | 0x1;	//rgb with alpha
+	header[22] = 32;
+	header[23] = 0x00ff0000;
+	header[24] = 0x0000ff00;
+	header[25] = 0x000000ff;
+	header[26] = 0xff000000;
+	header[27] = 0x1000 | (mips.size() > 1 ? 0x8 | 0x400000 : 0);	//texture, complex, mipmap
+	out.write(reinterpret_cast<const char*>(header), sizeof(header));
+	vector<uint8_t> bgra;
+	for (auto& mip : mips)
+	{
+		bgra = mip.rgba;
+		for (size_t i = 0; i < bgra.size(); i += 4)
+			swap(bgra[i], bgra[i + 2]);
+		out.write(reinterpret_cast<const char*>(bgra.data()), bgra.size());
+	}
+	return out.good();
+}
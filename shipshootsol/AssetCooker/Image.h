@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+Just enough image handling to cook textures: load something, shrink it,
+build mips and write an uncompressed dds the game's loader understands.
+Pixels are always 8bit RGBA with straight (not premultiplied) alpha
+because that's how the game blends its sprites.
+*/
+struct Image
+{
+	unsigned int width = 0, height = 0;
+	std::vector<uint8_t> rgba;
+	bool Empty() const { return width == 0 || height == 0; }
+};
+
+//png, jpg, bmp, etc through WIC (windows only) and dds (uncompressed or DXT1/3/5) anywhere
+bool ReadImage(const std::string& fileName, Image& image, std::string* pError = nullptr);
+//dds only, the bytes are already in memory
+bool DecodeDDS(const uint8_t* pBytes, size_t numBytes, Image& image, std::string* pError = nullptr);
+//area average resize, colours are weighted by alpha so see-through pixels don't bleed dark fringes
+Image Resize(const Image& src, unsigned int width, unsigned int height);
+//the full chain down to 1x1, mips[0] is the image itself
+void BuildMips(const Image& top, std::vector<Image>& mips);
+//A8R8G8B8 with however many mips are given
+bool WriteDDS(const std::string& fileName, const std::vector<Image>& mips);
@@ -0,0 +1,59 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "Cooker.h"
+
+using namespace std;
+
+/*
+AssetCooker [recipe] [-j threads] [-force] [-root dir]
+Run it from the game's bin folder (or point -root at it), it reads
+cook.txt, cooks whatever changed into cooked/ and rewrites
+cooked/manifest.txt which the game loads at startup.
+*/
+int main(int argc, char* argv[])
+{
+	string recipe = "cook.txt", root = ".";
+	unsigned int numThreads = max(1u, thread::hardware_concurrency());
+	bool force = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		string arg = argv[i];
+		if (arg == "-j" && i + 1 < argc)
+			numThreads = max(1, stoi(argv[++i]));
+		else if (arg == "-force")
+			force = true;
+		else if (arg == "-root" && i + 1 < argc)
+			root = argv[++i];
+		else if (arg[0] != '-')
+			recipe = arg;
+		else
+		{
+			cout << "usage: AssetCooker [recipe] [-j threads] [-force] [-root dir]\n";
+			return 1;
+		}
+	}
+
+	Cooker cooker(root);
+	string error;
+	if (!cooker.LoadRecipe(recipe, &error))
+	{
+		cout << error << "\n";
+		return 1;
+	}
+	bool ok = cooker.Run(numThreads, force);
+	size_t numCooked = 0, numSkipped = 0, numFailed = 0;
+	for (auto& r : cooker.GetResults())
+	{
+		if (r.status == Cooker::Result::COOKED)
+			++numCooked;
+		else if (r.status == Cooker::Result::UP_TO_DATE)
+			++numSkipped;
+		else
+			++numFailed;
+	}
+	cout << numCooked << " cooked, " << numSkipped << " up to date, " << numFailed << " failed (" << numThreads << " threads)\n";
+	return ok ? 0 : 1;
+}
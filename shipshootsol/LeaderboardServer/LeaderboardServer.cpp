@@ -0,0 +1,220 @@
+#include <cassert>
+#include <algorithm>
+#include <filesystem>
+
+#include "LeaderboardServer.h"
+
+using namespace std;
+using namespace LeaderboardProtocol;
+
+LeaderboardServer::LeaderboardServer(const std::string& dataDir, size_t numShards, size_t topK)
+	: mDataDir(dataDir)
+{
+	assert(numShards > 0);
+	for (size_t i = 0; i < numShards; ++i)
+		mShards.push_back(make_unique<Shard>(topK));
+}
+
+LeaderboardServer::~LeaderboardServer()
+{
+	Stop();
+}
+
+bool LeaderboardServer::Start(const std::string& socketPath)
+{
+	error_code ec;
+	filesystem::create_directories(mDataDir, ec);
+	for (size_t i = 0; i < mShards.size(); ++i)
+	{
+		if (!mShards[i]->board.Open(mDataDir + "/shard" + to_string(i) + ".dat"))
+			return false;
+		mNextSeq = max<uint64_t>(mNextSeq, mShards[i]->board.GetNextSeq());
+	}
+	if (!mListen.Listen(socketPath))
+		return false;
+	mSocketPath = socketPath;
+	mRunning = true;
+	mAcceptThread = thread(&LeaderboardServer::AcceptLoop, this);
+	mSyncThread = thread(&LeaderboardServer::SyncLoop, this);
+	return true;
+}
+
+void LeaderboardServer::Stop()
+{
+	if (!mRunning.exchange(false))
+		return;
+	//a listening socket can't be woken the same way everywhere, but a connection always wakes it
+	LocalSocket wake;
+	wake.Connect(mSocketPath);
+	mAcceptThread.join();
+	mListen.Close();
+	{
+		lock_guard<mutex> lock(mClientLock);
+		for (auto& c : mClients)
+			c->sock.Shutdown();
+	}
+	for (auto& c : mClients)
+		c->thread.join();
+	mClients.clear();
+	mSyncWake.notify_one();
+	mSyncThread.join();
+	for (auto& s : mShards)
+		s->board.Close();
+}
+
+void LeaderboardServer::Submit(const LeaderboardProtocol::Score* pScores, size_t count, size_t shardHint)
+{
+	Shard& shard = *mShards[shardHint % mShards.size()];
+	lock_guard<mutex> lock(shard.lock);
+	for (size_t i = 0; i < count; ++i)
+		shard.board.Add(pScores[i].name, pScores[i].score, false, mNextSeq++);
+	shard.dirty = true;
+	mNumSubmitted += count;
+}
+
+void LeaderboardServer::GetTop(size_t n, std::vector<LeaderboardProtocol::Score>& top)
+{
+	//each shard's best n, the overall best n are somewhere in there, ties in the order they were submitted
+	vector<Leaderboard::Entry> all;
+	for (auto& s : mShards)
+	{
+		lock_guard<mutex> lock(s->lock);
+		size_t i = 0;
+		for (auto it = s->board.GetTop().begin(); it != s->board.GetTop().end() && i < n; ++it, ++i)
+			all.push_back(*it);
+	}
+	n = min(n, all.size());
+	partial_sort(all.begin(), all.begin() + n, all.end(), Leaderboard::Better());
+	top.resize(n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		top[i].name = all[i].name;
+		top[i].score = all[i].score;
+	}
+}
+
+uint64_t LeaderboardServer::GetRank(int32_t score, uint64_t* pTotal)
+{
+	uint64_t above = 0, total = 0;
+	for (auto& s : mShards)
+	{
+		lock_guard<mutex> lock(s->lock);
+		above += s->board.GetRank(score) - 1;
+		total += s->board.GetNumEntries();
+	}
+	if (pTotal)
+		*pTotal = total;
+	return above + 1;
+}
+
+size_t LeaderboardServer::GetNumClients()
+{
+	lock_guard<mutex> lock(mClientLock);
+	return mClients.size();
+}
+
+void LeaderboardServer::AcceptLoop()
+{
+	size_t shardHint = 0;
+	while (mRunning)
+	{
+		LocalSocket sock = mListen.Accept();
+		if (!sock.IsOpen())
+			continue;
+		Reap();
+		lock_guard<mutex> lock(mClientLock);
+		if (!mRunning)
+			break;
+		mClients.push_back(make_unique<Client>());
+		Client* pClient = mClients.back().get();
+		pClient->sock = move(sock);
+		pClient->thread = thread(&LeaderboardServer::ServeClient, this, pClient, shardHint++);
+	}
+}
+
+void LeaderboardServer::ServeClient(Client* pClient, size_t shardHint)
+{
+	MsgType type;
+	vector<uint8_t> body;
+	vector<Score> scores;
+	Writer reply;
+	while (Receive(pClient->sock, type, body))
+	{
+		Reader r(body);
+		reply.Clear();
+		MsgType replyType = FAIL;
+		if (type == SUBMIT)
+		{
+			uint16_t count;
+			bool ok = r.Get(count) && count <= MAX_BATCH;
+			scores.resize(ok ? count : 0);
+			for (size_t i = 0; ok && i < scores.size(); ++i)
+				ok = r.GetScore(scores[i]);
+			if (ok)
+			{
+				Submit(scores.data(), scores.size(), shardHint);
+				reply.Put(static_cast<uint32_t>(scores.size()));
+				replyType = SUBMIT_OK;
+			}
+		}
+		else if (type == TOP)
+		{
+			uint16_t n;
+			if (r.Get(n))
+			{
+				GetTop(n, scores);
+				reply.Put(static_cast<uint16_t>(scores.size()));
+				for (auto& s : scores)
+					reply.PutScore(s);
+				replyType = TOP_OK;
+			}
+		}
+		else if (type == RANK)
+		{
+			int32_t score;
+			if (r.Get(score))
+			{
+				uint64_t total;
+				reply.Put(GetRank(score, &total));
+				reply.Put(total);
+				replyType = RANK_OK;
+			}
+		}
+		if (!Send(pClient->sock, replyType, reply.GetBytes()) || replyType == FAIL)
+			break;
+	}
+	lock_guard<mutex> lock(mClientLock);
+	pClient->sock.Close();
+	pClient->done = true;
+}
+
+void LeaderboardServer::Reap()
+{
+	lock_guard<mutex> lock(mClientLock);
+	for (auto it = mClients.begin(); it != mClients.end();)
+	{
+		if ((*it)->done)
+		{
+			(*it)->thread.join();
+			it = mClients.erase(it);
+		}
+		else
+			++it;
+	}
+}
+
+void LeaderboardServer::SyncLoop()
+{
+	unique_lock<mutex> wait(mSyncLock);
+	while (mRunning)
+	{
+		mSyncWake.wait_for(wait, chrono::milliseconds(SYNC_MS));
+		for (auto& s : mShards)
+		{
+			lock_guard<mutex> lock(s->lock);
+			if (s->dirty)
+				s->board.Sync();
+			s->dirty = false;
+		}
+	}
+}
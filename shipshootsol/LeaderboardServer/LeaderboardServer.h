@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+
+#include "../ShipShoot/Leaderboard.h"
+#include "../ShipShoot/LocalSocket.h"
+#include "../ShipShoot/LeaderboardProtocol.h"
+
+/*
+One leaderboard shared by every game on the machine. Games connect over
+a local socket (see LeaderboardProtocol) and each connection gets its
+own thread. Scores are spread over a number of shards, each its own
+Leaderboard with its own lock and files, a connection always feeds the
+same shard so hundreds of clients rarely wait on each other. Top N and
+rank ask every shard and merge the answers. Every score gets its seq
+from one counter for the whole server, so equal scores come out of the
+merge in the order they were submitted whichever shards they're in.
+Journals are written without waiting for the disk and synced on a timer,
+a crash loses at most the last SYNC_MS of scores.
+*/
+class LeaderboardServer
+{
+public:
+	enum { SYNC_MS = 50 };
+	//dataDir - where the shard files go
+	//topK - names kept per shard, the most a TOP query can usefully ask for
+	LeaderboardServer(const std::string& dataDir, size_t numShards = 16, size_t topK = 100);
+	~LeaderboardServer();
+
+	//opens the shards and starts listening
+	bool Start(const std::string& socketPath);
+	//drops every client, syncs and compacts the shards
+	void Stop();
+
+	//what the connections call, usable directly too
+	void Submit(const LeaderboardProtocol::Score* pScores, size_t count, size_t shardHint);
+	void GetTop(size_t n, std::vector<LeaderboardProtocol::Score>& top);
+	uint64_t GetRank(int32_t score, uint64_t* pTotal = nullptr);
+	uint64_t GetNumSubmitted() const { return mNumSubmitted; }
+	size_t GetNumClients();
+private:
+	struct Shard
+	{
+		std::mutex lock;
+		Leaderboard board;
+		bool dirty = false;		//added to since the last sync
+		Shard(size_t topK) : board(topK) {}
+	};
+	struct Client
+	{
+		LocalSocket sock;
+		std::thread thread;
+		bool done = false;
+	};
+	void AcceptLoop();
+	void ServeClient(Client* pClient, size_t shardHint);
+	void SyncLoop();
+	//join any client threads that have finished
+	void Reap();
+
+	std::string mDataDir, mSocketPath;
+	std::vector<std::unique_ptr<Shard>> mShards;
+	LocalSocket mListen;
+	std::thread mAcceptThread, mSyncThread;
+	std::mutex mClientLock;
+	std::list<std::unique_ptr<Client>> mClients;
+	std::mutex mSyncLock;
+	std::condition_variable mSyncWake;
+	std::atomic<bool> mRunning{ false };
+	std::atomic<uint64_t> mNumSubmitted{ 0 };
+	std::atomic<uint64_t> mNextSeq{ 0 };	//taken under the shard's lock so each shard's seqs still only go up
+};
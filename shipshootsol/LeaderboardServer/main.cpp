@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LeaderboardServer.h"
+#include "../ShipShoot/LeaderboardClient.h"
+
+using namespace std;
+
+/*
+LeaderboardServer [-socket path] [-data dir] [-shards n]
+	runs until ctrl-c, the games find it at the same socket path
+LeaderboardServer -loadgen [-clients n] [-batches n] [-batch n] [-socket path]
+	hammers a server with submissions and reports throughput and latency,
+	a private one on a temporary socket and data dir unless -socket says
+	which running server to load instead
+*/
+static const char DEFAULT_SOCKET[] = "leaderboard.sock";
+
+static atomic<bool> sQuit{ false };
+
+static void OnSignal(int)
+{
+	sQuit = true;
+}
+
+static int RunServer(const string& socketPath, const string& dataDir, size_t numShards)
+{
+	LeaderboardServer server(dataDir, numShards);
+	if (!server.Start(socketPath))
+	{
+		cout << "cannot start on " << socketPath << "\n";
+		return 1;
+	}
+	cout << "listening on " << socketPath << ", data in " << dataDir << "\n";
+	signal(SIGINT, OnSignal);
+	signal(SIGTERM, OnSignal);
+	while (!sQuit)
+		this_thread::sleep_for(chrono::milliseconds(100));
+	server.Stop();
+	cout << server.GetNumSubmitted() << " scores submitted\n";
+	return 0;
+}
+
+static double Percentile(vector<double>& sorted, double percent)
+{
+	if (sorted.empty())
+		return 0;
+	size_t idx = min(sorted.size() - 1, static_cast<size_t>(percent / 100 * sorted.size()));
+	return sorted[idx];
+}
+
+//socketPath empty for a private server, so a real one's scores are never touched by accident
+static int RunLoadGen(const string& socketPath, int numClients, int numBatches, int batchSize)
+{
+	unique_ptr<LeaderboardServer> pServer;
+	string path = socketPath;
+	filesystem::path tempDir;
+	if (path.empty())
+	{
+		error_code ec;
+		tempDir = filesystem::temp_directory_path(ec) / ("leaderboard_loadgen_" + to_string(random_device()()));
+		filesystem::create_directories(tempDir, ec);
+		path = (tempDir / "loadgen.sock").string();
+		pServer = make_unique<LeaderboardServer>((tempDir / "data").string());
+		if (ec || !pServer->Start(path))
+		{
+			cout << "cannot start a server in " << tempDir.string() << "\n";
+			filesystem::remove_all(tempDir, ec);
+			return 1;
+		}
+		cout << "started a private server at " << path << "\n";
+	}
+	else
+	{
+		LeaderboardClient probe;
+		if (!probe.Connect(path))
+		{
+			cout << "no server at " << path << "\n";
+			return 1;
+		}
+	}
+
+	vector<vector<double>> latencies(numClients);
+	atomic<int> numFailed{ 0 };
+	vector<thread> clients;
+	auto start = chrono::steady_clock::now();
+	for (int c = 0; c < numClients; ++c)
+	{
+		clients.emplace_back([&, c]() {
+			LeaderboardClient client;
+			if (!client.Connect(path, 5000))
+			{
+				++numFailed;
+				return;
+			}
+			mt19937 rng(c);
+			string name = "LOAD" + to_string(c);
+			latencies[c].reserve(numBatches);
+			for (int b = 0; b < numBatches; ++b)
+			{
+				for (int i = 0; i < batchSize; ++i)
+					client.Queue(name, static_cast<int32_t>(rng() % 100000));
+				auto t0 = chrono::steady_clock::now();
+				if (!client.Flush())
+				{
+					++numFailed;
+					return;
+				}
+				latencies[c].push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count());
+			}
+		});
+	}
+	for (auto& t : clients)
+		t.join();
+	double sec = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	vector<double> all;
+	for (auto& l : latencies)
+		all.insert(all.end(), l.begin(), l.end());
+	sort(all.begin(), all.end());
+	double numScores = static_cast<double>(all.size()) * batchSize;
+	cout << numClients << " clients x " << numBatches << " batches x " << batchSize << " scores, " << numFailed << " clients failed\n";
+	cout << "  " << static_cast<uint64_t>(numScores / sec) << " submissions/sec over " << sec << "s\n";
+	cout << "  batch latency ms: p50 " << Percentile(all, 50) << "  p99 " << Percentile(all, 99) << "  max " << (all.empty() ? 0 : all.back()) << "\n";
+
+	//and the reads
+	LeaderboardClient client;
+	vector<LeaderboardProtocol::Score> top;
+	uint64_t rank = 0, total = 0;
+	auto t0 = chrono::steady_clock::now();
+	bool ok = client.Connect(path) && client.GetTop(10, top) && client.GetRank(50000, rank, total);
+	double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+	if (ok)
+		cout << "  top 10 + rank in " << ms << "ms, best " << (top.empty() ? 0 : top[0].score) << ", 50000 ranks " << rank << " of " << total << "\n";
+	if (pServer)
+	{
+		pServer->Stop();
+		pServer.reset();
+		error_code ec;
+		filesystem::remove_all(tempDir, ec);
+	}
+	return numFailed || !ok ? 1 : 0;
+}
+
+int main(int argc, char* argv[])
+{
+	string socketPath, dataDir = "leaderboard";
+	size_t numShards = 16;
+	bool loadGen = false;
+	int numClients = 200, numBatches = 200, batchSize = 32;
+	for (int i = 1; i < argc; ++i)
+	{
+		string arg = argv[i];
+		bool more = i + 1 < argc;
+		if (arg == "-socket" && more)
+			socketPath = argv[++i];
+		else if (arg == "-data" && more)
+			dataDir = argv[++i];
+		else if (arg == "-shards" && more)
+			numShards = max(1, stoi(argv[++i]));
+		else if (arg == "-loadgen")
+			loadGen = true;
+		else if (arg == "-clients" && more)
+			numClients = max(1, stoi(argv[++i]));
+		else if (arg == "-batches" && more)
+			numBatches = max(1, stoi(argv[++i]));
+		else if (arg == "-batch" && more)
+			batchSize = min(max(1, stoi(argv[++i])), static_cast<int>(LeaderboardProtocol::MAX_BATCH));
+		else
+		{
+			cout << "usage: LeaderboardServer [-socket path] [-data dir] [-shards n]\n"
+				"       LeaderboardServer -loadgen [-clients n] [-batches n] [-batch n] [-socket path]\n";
+			return 1;
+		}
+	}
+	if (loadGen)
+		return RunLoadGen(socketPath, numClients, numBatches, batchSize);
+	return RunServer(socketPath.empty() ? DEFAULT_SOCKET : socketPath, dataDir, numShards);
+}
@@ -0,0 +1,14 @@
+#include "RenderTypes.h"
+
+/*
+The portable build has nothing to draw with, so RenderProxy's D3D half
+(ShipShoot/RenderProxy.cpp in the game) does nothing here. Gameplay code
+that calls it, Formation::Render, still links.
+*/
+void RenderProxy::SetTex(const TexCache&, ID3D11ShaderResourceView&)
+{
+}
+
+void RenderProxy::Draw(DirectX::SpriteBatch&, const TexCache&) const
+{
+}
@@ -0,0 +1,208 @@
+#include <cstdlib>
+#include <cstdio>
+#include <new>
+#ifdef _WIN32
+#include <windows.h>
+#include <dbghelp.h>
+#else
+#include <execinfo.h>
+#endif
+
+#include "AllocTracker.h"
+
+using namespace std;
+
+const char* AllocTracker::GetTagName(AllocTag tag)
+{
+	static const char* names[NUM_TAGS]{ "other", "sim", "render", "audio", "input", "io" };
+	return tag < AllocTag::COUNT ? names[static_cast<int>(tag)] : "?";
+}
+
+void AllocTracker::EndFrame(bool steady)
+{
+	uint64_t total = GetNumAllocs();
+	mFrameAllocs = total - mLastAllocs;
+	mLastAllocs = total;
+	for (int i = 0; i < NUM_TAGS; ++i)
+	{
+		uint64_t tagTotal = mTagAllocs[i].load(memory_order_relaxed);
+		mFrameTagAllocs[i] = tagTotal - mLastTagAllocs[i];
+		mLastTagAllocs[i] = tagTotal;
+	}
+	mFrame.fetch_add(1, memory_order_relaxed);
+	if (!mCapturing)
+		return;
+	//only this thread captures so nothing else is touching them
+	uint64_t numCaptured = GetNumCaptured();
+	uint64_t frameAllocs = numCaptured - mFrameStartCaptured;
+	if (!steady)
+	{
+		for (uint64_t i = mFrameStartCaptured; i < numCaptured && i < MAX_CAPTURES; ++i)
+			mCaptures[i].ready = false;
+		mNumCaptured = mFrameStartCaptured;
+		return;
+	}
+	mFrameStartCaptured = numCaptured;
+	++mNumCapturedFrames;
+	if (frameAllocs)
+		++mNumAllocatingFrames;
+	if (frameAllocs > mWorstFrameAllocs)
+		mWorstFrameAllocs = frameAllocs;
+}
+
+void AllocTracker::StartCapture()
+{
+	mCapturing = false;
+	for (Capture& c : mCaptures)
+		c.ready = false;
+	mNumCaptured = 0;
+	mFrameStartCaptured = 0;
+	mNumCapturedFrames = mNumAllocatingFrames = mWorstFrameAllocs = 0;
+	IsCaptureThread() = true;
+	mCapturing = true;
+}
+
+void AllocTracker::CaptureStack(size_t numBytes, AllocTag tag)
+{
+	//in case walking the stack allocates
+	thread_local bool tInside = false;
+	if (tInside)
+		return;
+	uint64_t idx = mNumCaptured.fetch_add(1, memory_order_relaxed);
+	if (idx >= MAX_CAPTURES)
+		return;
+	tInside = true;
+	Capture& c = mCaptures[idx];
+	c.tag = tag;
+	c.frame = GetFrameNumber();
+	c.numBytes = numBytes;
+#ifdef _WIN32
+	c.depth = CaptureStackBackTrace(1, MAX_DEPTH, c.stack, nullptr);
+#else
+	c.depth = backtrace(c.stack, MAX_DEPTH);
+#endif
+	c.ready.store(true, memory_order_release);
+	tInside = false;
+}
+
+bool AllocTracker::WriteReport(const std::string& fileName) const
+{
+	FILE* pFile = fopen(fileName.c_str(), "w");
+	if (!pFile)
+		return false;
+	uint64_t numCaptured = GetNumCaptured();
+	fprintf(pFile, "%llu frames, %llu allocated, worst %llu allocations, %llu allocations in all\n",
+		(unsigned long long)mNumCapturedFrames, (unsigned long long)mNumAllocatingFrames,
+		(unsigned long long)mWorstFrameAllocs, (unsigned long long)numCaptured);
+#ifdef _WIN32
+	HANDLE process = GetCurrentProcess();
+	SymSetOptions(SYMOPT_UNDNAME | SYMOPT_LOAD_LINES | SYMOPT_DEFERRED_LOADS);
+	bool haveSymbols = SymInitialize(process, nullptr, TRUE) != FALSE;
+#endif
+	for (const Capture& c : mCaptures)
+	{
+		if (!c.ready.load(memory_order_acquire))
+			continue;
+		fprintf(pFile, "\nframe %llu, %zu bytes, %s\n", (unsigned long long)c.frame, c.numBytes, GetTagName(c.tag));
+#ifdef _WIN32
+		char symbolBuf[sizeof(SYMBOL_INFO) + 256];
+		SYMBOL_INFO* pSymbol = reinterpret_cast<SYMBOL_INFO*>(symbolBuf);
+		for (int i = 0; i < c.depth; ++i)
+		{
+			DWORD64 addr = reinterpret_cast<DWORD64>(c.stack[i]);
+			DWORD64 symbolOffset = 0;
+			DWORD lineOffset = 0;
+			pSymbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+			pSymbol->MaxNameLen = 255;
+			IMAGEHLP_LINE64 line{};
+			line.SizeOfStruct = sizeof(line);
+			if (!haveSymbols || !SymFromAddr(process, addr, &symbolOffset, pSymbol))
+				fprintf(pFile, "  %p\n", c.stack[i]);
+			else if (SymGetLineFromAddr64(process, addr, &lineOffset, &line))
+				fprintf(pFile, "  %s  %s(%lu)\n", pSymbol->Name, line.FileName, line.LineNumber);
+			else
+				fprintf(pFile, "  %s\n", pSymbol->Name);
+		}
+#else
+		//needs -rdynamic for names, addr2line gets the rest
+		char** ppNames = backtrace_symbols(c.stack, c.depth);
+		for (int i = 0; i < c.depth; ++i)
+			fprintf(pFile, "  %s\n", ppNames ? ppNames[i] : "?");
+		free(ppNames);
+#endif
+	}
+	if (numCaptured > MAX_CAPTURES)
+		fprintf(pFile, "\n%llu more not kept\n", (unsigned long long)(numCaptured - MAX_CAPTURES));
+#ifdef _WIN32
+	if (haveSymbols)
+		SymCleanup(process);
+#endif
+	bool ok = !ferror(pFile);
+	return fclose(pFile) == 0 && ok;
+}
+
+/*
+The replacement global operators. The array and nothrow forms all come
+through these by default so there's no need to replace those as well.
+*/
+static void* AlignedAlloc(size_t numBytes, size_t align)
+{
+#ifdef _WIN32
+	return _aligned_malloc(numBytes, align);
+#else
+	return aligned_alloc(align, (numBytes + align - 1) / align * align);
+#endif
+}
+
+static void AlignedFree(void* p)
+{
+#ifdef _WIN32
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
+
+void* operator new(size_t numBytes)
+{
+	void* p = malloc(numBytes ? numBytes : 1);
+	if (!p)
+		throw bad_alloc();
+	AllocTracker::Get().OnAlloc(numBytes);
+	return p;
+}
+
+void* operator new(size_t numBytes, align_val_t align)
+{
+	void* p = AlignedAlloc(numBytes ? numBytes : 1, static_cast<size_t>(align));
+	if (!p)
+		throw bad_alloc();
+	AllocTracker::Get().OnAlloc(numBytes);
+	return p;
+}
+
+void operator delete(void* p) noexcept
+{
+	if (!p)
+		return;
+	AllocTracker::Get().OnFree();
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	operator delete(p);
+}
+
+void operator delete(void* p, align_val_t) noexcept
+{
+	if (!p)
+		return;
+	AllocTracker::Get().OnFree();
+	AlignedFree(p);
+}
+
+void operator delete(void* p, size_t, align_val_t align) noexcept
+{
+	operator delete(p, align);
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <string>
+
+//which part of the game asked, see AllocScope
+enum class AllocTag : uint8_t { OTHER, SIM, RENDER, AUDIO, INPUT, IO, COUNT };
+
+/*
+Counts every allocation that goes through new and delete, from any
+thread, by replacing the global operators. Counting is a couple of
+relaxed atomic adds so it's always on. Each allocation is also counted
+against the tag of the AllocScope it happened in (OTHER outside any),
+and EndFrame, called once a frame, turns the running totals into the
+last frame's figures, which is what the perf overlay and the profiler
+show. Once the game has warmed up StartCapture records the call stack
+of every allocation (the first MAX_CAPTURES anyway) and which frames
+allocated at all, that's how -allocgate proves the steady state loop
+doesn't touch the heap. Only the thread that called StartCapture is
+watched, the main loop, the persist worker and the audio and profiler
+threads allocate on their own schedules and aren't part of a frame.
+Frames EndFrame is told aren't steady (the game changing mode) don't
+count and what they allocated is dropped. WriteReport saves what was
+caught.
+malloc called directly isn't seen, but nothing in the game does that.
+*/
+class AllocTracker
+{
+public:
+	enum { NUM_TAGS = static_cast<int>(AllocTag::COUNT), MAX_CAPTURES = 64, MAX_DEPTH = 24 };
+	struct Capture
+	{
+		std::atomic<bool> ready{ false };	//set once the rest is filled in
+		AllocTag tag;
+		uint64_t frame;
+		size_t numBytes;
+		int depth;
+		void* stack[MAX_DEPTH];
+	};
+
+	AllocTracker(AllocTracker const&) = delete;
+	void operator=(AllocTracker const&) = delete;
+	static AllocTracker& Get()
+	{
+		static AllocTracker instance;
+		return instance;
+	}
+	//called by the global new/delete, nobody else needs to
+	void OnAlloc(size_t numBytes)
+	{
+		mNumAllocs.fetch_add(1, std::memory_order_relaxed);
+		mNumBytes.fetch_add(numBytes, std::memory_order_relaxed);
+		AllocTag tag = GetTag();
+		mTagAllocs[static_cast<int>(tag)].fetch_add(1, std::memory_order_relaxed);
+		if (mCapturing.load(std::memory_order_relaxed) && IsCaptureThread())
+			CaptureStack(numBytes, tag);
+	}
+	void OnFree() { mNumFrees.fetch_add(1, std::memory_order_relaxed); }
+
+	//totals since the program started
+	uint64_t GetNumAllocs() const { return mNumAllocs.load(std::memory_order_relaxed); }
+	uint64_t GetNumFrees() const { return mNumFrees.load(std::memory_order_relaxed); }
+	uint64_t GetNumBytes() const { return mNumBytes.load(std::memory_order_relaxed); }
+	uint64_t GetNumAllocs(AllocTag tag) const { return mTagAllocs[static_cast<int>(tag)].load(std::memory_order_relaxed); }
+	//allocated and not yet freed
+	uint64_t GetNumLive() const { return GetNumAllocs() - GetNumFrees(); }
+
+	//what the calling thread's allocations count against
+	static AllocTag& GetTag()
+	{
+		thread_local AllocTag tag = AllocTag::OTHER;
+		return tag;
+	}
+	static const char* GetTagName(AllocTag tag);
+
+	//main thread, once a frame after it's been presented
+	//steady - false if the game set things up or tore them down, capturing ignores the frame
+	void EndFrame(bool steady = true);
+	//during the last frame, from every thread
+	uint64_t GetFrameAllocs() const { return mFrameAllocs; }
+	uint64_t GetFrameAllocs(AllocTag tag) const { return mFrameTagAllocs[static_cast<int>(tag)]; }
+	uint64_t GetFrameNumber() const { return mFrame.load(std::memory_order_relaxed); }
+
+	//from the start of the next frame, remember where this thread's allocations come from
+	void StartCapture();
+	void StopCapture() { mCapturing = false; IsCaptureThread() = false; }
+	//since StartCapture, steady frames seen and how many of them allocated
+	uint64_t GetNumCapturedFrames() const { return mNumCapturedFrames; }
+	uint64_t GetNumAllocatingFrames() const { return mNumAllocatingFrames; }
+	uint64_t GetWorstFrameAllocs() const { return mWorstFrameAllocs; }
+	//allocations in the frames counted, including any past MAX_CAPTURES that weren't kept
+	uint64_t GetNumCaptured() const { return mNumCaptured.load(std::memory_order_relaxed); }
+	//counts and every kept stack, symbols resolved where the platform can
+	bool WriteReport(const std::string& fileName) const;
+private:
+	std::atomic<uint64_t> mNumAllocs{ 0 }, mNumFrees{ 0 }, mNumBytes{ 0 };
+	std::atomic<uint64_t> mTagAllocs[NUM_TAGS] = {};
+	//per frame, main thread only
+	std::atomic<uint64_t> mFrame{ 0 };
+	uint64_t mLastAllocs = 0, mFrameAllocs = 0;
+	uint64_t mLastTagAllocs[NUM_TAGS] = {}, mFrameTagAllocs[NUM_TAGS] = {};
+	//capturing
+	std::atomic<bool> mCapturing{ false };
+	std::atomic<uint64_t> mNumCaptured{ 0 };
+	uint64_t mFrameStartCaptured = 0;	//mNumCaptured when this frame started
+	uint64_t mNumCapturedFrames = 0, mNumAllocatingFrames = 0, mWorstFrameAllocs = 0;
+	Capture mCaptures[MAX_CAPTURES];
+
+	AllocTracker() {}
+	static bool& IsCaptureThread()
+	{
+		thread_local bool capture = false;
+		return capture;
+	}
+	void CaptureStack(size_t numBytes, AllocTag tag);
+};
+
+/*
+Allocations made by this thread while it's alive count against tag,
+scopes inside scopes put the outer tag back when they end.
+*/
+class AllocScope
+{
+public:
+	explicit AllocScope(AllocTag tag) : mPrevTag(AllocTracker::GetTag()) { AllocTracker::GetTag() = tag; }
+	~AllocScope() { AllocTracker::GetTag() = mPrevTag; }
+	AllocScope(const AllocScope&) = delete;
+	void operator=(const AllocScope&) = delete;
+private:
+	AllocTag mPrevTag;
+};
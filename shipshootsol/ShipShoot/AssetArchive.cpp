@@ -0,0 +1,278 @@
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "AssetArchive.h"
+
+using namespace std;
+
+bool AssetArchive::Open(const std::string& fileName)
+{
+	Close();
+#ifdef _WIN32
+	HANDLE hFile = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER size;
+	HANDLE hMapping = nullptr;
+	if (GetFileSizeEx(hFile, &size) && size.QuadPart > 0)
+		hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	void* pView = hMapping ? MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!pView)
+	{
+		if (hMapping)
+			CloseHandle(hMapping);
+		CloseHandle(hFile);
+		return false;
+	}
+	mhFile = hFile;
+	mhMapping = hMapping;
+	mpBase = static_cast<const uint8_t*>(pView);
+	mSize = static_cast<size_t>(size.QuadPart);
+#else
+	int fd = open(fileName.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	void* pView = MAP_FAILED;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+		pView = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	//the mapping keeps the file alive on its own
+	close(fd);
+	if (pView == MAP_FAILED)
+		return false;
+	mpBase = static_cast<const uint8_t*>(pView);
+	mSize = static_cast<size_t>(st.st_size);
+#endif
+
+	//check it's one of ours and everything it points at is inside the file
+	Header h;
+	bool ok = mSize >= sizeof(Header);
+	if (ok)
+	{
+		memcpy(&h, mpBase, sizeof(h));
+		ok = memcmp(h.magic, "SSPK", 4) == 0 && h.version == VERSION &&
+			sizeof(Header) + (uint64_t)h.numEntries * sizeof(Entry) + h.namesBytes <= mSize;
+	}
+	if (ok)
+	{
+		mNumEntries = h.numEntries;
+		mpEntries = reinterpret_cast<const Entry*>(mpBase + sizeof(Header));
+		mpNames = reinterpret_cast<const char*>(mpEntries + mNumEntries);
+		for (uint32_t i = 0; i < mNumEntries && ok; ++i)
+		{
+			const Entry& e = mpEntries[i];
+			ok = e.offset + e.size <= mSize && (uint64_t)e.nameOffset + e.nameLen <= h.namesBytes;
+		}
+	}
+	if (!ok)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void AssetArchive::Close()
+{
+	if (!mpBase)
+		return;
+#ifdef _WIN32
+	UnmapViewOfFile(mpBase);
+	CloseHandle(mhMapping);
+	CloseHandle(mhFile);
+	mhMapping = mhFile = nullptr;
+#else
+	munmap(const_cast<uint8_t*>(mpBase), mSize);
+#endif
+	mpBase = nullptr;
+	mSize = 0;
+	mpEntries = nullptr;
+	mNumEntries = 0;
+	mpNames = nullptr;
+}
+
+std::string AssetArchive::Normalise(const std::string& path)
+{
+	string s;
+	s.reserve(path.size());
+	for (char c : path)
+	{
+		if (c == '\\')
+			c = '/';
+		else if (c >= 'A' && c <= 'Z')
+			c = c - 'A' + 'a';
+		//no doubled up slashes
+		if (c == '/' && (s.empty() || s.back() == '/'))
+			continue;
+		s += c;
+		if (s == "./")
+			s.clear();
+	}
+	return s;
+}
+
+//64bit FNV-1a of the normalised path
+uint64_t AssetArchive::Hash(const std::string& path)
+{
+	string s = Normalise(path);
+	uint64_t h = 14695981039346656037ull;
+	for (unsigned char c : s)
+	{
+		h ^= c;
+		h *= 1099511628211ull;
+	}
+	return h;
+}
+
+AssetArchive::Slice AssetArchive::Find(const std::string& path) const
+{
+	Slice slice;
+	if (!mpBase)
+		return slice;
+	uint64_t hash = Hash(path);
+	const Entry* pEnd = mpEntries + mNumEntries;
+	const Entry* p = lower_bound(mpEntries, pEnd, hash, [](const Entry& e, uint64_t h) { return e.hash < h; });
+	if (p == pEnd || p->hash != hash)
+		return slice;
+	//a 64bit hash clash is very unlikely, but make sure
+	if (GetName(*p) != Normalise(path))
+		return slice;
+	slice.pData = mpBase + p->offset;
+	slice.size = p->size;
+	return slice;
+}
+
+void AssetArchive::List(const std::string& folder, const std::string& ext, std::vector<std::string>& paths) const
+{
+	paths.clear();
+	if (!mpBase)
+		return;
+	string dir = Normalise(folder);
+	if (!dir.empty() && dir.back() != '/')
+		dir += '/';
+	string e = Normalise(ext);
+	//the index is in hash order, the names block is in the order things were packed
+	vector<const Entry*> found;
+	for (uint32_t i = 0; i < mNumEntries; ++i)
+	{
+		const Entry& en = mpEntries[i];
+		string name = GetName(en);
+		if (name.size() <= dir.size() + e.size() || name.compare(0, dir.size(), dir) != 0 ||
+			name.compare(name.size() - e.size(), e.size(), e) != 0)
+			continue;
+		//only this folder, not ones inside it
+		if (name.find('/', dir.size()) != string::npos)
+			continue;
+		found.push_back(&en);
+	}
+	sort(found.begin(), found.end(), [](const Entry* a, const Entry* b) { return a->nameOffset < b->nameOffset; });
+	for (auto* p : found)
+		paths.push_back(GetName(*p));
+}
+
+bool AssetArchive::Pack(const std::vector<std::string>& folders, const std::vector<std::string>& exts, const std::string& outFile,
+	size_t* pNumFiles)
+{
+	namespace fs = std::filesystem;
+	struct Item
+	{
+		string name;
+		fs::path path;
+		Entry entry;
+	};
+	vector<Item> items;
+	for (auto& folder : folders)
+	{
+		error_code ec;
+		if (!fs::is_directory(folder, ec))
+			continue;
+		//sorted so the same files always give the same archive
+		vector<fs::path> files;
+		for (auto& de : fs::recursive_directory_iterator(folder, ec))
+		{
+			if (de.is_regular_file())
+				files.push_back(de.path());
+		}
+		sort(files.begin(), files.end());
+		for (auto& f : files)
+		{
+			string ext = Normalise(f.extension().string());
+			if (find(exts.begin(), exts.end(), ext) == exts.end())
+				continue;
+			Item item;
+			item.name = Normalise(f.generic_string());
+			item.path = f;
+			memset(&item.entry, 0, sizeof(Entry));
+			item.entry.hash = Hash(item.name);
+			items.push_back(item);
+		}
+	}
+
+	//names go in pack order, data after them
+	string names;
+	for (auto& item : items)
+	{
+		item.entry.nameOffset = static_cast<uint32_t>(names.size());
+		item.entry.nameLen = static_cast<uint32_t>(item.name.size());
+		names += item.name;
+	}
+	uint64_t at = sizeof(Header) + items.size() * sizeof(Entry) + names.size();
+	vector<vector<char>> blobs(items.size());
+	for (size_t i = 0; i < items.size(); ++i)
+	{
+		ifstream in(items[i].path, ios::binary);
+		if (!in)
+			return false;
+		blobs[i].assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+		at = (at + ALIGN - 1) & ~uint64_t(ALIGN - 1);
+		items[i].entry.offset = at;
+		items[i].entry.size = static_cast<uint32_t>(blobs[i].size());
+		at += blobs[i].size();
+	}
+
+	vector<Entry> index;
+	for (auto& item : items)
+		index.push_back(item.entry);
+	sort(index.begin(), index.end(), [](const Entry& a, const Entry& b) { return a.hash < b.hash; });
+	for (size_t i = 1; i < index.size(); ++i)
+	{
+		//two paths with the same hash, we'd never find one of them
+		if (index[i].hash == index[i - 1].hash)
+			return false;
+	}
+
+	ofstream out(outFile, ios::binary | ios::trunc);
+	if (!out)
+		return false;
+	Header h;
+	memcpy(h.magic, "SSPK", 4);
+	h.version = VERSION;
+	h.numEntries = static_cast<uint32_t>(index.size());
+	h.namesBytes = static_cast<uint32_t>(names.size());
+	out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+	out.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(Entry));
+	out.write(names.data(), names.size());
+	for (size_t i = 0; i < items.size(); ++i)
+	{
+		uint64_t pos = static_cast<uint64_t>(out.tellp());
+		assert(pos <= items[i].entry.offset);
+		while (pos++ < items[i].entry.offset)
+			out.put(0);
+		out.write(blobs[i].data(), blobs[i].size());
+	}
+	if (pNumFiles)
+		*pNumFiles = items.size();
+	return out.good();
+}
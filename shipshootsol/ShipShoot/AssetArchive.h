@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+All the game's assets packed into one file so startup is one open and
+one map instead of a file open (and folder scan) per texture and sound.
+	header	- magic, version, entry count
+	index	- one entry per file sorted by the hash of its path
+	names	- the paths, so folders can still be listed
+	data	- the files themselves, each 16 byte aligned
+The whole thing is memory mapped and never copied, Find hands out
+pointers straight into the mapping which stay valid until Close.
+Paths are case insensitive and either slash works, "data/ship.dds" and
+"DATA\Ship.dds" are the same file. If there's no archive everything
+falls back to loose files, which is what you want while developing.
+*/
+class AssetArchive
+{
+public:
+	//a file inside the archive
+	struct Slice
+	{
+		const uint8_t* pData = nullptr;
+		size_t size = 0;
+		explicit operator bool() const { return pData != nullptr; }
+	};
+
+	AssetArchive(AssetArchive const&) = delete;
+	void operator=(AssetArchive const&) = delete;
+	static AssetArchive& Get()
+	{
+		static AssetArchive instance;
+		return instance;
+	}
+	~AssetArchive() { Close(); }
+
+	bool Open(const std::string& fileName);
+	void Close();
+	bool IsOpen() const { return mpBase != nullptr; }
+	//binary search of the index, empty slice if it isn't there
+	Slice Find(const std::string& path) const;
+	//every file directly inside a folder with this extension (e.g. "sfx", ".wav")
+	//gives back full archive paths, in the order they were packed
+	void List(const std::string& folder, const std::string& ext, std::vector<std::string>& paths) const;
+	size_t GetNumFiles() const { return mNumEntries; }
+
+	//lower case, forward slashes, no leading "./"
+	static std::string Normalise(const std::string& path);
+	static uint64_t Hash(const std::string& path);
+	//pack every file under each folder (relative to the current folder) whose
+	//extension is in the list into one archive, returns false if anything failed
+	static bool Pack(const std::vector<std::string>& folders, const std::vector<std::string>& exts, const std::string& outFile,
+		size_t* pNumFiles = nullptr);
+private:
+	struct Header
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t numEntries;
+		uint32_t namesBytes;
+	};
+	struct Entry
+	{
+		uint64_t hash;
+		uint64_t offset;	//from the start of the archive
+		uint32_t size;
+		uint32_t nameOffset;	//into the names block
+		uint32_t nameLen;
+		uint32_t pad;
+	};
+	enum { VERSION = 1, ALIGN = 16 };
+
+	const uint8_t* mpBase = nullptr;
+	size_t mSize = 0;
+	const Entry* mpEntries = nullptr;
+	uint32_t mNumEntries = 0;
+	const char* mpNames = nullptr;
+#ifdef _WIN32
+	void* mhFile = nullptr;
+	void* mhMapping = nullptr;
+#endif
+
+	AssetArchive() {}
+	std::string GetName(const Entry& e) const { return std::string(mpNames + e.nameOffset, e.nameLen); }
+};
@@ -0,0 +1,81 @@
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+#include "AssetManifest.h"
+#include "AssetArchive.h"
+
+using namespace std;
+
+bool AssetManifest::Load(const std::string& fileName)
+{
+	string text;
+	AssetArchive::Slice slice = AssetArchive::Get().Find(fileName);
+	if (slice)
+		text.assign(reinterpret_cast<const char*>(slice.pData), slice.size);
+	else
+	{
+		ifstream in(fileName, ios::binary);
+		if (!in)
+			return false;
+		text.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+	}
+
+	mEntries.clear();
+	istringstream lines(text);
+	string line;
+	while (getline(lines, line))
+	{
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		if (line.empty() || line[0] == '#')
+			continue;
+		istringstream fields(line);
+		Entry e;
+		string w, h, hash;
+		if (!getline(fields, e.source, '\t') || !getline(fields, e.cooked, '\t') || !getline(fields, e.kind, '\t') ||
+			!getline(fields, w, '\t') || !getline(fields, h, '\t') || !getline(fields, hash, '\t'))
+			return false;
+		e.width = stoul(w);
+		e.height = stoul(h);
+		e.hash = stoull(hash, nullptr, 16);
+		Set(e);
+	}
+	return true;
+}
+
+bool AssetManifest::Save(const std::string& fileName) const
+{
+	ofstream out(fileName, ios::binary | ios::trunc);
+	if (!out)
+		return false;
+	out << "#source\tcooked\tkind\twidth\theight\thash\n";
+	for (auto& it : mEntries)
+	{
+		const Entry& e = it.second;
+		out << e.source << '\t' << e.cooked << '\t' << e.kind << '\t' << e.width << '\t' << e.height << '\t'
+			<< hex << setw(16) << setfill('0') << e.hash << dec << '\n';
+	}
+	return out.good();
+}
+
+const AssetManifest::Entry* AssetManifest::Find(const std::string& path) const
+{
+	if (mEntries.empty())
+		return nullptr;
+	auto it = mEntries.find(AssetArchive::Normalise(path));
+	return it == mEntries.end() ? nullptr : &it->second;
+}
+
+void AssetManifest::Set(const Entry& entry)
+{
+	Entry e = entry;
+	e.source = AssetArchive::Normalise(e.source);
+	mEntries[e.source] = e;
+}
+
+const std::string& AssetManifest::Resolve(const std::string& path) const
+{
+	const Entry* p = Find(path);
+	return p ? p->cooked : path;
+}
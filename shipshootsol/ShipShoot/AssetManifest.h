@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <map>
+
+/*
+The list the asset cooker writes of everything it made. The game still
+asks for assets by their usual names ("data/ship.dds", "sfx/bang.wav")
+and the manifest says which cooked file to load instead. Textures also
+remember the size the game thinks they are, so a sprite cooked down to
+the size it's drawn at still lines up with all the frame rectangles and
+scales the game code uses.
+One line per asset, tab separated:
+	source	cooked	kind	width	height	hash
+*/
+class AssetManifest
+{
+public:
+	struct Entry
+	{
+		std::string source;		//what the game asks for
+		std::string cooked;		//what to load instead
+		std::string kind;		//texture, sprite, sound
+		unsigned int width = 0, height = 0;	//size before cooking, images only
+		uint64_t hash = 0;		//of everything that went into cooking it
+	};
+
+	//the one the game uses, the cooker makes its own
+	static AssetManifest& Get()
+	{
+		static AssetManifest instance;
+		return instance;
+	}
+
+	//reads from the asset archive if it's in there
+	bool Load(const std::string& fileName);
+	bool Save(const std::string& fileName) const;
+	void Clear() { mEntries.clear(); }
+	//nullptr if it wasn't cooked
+	const Entry* Find(const std::string& path) const;
+	void Set(const Entry& entry);
+	const std::map<std::string, Entry>& GetEntries() const { return mEntries; }
+	//the file to actually load
+	const std::string& Resolve(const std::string& path) const;
+private:
+	std::map<std::string, Entry> mEntries;	//by normalised source path
+};
@@ -0,0 +1,84 @@
+#include <cassert>
+
+#include "AudioLatency.h"
+#include "Stats.h"
+
+AudioLatencyProbe::AudioLatencyProbe()
+	: mPickupHist(Stats::Get().GetHistogram("audio_pickup_ms")),
+	mLatencyHist(Stats::Get().GetHistogram("audio_latency_ms"))
+{
+}
+
+int AudioLatencyProbe::Find(unsigned int channelHandle) const
+{
+	for (unsigned int i = 0; i < mNumPending; ++i)
+	{
+		if (mPending[i].channelHandle == channelHandle)
+			return static_cast<int>(i);
+	}
+	return -1;
+}
+
+//order doesn't matter so just move the last one into the gap
+void AudioLatencyProbe::Remove(unsigned int idx)
+{
+	assert(idx < mNumPending);
+	mPending[idx] = mPending[--mNumPending];
+}
+
+void AudioLatencyProbe::OnTrigger(unsigned int channelHandle, unsigned int soundIdx, double sec)
+{
+	if (mNumPending == MAX_PENDING)
+	{
+		++mNumDropped;
+		return;
+	}
+	Record& rec = mPending[mNumPending++];
+	rec = Record();
+	rec.channelHandle = channelHandle;
+	rec.soundIdx = soundIdx;
+	rec.triggerSec = sec;
+}
+
+void AudioLatencyProbe::OnPickup(unsigned int channelHandle, double sec, uint64_t bufferIdx, unsigned int frameOffset)
+{
+	int idx = Find(channelHandle);
+	if (idx < 0 || mPending[idx].pickedUp)
+		return;
+	Record& rec = mPending[idx];
+	rec.pickedUp = true;
+	rec.pickupSec = sec;
+	rec.bufferIdx = bufferIdx;
+	rec.frameOffset = frameOffset;
+	mPickupHist.Add((rec.pickupSec - rec.triggerSec) * 1000.0);
+}
+
+void AudioLatencyProbe::OnBufferOut(uint64_t bufferIdx, double startSec, double secPerFrame)
+{
+	//going backwards so removing doesn't skip anything
+	for (int i = static_cast<int>(mNumPending) - 1; i >= 0; --i)
+	{
+		Record& rec = mPending[i];
+		if (!rec.pickedUp || rec.bufferIdx != bufferIdx)
+			continue;
+		rec.audibleSec = startSec + rec.frameOffset * secPerFrame;
+		mLatencyHist.Add((rec.audibleSec - rec.triggerSec) * 1000.0);
+		++mNumMeasured;
+		if (mpListener)
+			mpListener->OnLatency(rec);
+		Remove(i);
+	}
+}
+
+void AudioLatencyProbe::Cancel(unsigned int channelHandle)
+{
+	int idx = Find(channelHandle);
+	if (idx >= 0)
+		Remove(idx);
+}
+
+bool AudioLatencyProbe::IsWaitingForPickup(unsigned int channelHandle) const
+{
+	int idx = Find(channelHandle);
+	return idx >= 0 && !mPending[idx].pickedUp;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <climits>
+
+class Histogram;
+
+/*
+Measures how long it takes from asking for a sound to hearing it.
+Each trigger is followed through three moments:
+	trigger	- Play was called
+	pickup	- the mixer started reading the sound, plus which output buffer
+			  (and how far into it) the first sample landed in
+	audible	- when that buffer's first frame reaches the speakers, the
+			  output side reports this per buffer
+Times are seconds on whatever clock the audio manager runs on, wall clock
+for fmod, the virtual clock when rendering offline. Finished measurements
+go into the "audio_pickup_ms" and "audio_latency_ms" stats histograms.
+Nothing here allocates, triggers wait in a fixed table.
+*/
+class AudioLatencyProbe
+{
+public:
+	enum { MAX_PENDING = 256 };
+	struct Record
+	{
+		unsigned int channelHandle = UINT_MAX;
+		unsigned int soundIdx = 0;
+		double triggerSec = 0;
+		double pickupSec = 0;
+		double audibleSec = 0;
+		uint64_t bufferIdx = 0;
+		unsigned int frameOffset = 0;
+		bool pickedUp = false;
+	};
+	//anything that wants to see each finished measurement
+	class IListener
+	{
+	public:
+		virtual ~IListener() {}
+		virtual void OnLatency(const Record& rec) = 0;
+	};
+
+	AudioLatencyProbe();
+	void SetListener(IListener* pListener) { mpListener = pListener; }
+	//Play was called
+	void OnTrigger(unsigned int channelHandle, unsigned int soundIdx, double sec);
+	//the mixer has started reading the sound
+	void OnPickup(unsigned int channelHandle, double sec, uint64_t bufferIdx, unsigned int frameOffset);
+	//an output buffer went out, frame 0 of it will be heard at startSec
+	void OnBufferOut(uint64_t bufferIdx, double startSec, double secPerFrame);
+	//the channel stopped before anyone heard it
+	void Cancel(unsigned int channelHandle);
+
+	//for mixers that have to go looking for what's been picked up
+	unsigned int GetNumPending() const { return mNumPending; }
+	const Record& GetPending(unsigned int idx) const { return mPending[idx]; }
+	bool IsWaitingForPickup(unsigned int channelHandle) const;
+
+	uint64_t GetNumMeasured() const { return mNumMeasured; }
+	//triggers we lost track of because the table was full
+	uint64_t GetNumDropped() const { return mNumDropped; }
+private:
+	Record mPending[MAX_PENDING];
+	unsigned int mNumPending = 0;
+	uint64_t mNumMeasured = 0;
+	uint64_t mNumDropped = 0;
+	IListener* mpListener = nullptr;
+	Histogram& mPickupHist;
+	Histogram& mLatencyHist;
+
+	int Find(unsigned int channelHandle) const;
+	void Remove(unsigned int idx);
+};
@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "FileUtils.h"
+#include "AudioLatency.h"
 
 class IAudioMgr;
 
@@ -105,7 +106,10 @@ public:
 	IAudioGroup * const GetSfxMgr() { return m_pSfxMgr; }
 	///see if this handle has already been started once this frame
 	static bool CheckDuplicates( const unsigned int handle );
+	///trigger to output latency of every sound played, times are on this manager's clock
+	AudioLatencyProbe &GetLatencyProbe() { return m_probe; }
 protected:
+	AudioLatencyProbe m_probe;
 	IAudioGroup *m_pSongMgr;	//streamed audio
 	IAudioGroup *m_pSfxMgr;		//memory loaded audio, small clips
 	static std::vector<unsigned int> s_hdlStartedNow;	///<we shouldn't have the same handle starting more than once in a frame
@@ -2,13 +2,21 @@
 #include <string.h>
 #include <stdio.h>
 #include <fstream>
+#include <memory>
 #include <assert.h>
 
+#include <windows.h>
+
 #include "fmod.hpp"
 #include "fmod_errors.h"
 #include "FileUtils.h"
 #include "AudioMgrFMOD.h"
+#include "AssetArchive.h"
+#include "AssetManifest.h"
 #include "D3DUtil.h"
+#include "Clock.h"
+#include "Profiler.h"
+#include "AllocTracker.h"
 
 using namespace std;
 
@@ -29,12 +37,12 @@ public:
 	//move the file pointer to read data from a different offset in the file
 	static FMOD_RESULT F_CALLBACK userSeek( void *  handle, unsigned int  pos, void *  userdata );
 	//keep a single array of file handle to open files, if its streaming
-	//it will stay open a long time
-	static vector<File *> s_openFiles;
+	//it will stay open a long time, the handle fmod gets is the index
+	static vector<unique_ptr<File>> s_openFiles;
 };
 
 
-vector<File *> FileBridge::s_openFiles;
+vector<unique_ptr<File>> FileBridge::s_openFiles;
 
 /*
 Callback functions - we create a function because we know
@@ -54,19 +62,19 @@ FMOD_RESULT F_CALLBACK FileBridge::userOpen(
 	//utf8string folder;
 	//File::getCurrentFolder(folder);
 	//DBOUT("Loading file:" << name << " from path:" << folder);
-	File *pF = new File(name, File::MPF_READ);
+	auto pF = make_unique<File>(name, File::MPF_READ);
 	*filesize = pF->getSize();
 	size_t i;
 	for (i = 0; i < s_openFiles.size(); ++i)
 	{
-		if (s_openFiles[i] == 0)
+		if (!s_openFiles[i])
 		{
-			s_openFiles[i] = pF;
+			s_openFiles[i] = move(pF);
 			break;
 		}
 	}
-	if (s_openFiles.empty() || i == s_openFiles.size())
-		s_openFiles.push_back(pF);
+	if (i == s_openFiles.size())
+		s_openFiles.push_back(move(pF));
 
 	*handle = (void*)i;
 
@@ -86,10 +94,8 @@ FMOD_RESULT F_CALLBACK FileBridge::userClose(
 	//s_openFiles[(size_t)handle] = 0;
 	//return FMOD_OK;
 	//close an already open file
-	File *pF = s_openFiles[(size_t)handle];
-	pF->close();
-	delete pF;
-	s_openFiles[(size_t)handle] = 0;
+	//the destructor closes it
+	s_openFiles[(size_t)handle].reset();
 	return FMOD_OK;
 }
 
@@ -110,7 +116,7 @@ FMOD_RESULT F_CALLBACK FileBridge::userRead(
 	//*bytesread = sizebytes;
 	//return FMOD_OK;
 	//just read a few bytes from an open file
-	File *pF = s_openFiles[(size_t)handle];
+	File *pF = s_openFiles[(size_t)handle].get();
 	pF->read(buffer, sizebytes, *bytesread);
 	if (sizebytes > *bytesread)
 		return FMOD_ERR_FILE_EOF;
@@ -130,7 +136,7 @@ FMOD_RESULT F_CALLBACK FileBridge::userSeek(
 	//assert(!pF->bad());
 	//return FMOD_OK;
 
-	File *pF = s_openFiles[(size_t)handle];
+	File *pF = s_openFiles[(size_t)handle].get();
 	pF->seek(pos);
 	return FMOD_OK;
 }
@@ -141,7 +147,7 @@ unsigned int AudioGroupFMOD::m_uniqueChannelCounter(0);
 
 
 AudioMgrFMOD::AudioMgrFMOD() 
-	: m_pSystem(NULL), IAudioMgr()
+	: m_pSystem(NULL), IAudioMgr(), m_dspBufferLen(1024), m_dspNumBuffers(4), m_mixRate(48000)
 {
 
 }
@@ -235,6 +241,11 @@ bool AudioMgrFMOD::InitFMOD()
 			goto shutdown_error;
 	} 
 
+	//remember how much is queued between the mixer and the speakers
+	if( m_pSystem->getDSPBufferSize(&m_dspBufferLen, &m_dspNumBuffers) != FMOD_OK )
+		goto shutdown_error;
+	if( m_pSystem->getSoftwareFormat(&m_mixRate, 0, 0, 0, 0, 0) != FMOD_OK )
+		goto shutdown_error;
 
 	return true;
 
@@ -246,14 +257,82 @@ shutdown_error:
 
 void AudioMgrFMOD::Update()
 {
+	PROFILE_ZONE("AudioMgrFMOD::Update");
+	AllocScope allocScope(AllocTag::AUDIO);
 	//let fmod update
 	if( !m_pSystem || (m_pSystem->update() != FMOD_OK) )
 		return;
+	UpdateLatencyProbe();
 	//call the base class update as it has its own work to do
 	IAudioMgr::Update();
 
 }
 
+double AudioMgrFMOD::GetClockSec() const
+{
+	return Clock::ToSec(Clock::NowNs());
+}
+
+/*
+Fmod doesn't tell us when it starts mixing a sound, but once a channel's
+position moves off zero we can work back from how far it's got to when
+that was and which mix buffer it landed in (the dsp clock counts frames
+mixed). Anything mixed now is heard once the buffers already queued for
+the sound card have played, so it's an estimate, good to about a buffer.
+*/
+void AudioMgrFMOD::UpdateLatencyProbe()
+{
+	AudioLatencyProbe &probe = GetLatencyProbe();
+	if( !probe.GetNumPending() || !m_pSfxMgr || !m_pSongMgr )
+		return;
+	double now = GetClockSec();
+	unsigned int hi, lo;
+	if( m_pSystem->getDSPClock(&hi, &lo) != FMOD_OK )
+		return;
+	uint64_t dspClock = ((uint64_t)hi << 32) | lo;
+	double secPerFrame = 1.0 / m_mixRate;
+
+	for( unsigned int i = 0; i < probe.GetNumPending(); ++i )
+	{
+		const AudioLatencyProbe::Record &rec = probe.GetPending(i);
+		if( rec.pickedUp )
+			continue;
+		FMOD::Channel *pCh = static_cast<AudioGroupFMOD*>(m_pSfxMgr)->GetChannel(rec.channelHandle);
+		if( !pCh )
+			pCh = static_cast<AudioGroupFMOD*>(m_pSongMgr)->GetChannel(rec.channelHandle);
+		uint64_t framesAgo = 0;
+		if( pCh )
+		{
+			unsigned int pos = 0;
+			float freq = 0;
+			if( pCh->getPosition(&pos, FMOD_TIMEUNIT_PCM) != FMOD_OK || pos == 0 )
+				continue;
+			if( pCh->getFrequency(&freq) == FMOD_OK && freq > 0 )
+				framesAgo = static_cast<uint64_t>(pos * (m_mixRate / (double)freq));
+			if( framesAgo > dspClock )
+				framesAgo = dspClock;
+		}
+		//no channel means it already finished, so it was picked up by now at least
+		uint64_t startFrame = dspClock - framesAgo;
+		probe.OnPickup(rec.channelHandle, now - framesAgo * secPerFrame, startFrame / m_dspBufferLen,
+			static_cast<unsigned int>(startFrame % m_dspBufferLen));
+	}
+
+	//every buffer something was picked up in has gone to the sound card, work out when it's heard
+	double queuedSec = m_dspNumBuffers * m_dspBufferLen * secPerFrame;
+	for( ;; )
+	{
+		unsigned int i;
+		for( i = 0; i < probe.GetNumPending() && !probe.GetPending(i).pickedUp; ++i )
+			;
+		if( i == probe.GetNumPending() )
+			break;
+		uint64_t bufferIdx = probe.GetPending(i).bufferIdx;
+		double mixedSec = now - (dspClock - bufferIdx * m_dspBufferLen) * secPerFrame;
+		probe.OnBufferOut(bufferIdx, mixedSec + queuedSec, secPerFrame);
+	}
+}
+
 void AudioMgrFMOD::Shutdown()
 {
 	//first let the base class do its thing
@@ -312,8 +391,6 @@ load it in (sfx).
 */
 bool AudioGroupFMOD::Load( const utf8string &folder )
 {
-	if( !FileOrFolderExists( folder ) )
-		return false;
 	vector<utf8string> fileSpec;
 	fileSpec.push_back( "*.wav" );
 	fileSpec.push_back( "*.ogg" );
@@ -321,6 +398,10 @@ bool AudioGroupFMOD::Load( const utf8string &folder )
 	fileSpec.push_back( "*.wma" );
 
 	bool allLoaded = true;
+	if( LoadPacked( folder, fileSpec, allLoaded ) > 0 )
+		return allLoaded;
+	if( !FileOrFolderExists( folder ) )
+		return false;
 	for( size_t i = 0; i < fileSpec.size(); ++i )
 	{
 		vector<utf8string> names = File::findFiles( folder, fileSpec[i].c_str() );
@@ -334,11 +415,16 @@ bool AudioGroupFMOD::Load( const utf8string &folder )
 				continue;
 			if( Exists( data._name ) )
 				continue;
+			//the cooker may have made a version at the mix rate, it's relative to where we started
+			utf8string fileName = names[ii];
+			const AssetManifest::Entry *pCooked = AssetManifest::Get().Find( folder + "/" + names[ii] );
+			if( pCooked )
+				fileName = File::getFirstRunDirectory() + "/" + pCooked->cooked;
 			bool success = true;
 			FMOD_RESULT res;
 			if( m_asStreams )
 			{
-				res = m_audioMgr.GetSystem()->createStream( names[ii].c_str(), FMOD_DEFAULT, 0, &data._pSound );
+				res = m_audioMgr.GetSystem()->createStream( fileName.c_str(), FMOD_DEFAULT, 0, &data._pSound );
 				if( res != FMOD_OK ) 
 				{ 
 					DBOUT("FMOD ERROR code(" << res << ") " << FMOD_ErrorString(res));
@@ -348,7 +434,7 @@ bool AudioGroupFMOD::Load( const utf8string &folder )
 			}
 			else
 			{
-				res = m_audioMgr.GetSystem()->createSound( names[ii].c_str(), FMOD_DEFAULT, 0, &data._pSound );
+				res = m_audioMgr.GetSystem()->createSound( fileName.c_str(), FMOD_DEFAULT, 0, &data._pSound );
 				if( res != FMOD_OK ) 
 				{ 
 					assert(false);// , "FMOD ERROR (%d) %s", res, FMOD_ErrorString(res));
@@ -365,6 +451,56 @@ bool AudioGroupFMOD::Load( const utf8string &folder )
 	return allLoaded;
 } 
 
+/*
+Same as Load but out of the asset archive, fmod is pointed at the archive's
+memory so nothing is copied. If it won't play from there (some formats
+need decoding up front) let it take a copy instead.
+Returns how many sounds the archive had for this folder.
+*/
+int AudioGroupFMOD::LoadPacked( const utf8string &folder, const vector<utf8string> &fileSpec, bool &allLoaded )
+{
+	AssetArchive &archive = AssetArchive::Get();
+	if( !archive.IsOpen() )
+		return 0;
+	int numFound = 0;
+	vector<string> paths;
+	for( size_t i = 0; i < fileSpec.size(); ++i )
+	{
+		//"*.wav" -> ".wav"
+		archive.List( folder, fileSpec[i].substr(1), paths );
+		for( size_t ii = 0; ii < paths.size(); ++ii )
+		{
+			++numFound;
+			SoundData data;
+			if( !splitFileName( paths[ii], NULL, NULL, NULL, &data._name ) )
+				continue;
+			if( Exists( data._name ) )
+				continue;
+			//cooked version if there is one
+			AssetArchive::Slice slice = archive.Find( AssetManifest::Get().Resolve( paths[ii] ) );
+			if( !slice )
+				slice = archive.Find( paths[ii] );
+			FMOD_CREATESOUNDEXINFO exinfo;
+			memset( &exinfo, 0, sizeof(exinfo) );
+			exinfo.cbsize = sizeof(exinfo);
+			exinfo.length = static_cast<unsigned int>(slice.size);
+			FMOD_MODE mode = FMOD_DEFAULT | (m_asStreams ? FMOD_CREATESTREAM : FMOD_CREATESAMPLE);
+			const char *pData = reinterpret_cast<const char*>(slice.pData);
+			FMOD_RESULT res = m_audioMgr.GetSystem()->createSound( pData, mode | FMOD_OPENMEMORY_POINT, &exinfo, &data._pSound );
+			if( res != FMOD_OK )
+				res = m_audioMgr.GetSystem()->createSound( pData, mode | FMOD_OPENMEMORY, &exinfo, &data._pSound );
+			if( res != FMOD_OK )
+			{
+				DBOUT("FMOD ERROR code(" << res << ") " << FMOD_ErrorString(res) << " " << paths[ii]);
+				allLoaded = false;
+				continue;
+			}
+			m_sounds.push_back( data );
+		}
+	}
+	return numFound;
+}
+
 /*
 Create the potential in this group for 100 sounds
 */
@@ -505,6 +641,7 @@ bool AudioGroupFMOD::Play( const unsigned int handle, const bool loop, const boo
 		it = m_channels.end();
 		it--;
 	}
+	m_audioMgr.GetLatencyProbe().OnTrigger( (*it)._channelHandle, handle, m_audioMgr.GetClockSec() );
 	//setup the callback so we know when it finishes
 	pCh->setUserData( &(*it) );
 	pCh->setCallback( FMOD_CHANNEL_CALLBACKTYPE_END, fmodChannelCallback, 0 ); 
@@ -523,7 +660,11 @@ void AudioGroupFMOD::Stop()
 	m_pMyGroup->stop();
 	Channels::iterator it;
 	for( it = m_channels.begin(); it != m_channels.end(); ++it )
+	{
+		if( (*it)._channelHandle != UINT_MAX )
+			m_audioMgr.GetLatencyProbe().Cancel( (*it)._channelHandle );
 		(*it)._channelHandle = UINT_MAX;
+	}
 }
 
 //search through the channels array for a specific one
@@ -549,6 +690,7 @@ void AudioGroupFMOD::Stop( const unsigned int channelHandle )
 			continue;
 		(*it)._pChannel->stop();
 		(*it)._channelHandle = UINT_MAX;
+		m_audioMgr.GetLatencyProbe().Cancel( channelHandle );
 	}
 }
 
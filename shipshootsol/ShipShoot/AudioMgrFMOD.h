@@ -84,6 +84,8 @@ private:
 	int GetSoundData( const std::string &name, SoundData ** pSD = nullptr );
 	///get channel data
 	const ChannelData &GetChannelData( const unsigned int channelHandle );
+	///load a folder's sounds from the asset archive, returns how many it had
+	int LoadPacked( const utf8string &folder, const std::vector<utf8string> &fileSpec, bool &allLoaded );
 };
 
 ///fmod version of the abstract base class
@@ -95,8 +97,16 @@ public:
 	void Shutdown();
 	void Update();
 	FMOD::System * const GetSystem() { return m_pSystem; }
+	//wall clock seconds, what the latency probe measures in
+	double GetClockSec() const;
 private:
 	FMOD::System *m_pSystem;	//the main fmod system is owned by us
+	unsigned int m_dspBufferLen;	//frames fmod mixes at a time
+	int m_dspNumBuffers;			//how many of those are queued up for the sound card
+	int m_mixRate;
+
+	//find out which sounds the mixer has got to and when they'll be heard
+	void UpdateLatencyProbe();
 
 	AudioMgrFMOD( const IAudioMgr & );
 	const AudioMgrFMOD &operator=( const IAudioMgr & );
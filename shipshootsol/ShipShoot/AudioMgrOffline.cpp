@@ -0,0 +1,413 @@
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+
+#include "AudioMgrOffline.h"
+#include "AudioMix.h"
+#include "AssetArchive.h"
+#include "AssetManifest.h"
+#include "WavFile.h"
+#include "D3DUtil.h"
+#include "Clock.h"
+#include "AllocTracker.h"
+
+using namespace std;
+
+
+unsigned int AudioGroupOffline::m_uniqueChannelCounter(0);
+
+
+AudioMgrOffline::AudioMgrOffline(shared_ptr<IAudioSink> sink, const float tickSec, const unsigned int mixRate)
+	: IAudioMgr(), m_sink(sink), m_tickSec(tickSec), m_mixRate(mixRate)
+{
+	assert(sink && tickSec > 0 && mixRate > 0);
+}
+
+AudioMgrOffline::~AudioMgrOffline()
+{
+	Shutdown();
+}
+
+/*
+Same folders as the fmod version, "music" and "sfx", then open
+the sink ready for the first tick.
+*/
+bool AudioMgrOffline::Initialise(void)
+{
+	assert(!m_pSongMgr && !m_pSfxMgr);
+	m_pSongMgr = new AudioGroupOffline(*this, "song");
+	if (!m_pSongMgr->Initialise(true))
+		return false;
+	m_pSfxMgr = new AudioGroupOffline(*this, "sfx");
+	if (!m_pSfxMgr->Initialise(false))
+		return false;
+
+	if (!GetSongMgr()->Load("music"))
+		assert(false);
+	GetSongMgr()->SetVolume(1);
+	if (!GetSfxMgr()->Load("sfx"))
+		assert(false);
+	GetSfxMgr()->SetVolume(1);
+
+	if (!m_sink->Open(m_mixRate, 2))
+	{
+		DBOUT("Cannot open offline audio output");
+		return false;
+	}
+	m_open = true;
+	m_numTicks = 0;
+	m_framesRendered = 0;
+	m_startSec = Clock::ToSec(Clock::NowNs());
+	return true;
+}
+
+/*
+The virtual clock moves on one tick. Work out the frame the tick ends on
+from the tick count rather than adding up tick lengths, that way a tick
+that isn't a whole number of frames never drifts.
+*/
+void AudioMgrOffline::Update()
+{
+	AllocScope allocScope(AllocTag::AUDIO);
+	if (!m_pSongMgr || !m_open)
+		return;
+
+	uint64_t bufferIdx = m_numTicks++;
+	uint64_t endFrame = static_cast<uint64_t>(m_numTicks * (double)m_tickSec * m_mixRate + 0.5);
+	unsigned int numFrames = static_cast<unsigned int>(endFrame - m_framesRendered);
+	if (numFrames > 0)
+	{
+		double bufferSec = GetSecondsRendered();
+		m_bus.assign(numFrames * 2, 0.f);
+		static_cast<AudioGroupOffline*>(m_pSongMgr)->Mix(m_bus.data(), numFrames, bufferIdx, bufferSec);
+		static_cast<AudioGroupOffline*>(m_pSfxMgr)->Mix(m_bus.data(), numFrames, bufferIdx, bufferSec);
+		m_pcm.resize(numFrames * 2);
+		AudioMix::FloatToInt16(m_bus.data(), m_pcm.data(), numFrames * 2);
+		double audibleSec = m_sink->Write(m_pcm.data(), numFrames, bufferIdx, bufferSec);
+		m_probe.OnBufferOut(bufferIdx, audibleSec, 1.0 / m_mixRate);
+		m_framesRendered = endFrame;
+	}
+
+	//call the base class update as it has its own work to do
+	IAudioMgr::Update();
+}
+
+double AudioMgrOffline::GetRenderSpeed() const
+{
+	double wall = Clock::ToSec(Clock::NowNs()) - m_startSec;
+	if (wall <= 0)
+		return 0;
+	return GetSecondsRendered() / wall;
+}
+
+void AudioMgrOffline::Shutdown()
+{
+	if (m_open)
+	{
+		m_sink->Close();
+		m_open = false;
+		DBOUT("Offline audio: " << GetSecondsRendered() << "s rendered at " << GetRenderSpeed() << "x real time");
+	}
+	IAudioMgr::Shutdown();
+}
+
+
+
+
+//**********************************************************************************
+bool AudioGroupOffline::Initialise(const bool asStreams)
+{
+	m_voices.resize(AudioMgrOffline::MAX_CHANNELS);
+	m_sounds.reserve(100);
+	m_asStreams = asStreams;
+	return true;
+}
+
+/*
+Same as the fmod version but only wav files can be decoded here,
+anything else gets skipped.
+*/
+bool AudioGroupOffline::Load(const utf8string &folder)
+{
+	//packed assets first, decoded straight out of the archive
+	vector<string> paths;
+	AssetArchive::Get().List(folder, ".wav", paths);
+	if (!paths.empty())
+	{
+		bool allLoaded = true;
+		for (auto &path : paths)
+		{
+			SoundData data;
+			if (!splitFileName(path, NULL, NULL, NULL, &data._name) || Exists(data._name))
+				continue;
+			//cooked version if there is one
+			AssetArchive::Slice slice = AssetArchive::Get().Find(AssetManifest::Get().Resolve(path));
+			if (!slice)
+				slice = AssetArchive::Get().Find(path);
+			if (LoadWav(slice.pData, slice.size, path, data))
+				m_sounds.push_back(data);
+			else
+				allLoaded = false;
+		}
+		return allLoaded;
+	}
+
+	if (!FileOrFolderExists(folder))
+		return false;
+	vector<utf8string> names = File::findFiles(folder, "*.wav");
+	if (names.empty())
+		return true;
+	bool allLoaded = true;
+	File::setCurrentFolder(folder);
+	for (size_t i = 0; i < names.size(); ++i)
+	{
+		SoundData data;
+		if (!splitFileName(names[i], NULL, NULL, NULL, &data._name))
+			continue;
+		if (Exists(data._name))
+			continue;
+		//the cooker's version is relative to where we started
+		utf8string fileName = names[i];
+		const AssetManifest::Entry *pCooked = AssetManifest::Get().Find(folder + "/" + names[i]);
+		if (pCooked)
+			fileName = File::getFirstRunDirectory() + "/" + pCooked->cooked;
+		if (LoadWav(fileName, data))
+			m_sounds.push_back(data);
+		else
+			allLoaded = false;
+	}
+	File::setCurrentFolder(File::getFirstRunDirectory());
+	return allLoaded;
+}
+
+bool AudioGroupOffline::LoadWav(const utf8string &fileName, SoundData &data)
+{
+	//pull the whole file in
+	File file(fileName, File::MPF_READ);
+	vector<uint8_t> bytes(file.getSize());
+	unsigned int bytesRead = 0;
+	if (bytes.empty() || !file.read(bytes.data(), static_cast<unsigned int>(bytes.size()), bytesRead) || bytesRead != bytes.size())
+		return false;
+	return LoadWav(bytes.data(), bytes.size(), fileName, data);
+}
+
+bool AudioGroupOffline::LoadWav(const uint8_t *pBytes, const size_t numBytes, const utf8string &fileName, SoundData &data)
+{
+	WavFile::Data wav;
+	string error;
+	if (!WavFile::Decode(pBytes, numBytes, wav, 2, &error))
+	{
+		DBOUT("Cannot load " << fileName << ": " << error);
+		return false;
+	}
+
+	data._numChannels = wav.numChannels;
+	unsigned int mixRate = m_audioMgr.GetMixRate();
+	if (wav.rate == mixRate)
+	{
+		data._samples.swap(wav.samples);
+	}
+	else
+	{
+		AudioMix::PolyphaseResampler resampler(wav.rate, mixRate);
+		resampler.Process(wav.samples.data(), wav.numFrames, wav.numChannels, data._samples);
+	}
+	data._numFrames = static_cast<unsigned int>(data._samples.size() / wav.numChannels);
+	return true;
+}
+
+void AudioGroupOffline::Mix(float *pBus, const unsigned int numFrames, const uint64_t bufferIdx, const double bufferSec)
+{
+	for (auto &v : m_voices)
+	{
+		if (v._channelHandle == UINT_MAX || v._paused || m_paused)
+			continue;
+		//new voices always start at the top of a buffer
+		if (!v._pickedUp)
+		{
+			v._pickedUp = true;
+			m_audioMgr.GetLatencyProbe().OnPickup(v._channelHandle, bufferSec, bufferIdx, 0);
+		}
+		const SoundData &snd = m_sounds[v._soundIdx];
+		float left, right;
+		AudioMix::PanGains(v._vol * GetVolume(), v._pan, m_channelCutOffVol, left, right);
+		unsigned int done = 0;
+		while (done < numFrames)
+		{
+			if (v._pos >= snd._numFrames)
+			{
+				if (!v._loop || snd._numFrames == 0)
+				{
+					//finished, the channel is free again
+					v._channelHandle = UINT_MAX;
+					break;
+				}
+				v._pos = 0;
+			}
+			unsigned int n = min(numFrames - done, snd._numFrames - v._pos);
+			//muted voices still move on so they stay in time
+			if (!m_muted)
+			{
+				if (snd._numChannels == 1)
+					AudioMix::MixMonoToStereo(pBus + done * 2, &snd._samples[v._pos], n, left, right);
+				else
+					AudioMix::MixStereoToStereo(pBus + done * 2, &snd._samples[v._pos * 2], n, left, right);
+			}
+			v._pos += n;
+			done += n;
+		}
+	}
+}
+
+unsigned int AudioGroupOffline::NumChannelsPlaying()
+{
+	unsigned int n = 0;
+	for (auto &v : m_voices)
+		if (v._channelHandle != UINT_MAX)
+			++n;
+	return n;
+}
+
+int AudioGroupOffline::GetSoundData(const utf8string &name)
+{
+	for (int i = 0; i < static_cast<int>(m_sounds.size()); ++i)
+	{
+		if (m_sounds[i]._name == name)
+			return i;
+	}
+	return -1;
+}
+
+AudioGroupOffline::Voice *AudioGroupOffline::GetVoice(const unsigned int channelHandle)
+{
+	if (channelHandle == UINT_MAX)
+		return nullptr;
+	for (auto &v : m_voices)
+	{
+		if (v._channelHandle == channelHandle)
+			return &v;
+	}
+	return nullptr;
+}
+
+bool AudioGroupOffline::Exists(const utf8string &name, int *pSoundIndex)
+{
+	utf8string sname;
+	if (!splitFileName(name, NULL, NULL, NULL, &sname))
+		sname = name;
+	int hdl = GetSoundData(sname);
+	if (hdl < 0)
+		return false;
+	if (pSoundIndex)
+		*pSoundIndex = hdl;
+	return true;
+}
+
+bool AudioGroupOffline::Play(const utf8string &name, const bool loop, const bool paused, unsigned int *pChannelHandle, const float vol)
+{
+	int handle = GetSoundData(name);
+	if (handle < 0)
+		return false;
+	return Play(static_cast<unsigned int>(handle), loop, paused, pChannelHandle, vol);
+}
+
+bool AudioGroupOffline::Play(const unsigned int handle, const bool loop, const bool paused, unsigned int *pChannelHandle, const float vol)
+{
+	if (handle >= m_sounds.size())
+		return false;
+	//only one of each sound is started per frame - otherwise it sounds wierd
+	if (IAudioMgr::CheckDuplicates(handle))
+		return false;
+	for (auto &v : m_voices)
+	{
+		if (v._channelHandle != UINT_MAX)
+			continue;
+		v._soundIdx = handle;
+		v._channelHandle = m_uniqueChannelCounter++;
+		v._pos = 0;
+		v._loop = loop;
+		v._paused = paused;
+		v._pickedUp = false;
+		v._vol = vol > m_channelCutOffVol ? m_channelCutOffVol : vol;
+		v._pan = 0;
+		if (pChannelHandle)
+			*pChannelHandle = v._channelHandle;
+		m_audioMgr.GetLatencyProbe().OnTrigger(v._channelHandle, handle, m_audioMgr.GetSecondsRendered());
+		return true;
+	}
+	//every channel is busy, same as fmod running out
+	return false;
+}
+
+void AudioGroupOffline::Stop()
+{
+	for (auto &v : m_voices)
+	{
+		if (v._channelHandle != UINT_MAX)
+			m_audioMgr.GetLatencyProbe().Cancel(v._channelHandle);
+		v._channelHandle = UINT_MAX;
+	}
+}
+
+void AudioGroupOffline::Stop(const unsigned int channelHandle)
+{
+	Voice *pV = GetVoice(channelHandle);
+	if (pV)
+	{
+		m_audioMgr.GetLatencyProbe().Cancel(channelHandle);
+		pV->_channelHandle = UINT_MAX;
+	}
+}
+
+void AudioGroupOffline::SetVolume(const float vol, const unsigned int channelHandle)
+{
+	assert(vol >= 0 && vol <= 1);
+	Voice *pV = GetVoice(channelHandle);
+	if (pV)
+		pV->_vol = vol > m_channelCutOffVol ? m_channelCutOffVol : vol;
+}
+
+void AudioGroupOffline::SetPan(const float pan, const unsigned int channelHandle)
+{
+	assert(pan >= -1 && pan <= 1);
+	Voice *pV = GetVoice(channelHandle);
+	if (pV)
+		pV->_pan = pan;
+}
+
+void AudioGroupOffline::SetPause(const bool state, const unsigned int channelHandle)
+{
+	if (channelHandle != UINT_MAX)
+	{
+		Voice *pV = GetVoice(channelHandle);
+		if (pV)
+			pV->_paused = state;
+		return;
+	}
+	m_paused = state;
+}
+
+bool AudioGroupOffline::IsPlaying(const unsigned int channelHandle)
+{
+	return GetVoice(channelHandle) != nullptr;
+}
+
+const utf8string &AudioGroupOffline::GetName(const unsigned int channelHandle)
+{
+	Voice *pV = GetVoice(channelHandle);
+	assert(pV);
+	return m_sounds.at(pV ? pV->_soundIdx : 0)._name;
+}
+
+unsigned int AudioGroupOffline::GetChannelHandle(const int idx)
+{
+	assert(idx >= 0 && idx < static_cast<int>(m_voices.size()));
+	return m_voices[idx]._channelHandle;
+}
+
+const unsigned int &AudioGroupOffline::GetSoundIndex(const unsigned int channelHandle)
+{
+	Voice *pV = GetVoice(channelHandle);
+	assert(pV);
+	return pV ? pV->_soundIdx : m_voices.front()._soundIdx;
+}
@@ -0,0 +1,124 @@
+#ifndef AUDIOMGROFFLINE_H
+#define AUDIOMGROFFLINE_H
+
+#include <vector>
+#include <cstdint>
+#include <memory>
+
+#include "AudioMgr.h"
+#include "AudioSink.h"
+
+/*
+A software version of the audio manager that doesn't need a sound card.
+Instead of playing in real time it mixes exactly one simulation tick
+of audio every Update and hands it to a sink, normally a wav file. The
+game can then run as fast as it likes and the recording still lines up
+with what happened, every run of the same session gives the same file.
+Each tick is one output buffer as far as the latency probe is concerned.
+Sounds are all loaded into memory and converted to the mix rate
+up front, only uncompressed wav files are supported.
+*/
+class AudioMgrOffline;
+class AudioGroupOffline : public IAudioGroup
+{
+public:
+	//a sound playing on a channel
+	struct Voice
+	{
+		unsigned int _soundIdx = 0;
+		unsigned int _channelHandle = UINT_MAX;	//UINT_MAX = free
+		unsigned int _pos = 0;					//next frame to mix
+		bool _loop = false;
+		bool _paused = false;
+		bool _pickedUp = false;					//mixed at least once, for the latency probe
+		float _vol = 1.f;
+		float _pan = 0;
+	};
+	//see base class for descriptions
+	AudioGroupOffline(AudioMgrOffline &audioMgr, const utf8string &grpName)
+		: IAudioGroup(grpName), m_audioMgr(audioMgr) {};
+	virtual void Stop();
+	virtual void Stop(const unsigned int channelHandle);
+	virtual void Mute(const bool state) { m_muted = state; }
+	virtual void SetVolume(const float vol, const unsigned int channelHandle);
+	virtual void SetPan(const float pan, const unsigned int channelHandle);
+	virtual void SetPause(const bool state, const unsigned int channelHandle = UINT_MAX);
+	virtual bool Initialise(const bool asStreams);
+	virtual bool Load(const utf8string &folder);
+	virtual unsigned int NumChannelsPlaying();
+	virtual unsigned int NumSoundsLoaded() { return static_cast<unsigned int>(m_sounds.size()); }
+	virtual bool Play(const utf8string &name, const bool loop, const bool paused, unsigned int *pChannelHandle = nullptr,
+		const float vol = 1.f);
+	virtual bool Play(const unsigned int soundHandle, const bool loop, const bool paused, unsigned int *pChannelHandle = nullptr,
+		const float vol = 1.f);
+	virtual bool Exists(const utf8string &name, int *pSoundIndex = nullptr);
+	virtual bool IsPlaying(const unsigned int channelHandle);
+	virtual const utf8string &GetName(const unsigned int channelHandle);
+	virtual unsigned int GetChannelHandle(const int idx);
+	virtual const unsigned int &GetSoundIndex(const unsigned int channelHandle);
+
+	//add everything playing into a stereo bus at the mix rate
+	//bufferIdx/bufferSec - which output buffer this is and when it starts, for the latency probe
+	void Mix(float *pBus, const unsigned int numFrames, const uint64_t bufferIdx, const double bufferSec);
+private:
+	struct SoundData
+	{
+		utf8string _name;
+		unsigned int _numChannels = 1;		//1 or 2
+		unsigned int _numFrames = 0;
+		std::vector<float> _samples;		//at the mix rate, interleaved if stereo
+	};
+	typedef std::vector<Voice> Voices;
+	typedef std::vector<SoundData> Sounds;
+
+	Sounds m_sounds;
+	Voices m_voices;
+	bool m_asStreams = false;	//just remembered, everything is in memory
+	bool m_muted = false;
+	bool m_paused = false;
+	AudioMgrOffline &m_audioMgr;
+	static unsigned int m_uniqueChannelCounter;
+
+	int GetSoundData(const utf8string &name);
+	Voice *GetVoice(const unsigned int channelHandle);
+	//read a wav and convert it to floats at the mix rate
+	bool LoadWav(const utf8string &fileName, SoundData &data);
+	//same but the whole file is already in memory, fileName is just for errors
+	bool LoadWav(const uint8_t *pBytes, const size_t numBytes, const utf8string &fileName, SoundData &data);
+};
+
+class AudioMgrOffline : public IAudioMgr
+{
+public:
+	enum { MAX_CHANNELS = 100 };
+	//sink - where the mix goes
+	//tickSec - how much audio each Update makes, match the simulation tick
+	AudioMgrOffline(std::shared_ptr<IAudioSink> sink, const float tickSec, const unsigned int mixRate = 48000);
+	~AudioMgrOffline();
+	bool Initialise(void);
+	void Shutdown();
+	//mix the next tick and write it out
+	void Update();
+	unsigned int GetMixRate() const { return m_mixRate; }
+	//how far the virtual clock has got, also what the latency probe measures in
+	uint64_t GetFramesRendered() const { return m_framesRendered; }
+	double GetSecondsRendered() const { return m_framesRendered / (double)m_mixRate; }
+	//audio seconds made per wall clock second since Initialise, 10 = ten times faster than real time
+	double GetRenderSpeed() const;
+private:
+	std::shared_ptr<IAudioSink> m_sink;
+	bool m_open = false;
+	float m_tickSec;
+	unsigned int m_mixRate;
+	uint64_t m_numTicks = 0;
+	uint64_t m_framesRendered = 0;
+	std::vector<float> m_bus;		//stereo float mix
+	std::vector<int16_t> m_pcm;		//what gets written
+	double m_startSec = 0;			//wall clock when we started
+
+	AudioMgrOffline(const AudioMgrOffline &) = delete;
+	const AudioMgrOffline &operator=(const AudioMgrOffline &) = delete;
+};
+
+
+#endif
@@ -0,0 +1,663 @@
+#include <cassert>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+
+#include "AudioMix.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define AUDIOMIX_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+//msvc will compile any intrinsic anywhere, gcc/clang need telling which functions can use them
+#if defined(__GNUC__) || defined(__clang__)
+#define SSE2_FN __attribute__((target("sse2")))
+#define AVX2_FN __attribute__((target("avx2")))
+#else
+#define SSE2_FN
+#define AVX2_FN
+#endif
+
+using namespace std;
+
+namespace AudioMix
+{
+
+//**************************************************************************************************
+//picking the kernels
+
+//-1 until the first GetIsa or SetIsa, any thread can be first
+static atomic<int> sIsa{ -1 };
+
+Isa GetBestIsa()
+{
+#ifdef AUDIOMIX_X86
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	int numIds = info[0];
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	bool avx2 = false;
+	if (numIds >= 7 && osxsave && avx)
+	{
+		//the os has to save the ymm registers on a context switch or we can't use them
+		if ((_xgetbv(0) & 6) == 6)
+		{
+			__cpuidex(info, 7, 0);
+			avx2 = (info[1] & (1 << 5)) != 0;
+		}
+	}
+#else
+	__builtin_cpu_init();
+	bool sse2 = __builtin_cpu_supports("sse2") != 0;
+	bool avx2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+	if (avx2)
+		return Isa::AVX2;
+	if (sse2)
+		return Isa::SSE2;
+#endif
+	return Isa::SCALAR;
+}
+
+Isa GetIsa()
+{
+	int isa = sIsa.load(memory_order_relaxed);
+	if (isa < 0)
+	{
+		//threads racing here all pick the same, a SetIsa that got in first wins
+		int best = static_cast<int>(GetBestIsa());
+		if (sIsa.compare_exchange_strong(isa, best, memory_order_relaxed))
+			isa = best;
+	}
+	return static_cast<Isa>(isa);
+}
+
+void SetIsa(Isa isa)
+{
+	Isa best = GetBestIsa();
+	sIsa.store(static_cast<int>((static_cast<int>(isa) > static_cast<int>(best)) ? best : isa), memory_order_relaxed);
+}
+
+const char* GetIsaName(Isa isa)
+{
+	switch (isa)
+	{
+	case Isa::SSE2:
+		return "sse2";
+	case Isa::AVX2:
+		return "avx2";
+	default:
+		return "scalar";
+	}
+}
+
+void PanGains(float vol, float pan, float cutOffVol, float& left, float& right)
+{
+	if (vol > cutOffVol)
+		vol = cutOffVol;
+	if (pan < -1)
+		pan = -1;
+	else if (pan > 1)
+		pan = 1;
+	//centre is full volume both sides, panning just fades the other side out
+	left = vol * (pan > 0 ? 1 - pan : 1);
+	right = vol * (pan < 0 ? 1 + pan : 1);
+}
+
+
+//**************************************************************************************************
+//plain versions, the vector versions fall back on these for any leftover samples
+
+static void ApplyGainScalar(float* buf, unsigned int n, float gain)
+{
+	for (unsigned int i = 0; i < n; ++i)
+		buf[i] *= gain;
+}
+
+static void MixMonoToStereoScalar(float* bus, const float* src, unsigned int n, float left, float right)
+{
+	for (unsigned int i = 0; i < n; ++i)
+	{
+		bus[i * 2] += src[i] * left;
+		bus[i * 2 + 1] += src[i] * right;
+	}
+}
+
+static void MixStereoToStereoScalar(float* bus, const float* src, unsigned int n, float left, float right)
+{
+	for (unsigned int i = 0; i < n; ++i)
+	{
+		bus[i * 2] += src[i * 2] * left;
+		bus[i * 2 + 1] += src[i * 2 + 1] * right;
+	}
+}
+
+static void LerpScalar(const float* src, const int* idx, const float* frac, float* dst, unsigned int n)
+{
+	for (unsigned int i = 0; i < n; ++i)
+	{
+		float a = src[idx[i]];
+		float b = src[idx[i] + 1];
+		dst[i] = a + (b - a) * frac[i];
+	}
+}
+
+static void FloatToInt16Scalar(const float* src, int16_t* dst, unsigned int n)
+{
+	for (unsigned int i = 0; i < n; ++i)
+	{
+		float s = src[i];
+		if (s > 1.f)
+			s = 1.f;
+		else if (s < -1.f)
+			s = -1.f;
+		dst[i] = static_cast<int16_t>(lrintf(s * 32767.f));
+	}
+}
+
+static void Int16ToFloatScalar(const int16_t* src, float* dst, unsigned int n)
+{
+	for (unsigned int i = 0; i < n; ++i)
+		dst[i] = src[i] * (1.f / 32767.f);
+}
+
+//adds up as four running totals like the sse version so both give exactly the same answer
+static float DotScalar(const float* a, const float* b, unsigned int n)
+{
+	assert(n % 4 == 0);
+	float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	for (unsigned int i = 0; i < n; i += 4)
+	{
+		s0 += a[i] * b[i];
+		s1 += a[i + 1] * b[i + 1];
+		s2 += a[i + 2] * b[i + 2];
+		s3 += a[i + 3] * b[i + 3];
+	}
+	return (s0 + s2) + (s1 + s3);
+}
+
+
+#ifdef AUDIOMIX_X86
+//**************************************************************************************************
+//sse2 - 4 floats at a time
+
+SSE2_FN static void ApplyGainSSE2(float* buf, unsigned int n, float gain)
+{
+	__m128 g = _mm_set1_ps(gain);
+	unsigned int i = 0;
+	for (; i + 4 <= n; i += 4)
+		_mm_storeu_ps(buf + i, _mm_mul_ps(_mm_loadu_ps(buf + i), g));
+	ApplyGainScalar(buf + i, n - i, gain);
+}
+
+SSE2_FN static void MixMonoToStereoSSE2(float* bus, const float* src, unsigned int n, float left, float right)
+{
+	__m128 g = _mm_setr_ps(left, right, left, right);
+	unsigned int i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 s = _mm_loadu_ps(src + i);
+		__m128 lo = _mm_unpacklo_ps(s, s);	//s0 s0 s1 s1
+		__m128 hi = _mm_unpackhi_ps(s, s);	//s2 s2 s3 s3
+		float* b = bus + i * 2;
+		_mm_storeu_ps(b, _mm_add_ps(_mm_loadu_ps(b), _mm_mul_ps(lo, g)));
+		_mm_storeu_ps(b + 4, _mm_add_ps(_mm_loadu_ps(b + 4), _mm_mul_ps(hi, g)));
+	}
+	MixMonoToStereoScalar(bus + i * 2, src + i, n - i, left, right);
+}
+
+SSE2_FN static void MixStereoToStereoSSE2(float* bus, const float* src, unsigned int n, float left, float right)
+{
+	__m128 g = _mm_setr_ps(left, right, left, right);
+	unsigned int i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		float* b = bus + i * 2;
+		_mm_storeu_ps(b, _mm_add_ps(_mm_loadu_ps(b), _mm_mul_ps(_mm_loadu_ps(src + i * 2), g)));
+	}
+	MixStereoToStereoScalar(bus + i * 2, src + i * 2, n - i, left, right);
+}
+
+SSE2_FN static void LerpSSE2(const float* src, const int* idx, const float* frac, float* dst, unsigned int n)
+{
+	unsigned int i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 a = _mm_setr_ps(src[idx[i]], src[idx[i + 1]], src[idx[i + 2]], src[idx[i + 3]]);
+		__m128 b = _mm_setr_ps(src[idx[i] + 1], src[idx[i + 1] + 1], src[idx[i + 2] + 1], src[idx[i + 3] + 1]);
+		__m128 f = _mm_loadu_ps(frac + i);
+		_mm_storeu_ps(dst + i, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), f)));
+	}
+	LerpScalar(src, idx + i, frac + i, dst + i, n - i);
+}
+
+SSE2_FN static void FloatToInt16SSE2(const float* src, int16_t* dst, unsigned int n)
+{
+	const __m128 one = _mm_set1_ps(1.f), minusOne = _mm_set1_ps(-1.f), scale = _mm_set1_ps(32767.f);
+	unsigned int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		//clamp before converting, a huge float converts to 0x80000000 which would pack to -32768
+		__m128 a = _mm_max_ps(minusOne, _mm_min_ps(one, _mm_loadu_ps(src + i)));
+		__m128 b = _mm_max_ps(minusOne, _mm_min_ps(one, _mm_loadu_ps(src + i + 4)));
+		__m128i ia = _mm_cvtps_epi32(_mm_mul_ps(a, scale));
+		__m128i ib = _mm_cvtps_epi32(_mm_mul_ps(b, scale));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(ia, ib));
+	}
+	FloatToInt16Scalar(src + i, dst + i, n - i);
+}
+
+SSE2_FN static void Int16ToFloatSSE2(const int16_t* src, float* dst, unsigned int n)
+{
+	const __m128 scale = _mm_set1_ps(1.f / 32767.f);
+	unsigned int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		//sign extend 16->32 by putting each value in the top half and shifting it back down
+		__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+		__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+		_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+		_mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+	}
+	Int16ToFloatScalar(src + i, dst + i, n - i);
+}
+
+SSE2_FN static float DotSSE2(const float* a, const float* b, unsigned int n)
+{
+	assert(n % 4 == 0);
+	__m128 sum = _mm_setzero_ps();
+	for (unsigned int i = 0; i < n; i += 4)
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+	//(s0+s2) (s1+s3) then add those two
+	sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+	sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+	return _mm_cvtss_f32(sum);
+}
+
+
+//**************************************************************************************************
+//avx2 - 8 floats at a time
+
+AVX2_FN static void ApplyGainAVX2(float* buf, unsigned int n, float gain)
+{
+	__m256 g = _mm256_set1_ps(gain);
+	unsigned int i = 0;
+	for (; i + 8 <= n; i += 8)
+		_mm256_storeu_ps(buf + i, _mm256_mul_ps(_mm256_loadu_ps(buf + i), g));
+	ApplyGainScalar(buf + i, n - i, gain);
+}
+
+AVX2_FN static void MixMonoToStereoAVX2(float* bus, const float* src, unsigned int n, float left, float right)
+{
+	__m256 g = _mm256_setr_ps(left, right, left, right, left, right, left, right);
+	unsigned int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256 s = _mm256_loadu_ps(src + i);
+		//unpack works inside each 128bit half so stitch the halves back into order after
+		__m256 lo = _mm256_unpacklo_ps(s, s);	//s0 s0 s1 s1 | s4 s4 s5 s5
+		__m256 hi = _mm256_unpackhi_ps(s, s);	//s2 s2 s3 s3 | s6 s6 s7 s7
+		__m256 first = _mm256_permute2f128_ps(lo, hi, 0x20);
+		__m256 second = _mm256_permute2f128_ps(lo, hi, 0x31);
+		float* b = bus + i * 2;
+		_mm256_storeu_ps(b, _mm256_add_ps(_mm256_loadu_ps(b), _mm256_mul_ps(first, g)));
+		_mm256_storeu_ps(b + 8, _mm256_add_ps(_mm256_loadu_ps(b + 8), _mm256_mul_ps(second, g)));
+	}
+	MixMonoToStereoScalar(bus + i * 2, src + i, n - i, left, right);
+}
+
+AVX2_FN static void MixStereoToStereoAVX2(float* bus, const float* src, unsigned int n, float left, float right)
+{
+	__m256 g = _mm256_setr_ps(left, right, left, right, left, right, left, right);
+	unsigned int i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		float* b = bus + i * 2;
+		_mm256_storeu_ps(b, _mm256_add_ps(_mm256_loadu_ps(b), _mm256_mul_ps(_mm256_loadu_ps(src + i * 2), g)));
+	}
+	MixStereoToStereoScalar(bus + i * 2, src + i * 2, n - i, left, right);
+}
+
+AVX2_FN static void LerpAVX2(const float* src, const int* idx, const float* frac, float* dst, unsigned int n)
+{
+	unsigned int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256i vi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx + i));
+		__m256 a = _mm256_i32gather_ps(src, vi, 4);
+		__m256 b = _mm256_i32gather_ps(src + 1, vi, 4);
+		__m256 f = _mm256_loadu_ps(frac + i);
+		_mm256_storeu_ps(dst + i, _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), f)));
+	}
+	LerpScalar(src, idx + i, frac + i, dst + i, n - i);
+}
+
+AVX2_FN static void FloatToInt16AVX2(const float* src, int16_t* dst, unsigned int n)
+{
+	const __m256 one = _mm256_set1_ps(1.f), minusOne = _mm256_set1_ps(-1.f), scale = _mm256_set1_ps(32767.f);
+	unsigned int i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		__m256 a = _mm256_max_ps(minusOne, _mm256_min_ps(one, _mm256_loadu_ps(src + i)));
+		__m256 b = _mm256_max_ps(minusOne, _mm256_min_ps(one, _mm256_loadu_ps(src + i + 8)));
+		__m256i ia = _mm256_cvtps_epi32(_mm256_mul_ps(a, scale));
+		__m256i ib = _mm256_cvtps_epi32(_mm256_mul_ps(b, scale));
+		//pack interleaves the 128bit halves (a0-3 b0-3 a4-7 b4-7), put them back in order
+		__m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(ia, ib), 0xD8);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), packed);
+	}
+	FloatToInt16Scalar(src + i, dst + i, n - i);
+}
+
+AVX2_FN static void Int16ToFloatAVX2(const int16_t* src, float* dst, unsigned int n)
+{
+	const __m256 scale = _mm256_set1_ps(1.f / 32767.f);
+	unsigned int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256i s = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+		_mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(s), scale));
+	}
+	Int16ToFloatScalar(src + i, dst + i, n - i);
+}
+#endif
+
+
+//**************************************************************************************************
+//public kernels, hand the work to the chosen version
+
+void ApplyGain(float* buf, unsigned int numSamples, float gain)
+{
+	assert(buf || numSamples == 0);
+	switch (GetIsa())
+	{
+#ifdef AUDIOMIX_X86
+	case Isa::AVX2:
+		ApplyGainAVX2(buf, numSamples, gain);
+		return;
+	case Isa::SSE2:
+		ApplyGainSSE2(buf, numSamples, gain);
+		return;
+#endif
+	default:
+		ApplyGainScalar(buf, numSamples, gain);
+	}
+}
+
+void MixMonoToStereo(float* bus, const float* src, unsigned int numFrames, float left, float right)
+{
+	assert((bus && src) || numFrames == 0);
+	switch (GetIsa())
+	{
+#ifdef AUDIOMIX_X86
+	case Isa::AVX2:
+		MixMonoToStereoAVX2(bus, src, numFrames, left, right);
+		return;
+	case Isa::SSE2:
+		MixMonoToStereoSSE2(bus, src, numFrames, left, right);
+		return;
+#endif
+	default:
+		MixMonoToStereoScalar(bus, src, numFrames, left, right);
+	}
+}
+
+void MixStereoToStereo(float* bus, const float* src, unsigned int numFrames, float left, float right)
+{
+	assert((bus && src) || numFrames == 0);
+	switch (GetIsa())
+	{
+#ifdef AUDIOMIX_X86
+	case Isa::AVX2:
+		MixStereoToStereoAVX2(bus, src, numFrames, left, right);
+		return;
+	case Isa::SSE2:
+		MixStereoToStereoSSE2(bus, src, numFrames, left, right);
+		return;
+#endif
+	default:
+		MixStereoToStereoScalar(bus, src, numFrames, left, right);
+	}
+}
+
+unsigned int ResampleLinear(const float* src, unsigned int numSrcFrames, double& pos, double step,
+	float* dst, unsigned int numDstFrames)
+{
+	assert(step > 0);
+	//work out where each output sample comes from in small batches, the
+	//stepping is done the same way for every isa so they all agree exactly,
+	//then the interpolation itself is done by the vector code
+	enum { BATCH = 64 };
+	int idx[BATCH];
+	float frac[BATCH];
+	unsigned int written = 0;
+	while (written < numDstFrames)
+	{
+		unsigned int n = 0;
+		while (n < BATCH && written + n < numDstFrames)
+		{
+			unsigned int i = static_cast<unsigned int>(pos);
+			if (i + 1 >= numSrcFrames)
+				break;
+			idx[n] = static_cast<int>(i);
+			frac[n] = static_cast<float>(pos - i);
+			pos += step;
+			++n;
+		}
+		if (n == 0)
+			break;
+		switch (GetIsa())
+		{
+#ifdef AUDIOMIX_X86
+		case Isa::AVX2:
+			LerpAVX2(src, idx, frac, dst + written, n);
+			break;
+		case Isa::SSE2:
+			LerpSSE2(src, idx, frac, dst + written, n);
+			break;
+#endif
+		default:
+			LerpScalar(src, idx, frac, dst + written, n);
+		}
+		written += n;
+	}
+	return written;
+}
+
+void FloatToInt16(const float* src, int16_t* dst, unsigned int numSamples)
+{
+	assert((src && dst) || numSamples == 0);
+	switch (GetIsa())
+	{
+#ifdef AUDIOMIX_X86
+	case Isa::AVX2:
+		FloatToInt16AVX2(src, dst, numSamples);
+		return;
+	case Isa::SSE2:
+		FloatToInt16SSE2(src, dst, numSamples);
+		return;
+#endif
+	default:
+		FloatToInt16Scalar(src, dst, numSamples);
+	}
+}
+
+void Int16ToFloat(const int16_t* src, float* dst, unsigned int numSamples)
+{
+	assert((src && dst) || numSamples == 0);
+	switch (GetIsa())
+	{
+#ifdef AUDIOMIX_X86
+	case Isa::AVX2:
+		Int16ToFloatAVX2(src, dst, numSamples);
+		return;
+	case Isa::SSE2:
+		Int16ToFloatSSE2(src, dst, numSamples);
+		return;
+#endif
+	default:
+		Int16ToFloatScalar(src, dst, numSamples);
+	}
+}
+
+
+//**************************************************************************************************
+//polyphase resampling
+
+static const double PI_D = 3.14159265358979323846;
+
+PolyphaseResampler::PolyphaseResampler(unsigned int srcRate, unsigned int dstRate)
+	: mSrcRate(srcRate), mDstRate(dstRate)
+{
+	assert(srcRate > 0 && dstRate > 0);
+	mStep = srcRate / (double)dstRate;
+	//going down in rate means filtering out what the new rate can't hold
+	mCutoff = (dstRate < srcRate) ? dstRate / (float)srcRate : 1.f;
+
+	//each phase is the filter for an output sample that lands that fraction of the way between two inputs
+	const int half = NUM_TAPS / 2;
+	mTaps.resize(NUM_PHASES * NUM_TAPS);
+	for (int phase = 0; phase < NUM_PHASES; ++phase)
+	{
+		double frac = phase / (double)NUM_PHASES;
+		double sum = 0;
+		float* row = &mTaps[phase * NUM_TAPS];
+		for (int k = 0; k < NUM_TAPS; ++k)
+		{
+			double x = (k - (half - 1)) - frac;	//distance from the output position in input samples
+			double sx = x * mCutoff;
+			double sinc = (fabs(sx) < 1e-9) ? 1.0 : sin(PI_D * sx) / (PI_D * sx);
+			//blackman window over the width of the filter
+			double w = (x + half) / (double)NUM_TAPS;
+			double window = 0.42 - 0.5 * cos(2 * PI_D * w) + 0.08 * cos(4 * PI_D * w);
+			if (w < 0 || w > 1)
+				window = 0;
+			row[k] = static_cast<float>(mCutoff * sinc * window);
+			sum += row[k];
+		}
+		//no change in volume for a steady signal
+		for (int k = 0; k < NUM_TAPS; ++k)
+			row[k] = static_cast<float>(row[k] / sum);
+	}
+}
+
+void PolyphaseResampler::Process(const float* src, unsigned int numSrcFrames, std::vector<float>& dst) const
+{
+	const int half = NUM_TAPS / 2;
+	unsigned int numDst = static_cast<unsigned int>(((uint64_t)numSrcFrames * mDstRate) / mSrcRate);
+	dst.resize(numDst);
+	if (numDst == 0)
+		return;
+
+	//pad with silence so the filter can hang off either end
+	vector<float> padded(numSrcFrames + NUM_TAPS * 2, 0.f);
+	copy(src, src + numSrcFrames, padded.begin() + NUM_TAPS);
+	const float* in = &padded[NUM_TAPS];
+
+	bool useSSE = GetIsa() != Isa::SCALAR;
+	for (unsigned int n = 0; n < numDst; ++n)
+	{
+		double pos = n * mStep;
+		int i = static_cast<int>(pos);
+		int phase = static_cast<int>((pos - i) * NUM_PHASES + 0.5);
+		if (phase == NUM_PHASES)
+		{
+			phase = 0;
+			++i;
+		}
+		const float* window = in + i - (half - 1);
+		const float* taps = &mTaps[phase * NUM_TAPS];
+#ifdef AUDIOMIX_X86
+		if (useSSE)
+		{
+			dst[n] = DotSSE2(window, taps, NUM_TAPS);
+			continue;
+		}
+#endif
+		(void)useSSE;
+		dst[n] = DotScalar(window, taps, NUM_TAPS);
+	}
+}
+
+void PolyphaseResampler::Process(const float* src, unsigned int numSrcFrames, unsigned int numChannels, std::vector<float>& dst) const
+{
+	assert(numChannels > 0);
+	if (numChannels == 1)
+	{
+		Process(src, numSrcFrames, dst);
+		return;
+	}
+	//one channel at a time, then weave them back together
+	vector<float> chan(numSrcFrames), out;
+	for (unsigned int c = 0; c < numChannels; ++c)
+	{
+		for (unsigned int i = 0; i < numSrcFrames; ++i)
+			chan[i] = src[i * numChannels + c];
+		Process(chan.data(), numSrcFrames, out);
+		if (c == 0)
+			dst.resize(out.size() * numChannels);
+		for (size_t i = 0; i < out.size(); ++i)
+			dst[i * numChannels + c] = out[i];
+	}
+}
+
+
+//**************************************************************************************************
+//benchmark
+
+BenchResult Benchmark(Isa isa, unsigned int numVoices, unsigned int framesPerBlock, unsigned int numBlocks)
+{
+	assert(numVoices > 0 && framesPerBlock > 0 && numBlocks > 0);
+	Isa old = GetIsa();
+	SetIsa(isa);
+
+	//something that isn't silence for each voice, with its own volume and pan
+	vector<float> voices(numVoices * framesPerBlock);
+	vector<float> vols(numVoices), pans(numVoices);
+	for (unsigned int v = 0; v < numVoices; ++v)
+	{
+		for (unsigned int i = 0; i < framesPerBlock; ++i)
+			voices[v * framesPerBlock + i] = static_cast<float>(sin((i + v * 7) * 0.05));
+		vols[v] = 0.5f + 0.5f * (v % 3) / 2.f;
+		pans[v] = ((v % 5) - 2) / 2.f;
+	}
+	vector<float> bus(framesPerBlock * 2);
+	vector<int16_t> out(framesPerBlock * 2);
+
+	auto start = chrono::steady_clock::now();
+	for (unsigned int b = 0; b < numBlocks; ++b)
+	{
+		fill(bus.begin(), bus.end(), 0.f);
+		for (unsigned int v = 0; v < numVoices; ++v)
+		{
+			float left, right;
+			PanGains(vols[v], pans[v], 1.f, left, right);
+			MixMonoToStereo(bus.data(), &voices[v * framesPerBlock], framesPerBlock, left, right);
+		}
+		ApplyGain(bus.data(), framesPerBlock * 2, 1.f / numVoices);
+		FloatToInt16(bus.data(), out.data(), framesPerBlock * 2);
+	}
+	auto end = chrono::steady_clock::now();
+
+	BenchResult res;
+	res.isa = GetIsa();
+	res.numVoices = numVoices;
+	res.framesPerBlock = framesPerBlock;
+	res.numBlocks = numBlocks;
+	res.wallMs = chrono::duration<double, milli>(end - start).count();
+	res.voicesPerMs = (res.wallMs > 0) ? (numVoices * (double)numBlocks) / res.wallMs : 0;
+	SetIsa(old);
+	return res;
+}
+
+}
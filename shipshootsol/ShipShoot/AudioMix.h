@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/*
+Software mixing kernels. FMOD does its own mixing, but anything that
+mixes voices itself (offline rendering, tools) needs to sum lots of
+voices with a volume and pan each, change sample rates and convert the
+result to 16bit for output. The hot loops have SSE2 and AVX2 versions,
+the best one the cpu supports is picked once and used from then on.
+Every kernel also has a plain C++ version for other cpus and to check
+the vector versions against.
+
+Buffers are interleaved when stereo (LRLRLR), sample counts are always
+counts of floats, frame counts are counts of sample pairs (or single
+samples when mono).
+*/
+namespace AudioMix
+{
+	//which set of kernels is in use
+	enum class Isa { SCALAR, SSE2, AVX2 };
+	//what we are using, it's decided the first time it's asked for
+	Isa GetIsa();
+	//the best the cpu can do
+	Isa GetBestIsa();
+	//override the choice, asking for more than the cpu can do gets the best it can
+	void SetIsa(Isa isa);
+	const char* GetIsaName(Isa isa);
+
+	/*
+	Turn a voice volume and pan into left/right gains
+	vol		- 0->1, anything over cutOffVol is clamped (m_channelCutOffVol)
+	pan		- -1=left, 0=centre, 1=right, same as IAudioGroup::SetPan
+	*/
+	void PanGains(float vol, float pan, float cutOffVol, float& left, float& right);
+
+	//bus[i] *= gain
+	void ApplyGain(float* buf, unsigned int numSamples, float gain);
+	//add a mono voice into a stereo bus, each sample is scaled by left/right gain
+	void MixMonoToStereo(float* bus, const float* src, unsigned int numFrames, float left, float right);
+	//add a stereo voice into a stereo bus
+	void MixStereoToStereo(float* bus, const float* src, unsigned int numFrames, float left, float right);
+
+	/*
+	Cheap resampling by interpolating between neighbouring samples, good
+	enough for pitch shifting voices while they play.
+	src		- mono source
+	pos		- read position in source frames, updated as we go
+	step	- srcRate/dstRate (or pitch)
+	returns how many frames were written, less than numDstFrames if the source ran out
+	*/
+	unsigned int ResampleLinear(const float* src, unsigned int numSrcFrames, double& pos, double step,
+		float* dst, unsigned int numDstFrames);
+
+	/*
+	Higher quality rate conversion with a windowed sinc filter split into
+	phases. Used when converting a whole sound to the mixer rate up front
+	(e.g. 22kHz sfx to a 48kHz mix) so the cost doesn't matter per frame.
+	*/
+	class PolyphaseResampler
+	{
+	public:
+		enum { NUM_PHASES = 64, NUM_TAPS = 16 };
+		PolyphaseResampler(unsigned int srcRate, unsigned int dstRate);
+		//convert a whole mono buffer
+		void Process(const float* src, unsigned int numSrcFrames, std::vector<float>& dst) const;
+		//convert a whole interleaved buffer with this many channels
+		void Process(const float* src, unsigned int numSrcFrames, unsigned int numChannels, std::vector<float>& dst) const;
+		unsigned int GetSrcRate() const { return mSrcRate; }
+		unsigned int GetDstRate() const { return mDstRate; }
+	private:
+		unsigned int mSrcRate, mDstRate;
+		double mStep;				//source frames per output frame
+		float mCutoff;				//lowpass when shrinking so we don't alias
+		std::vector<float> mTaps;	//NUM_PHASES rows of NUM_TAPS coefficients
+	};
+
+	//float -1->1 to 16bit, anything outside the range is clipped not wrapped
+	void FloatToInt16(const float* src, int16_t* dst, unsigned int numSamples);
+	//and back again
+	void Int16ToFloat(const int16_t* src, float* dst, unsigned int numSamples);
+
+	/*
+	Time the mix loop, numVoices mono voices of framesPerBlock frames
+	each mixed into a stereo bus with their own volume and pan, then
+	converted to 16bit. A "voice" below is one voice's block mixed.
+	*/
+	struct BenchResult
+	{
+		Isa isa = Isa::SCALAR;
+		unsigned int numVoices = 0;
+		unsigned int framesPerBlock = 0;
+		unsigned int numBlocks = 0;
+		double wallMs = 0;		//wall clock (steady_clock), not cpu time
+		double voicesPerMs = 0;
+	};
+	BenchResult Benchmark(Isa isa, unsigned int numVoices, unsigned int framesPerBlock, unsigned int numBlocks);
+}
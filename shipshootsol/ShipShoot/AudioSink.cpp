@@ -0,0 +1,130 @@
+#include <cassert>
+#include <cmath>
+
+#include "AudioSink.h"
+
+using namespace std;
+
+bool WavFileSink::Open(const unsigned int rate, const unsigned int numChannels)
+{
+	assert(rate > 0 && numChannels > 0);
+	m_rate = rate;
+	m_numChannels = numChannels;
+	m_framesWritten = 0;
+	m_out.open(m_fileName.c_str(), ios::binary | ios::out | ios::trunc);
+	if (!m_out)
+		return false;
+	//sizes are filled in when we finish
+	WriteHeader(0);
+	return true;
+}
+
+double WavFileSink::Write(const int16_t *pSamples, const unsigned int numFrames, const uint64_t /*bufferIdx*/, const double mixedSec)
+{
+	if (m_out.is_open())
+	{
+		m_out.write(reinterpret_cast<const char*>(pSamples), numFrames * m_numChannels * sizeof(int16_t));
+		m_framesWritten += numFrames;
+	}
+	return mixedSec;
+}
+
+void WavFileSink::Close()
+{
+	if (!m_out.is_open())
+		return;
+	//now we know how big it is, go back and finish the header
+	WriteHeader(static_cast<uint32_t>(m_framesWritten * m_numChannels * sizeof(int16_t)));
+	m_out.close();
+}
+
+//a plain 44 byte header, 16bit pcm
+void WavFileSink::WriteHeader(const uint32_t dataBytes)
+{
+	auto put32 = [this](uint32_t v) { m_out.write(reinterpret_cast<const char*>(&v), 4); };
+	auto put16 = [this](uint16_t v) { m_out.write(reinterpret_cast<const char*>(&v), 2); };
+	const uint16_t bits = 16;
+	m_out.seekp(0, ios::beg);
+	m_out.write("RIFF", 4);
+	put32(36 + dataBytes);
+	m_out.write("WAVEfmt ", 8);
+	put32(16);
+	put16(1);	//pcm
+	put16(static_cast<uint16_t>(m_numChannels));
+	put32(m_rate);
+	put32(m_rate * m_numChannels * bits / 8);
+	put16(static_cast<uint16_t>(m_numChannels * bits / 8));
+	put16(bits);
+	m_out.write("data", 4);
+	put32(dataBytes);
+	m_out.seekp(0, ios::end);
+}
+
+
+
+bool LatencyCheckSink::Open(const unsigned int rate, const unsigned int numChannels)
+{
+	m_rate = rate;
+	m_playing = false;
+	m_startSec = 0;
+	m_writeFrame = 0;
+	for (auto &s : m_sent)
+		s = Sent();
+	m_numChecked = m_numFailed = m_numUnderruns = 0;
+	m_worstErrorSec = 0;
+	return m_next ? m_next->Open(rate, numChannels) : true;
+}
+
+//the buffers in front of this one have to play out first
+double LatencyCheckSink::Write(const int16_t *pSamples, const unsigned int numFrames, const uint64_t bufferIdx, const double mixedSec)
+{
+	if (m_next)
+		m_next->Write(pSamples, numFrames, bufferIdx, mixedSec);
+	if (!m_playing)
+	{
+		//the card starts on its silence as the first buffer arrives
+		m_playing = true;
+		m_startSec = mixedSec;
+		m_writeFrame = static_cast<uint64_t>(m_queuedBuffers) * numFrames;
+	}
+	double cursor = (mixedSec - m_startSec) * m_rate;
+	if (cursor > m_writeFrame)
+	{
+		++m_numUnderruns;
+		m_writeFrame = static_cast<uint64_t>(ceil(cursor));
+	}
+	Sent &s = m_sent[bufferIdx % HISTORY];
+	s.bufferIdx = bufferIdx;
+	s.startFrame = m_writeFrame;
+	s.numFrames = numFrames;
+	m_writeFrame += numFrames;
+	//all a driver knows is how much is in front of it
+	return mixedSec + (s.startFrame - cursor) / m_rate;
+}
+
+void LatencyCheckSink::Close()
+{
+	if (m_next)
+		m_next->Close();
+}
+
+void LatencyCheckSink::OnLatency(const AudioLatencyProbe::Record &rec)
+{
+	++m_numChecked;
+	const Sent &s = m_sent[rec.bufferIdx % HISTORY];
+	if (s.bufferIdx != rec.bufferIdx || rec.frameOffset >= s.numFrames)
+	{
+		//the probe is talking about a buffer we never sent, or past the end of one
+		++m_numFailed;
+		return;
+	}
+	//when the cursor gets to the sound's first frame
+	double expected = m_startSec + (s.startFrame + rec.frameOffset) / (double)m_rate;
+	double err = fabs(rec.audibleSec - expected);
+	if (err > m_worstErrorSec)
+		m_worstErrorSec = err;
+	//a microsecond is far below a frame at any rate we use
+	bool ok = err < 1e-6 && rec.triggerSec <= rec.pickupSec && rec.pickupSec <= rec.audibleSec;
+	if (!ok)
+		++m_numFailed;
+}
@@ -0,0 +1,98 @@
+#ifndef AUDIOSINK_H
+#define AUDIOSINK_H
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "AudioLatency.h"
+
+/*
+Where a software mixer sends its output, one buffer at a time. Telling
+the mixer when each buffer will actually be heard is the sink's job,
+only it knows how much is queued up in front of it.
+*/
+class IAudioSink
+{
+public:
+	virtual ~IAudioSink() {}
+	virtual bool Open(const unsigned int rate, const unsigned int numChannels) = 0;
+	//interleaved 16bit, mixedSec is when the mixer made it on its own clock
+	//returns when the first frame of the buffer will be heard on that clock
+	virtual double Write(const int16_t *pSamples, const unsigned int numFrames, const uint64_t bufferIdx, const double mixedSec) = 0;
+	virtual void Close() = 0;
+};
+
+//straight into a 16bit wav file, nothing is queued so it's heard as soon as it's mixed
+class WavFileSink : public IAudioSink
+{
+public:
+	explicit WavFileSink(const std::string &fileName) : m_fileName(fileName) {}
+	~WavFileSink() { Close(); }
+	bool Open(const unsigned int rate, const unsigned int numChannels);
+	double Write(const int16_t *pSamples, const unsigned int numFrames, const uint64_t bufferIdx, const double mixedSec);
+	void Close();
+	const std::string &GetFileName() const { return m_fileName; }
+private:
+	std::string m_fileName;
+	std::ofstream m_out;
+	unsigned int m_rate = 0;
+	unsigned int m_numChannels = 0;
+	uint64_t m_framesWritten = 0;
+
+	void WriteHeader(const uint32_t dataBytes);
+};
+
+/*
+For checking the latency numbers add up. It pretends to be a sound card:
+a queue that starts with queuedBuffers buffers of silence in it and a
+play cursor that moves through it at the sample rate as the offline clock
+(mixedSec) moves on. Write says when a buffer will be heard from how much
+is queued in front of the cursor, the way a driver would. Each measurement
+is then checked against where the sound's first frame really is in what's
+been played, not against what Write said, so a measurement that went to
+the wrong buffer or was given the wrong time shows up. If the cursor runs
+past the end of the queue the card fills the gap with silence, which is
+counted. Hook it up as the latency probe's listener and it checks every
+measurement as it arrives. Output is passed on to another sink if there
+is one.
+*/
+class LatencyCheckSink : public IAudioSink, public AudioLatencyProbe::IListener
+{
+public:
+	LatencyCheckSink(const unsigned int queuedBuffers, std::shared_ptr<IAudioSink> next = nullptr)
+		: m_queuedBuffers(queuedBuffers), m_next(next) {}
+	bool Open(const unsigned int rate, const unsigned int numChannels);
+	double Write(const int16_t *pSamples, const unsigned int numFrames, const uint64_t bufferIdx, const double mixedSec);
+	void Close();
+	void OnLatency(const AudioLatencyProbe::Record &rec);
+
+	uint64_t GetNumChecked() const { return m_numChecked; }
+	uint64_t GetNumFailed() const { return m_numFailed; }
+	//biggest difference between what the probe said and what it should have said
+	double GetWorstErrorSec() const { return m_worstErrorSec; }
+	//times the mixer fell behind and the card played silence
+	uint64_t GetNumUnderruns() const { return m_numUnderruns; }
+private:
+	enum { HISTORY = 64 };	//buffers we remember, measurements always arrive straight after their buffer
+	struct Sent
+	{
+		uint64_t bufferIdx = UINT64_MAX;
+		uint64_t startFrame = 0;	//where it went in everything the card plays, silence included
+		unsigned int numFrames = 0;
+	};
+	unsigned int m_queuedBuffers;
+	std::shared_ptr<IAudioSink> m_next;
+	unsigned int m_rate = 0;
+	bool m_playing = false;
+	double m_startSec = 0;		//when the card started on the silence it was primed with
+	uint64_t m_writeFrame = 0;	//where the next buffer goes
+	Sent m_sent[HISTORY];
+	uint64_t m_numChecked = 0;
+	uint64_t m_numFailed = 0;
+	uint64_t m_numUnderruns = 0;
+	double m_worstErrorSec = 0;
+};
+
+#endif
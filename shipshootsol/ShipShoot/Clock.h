@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+/*
+The one clock everything times itself with: 64 bit nanoseconds on the
+monotonic clock, so it never goes backwards or loses precision however
+long the game runs. No Win32 calls, steady_clock is QueryPerformanceCounter
+underneath on windows and CLOCK_MONOTONIC on linux, both the same here.
+Only differences are meaningful, zero is some arbitrary point in the past.
+Keep times as integers and only convert to seconds for display or for
+physics that wants a float step.
+*/
+namespace Clock
+{
+
+const int64_t NS_PER_US = 1000;
+const int64_t NS_PER_MS = 1000000;
+const int64_t NS_PER_SEC = 1000000000;
+
+inline int64_t NowNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//rounded to the nearest nanosecond, so a float step converts back exactly
+constexpr int64_t FromSec(double sec)
+{
+	return static_cast<int64_t>(sec * NS_PER_SEC + (sec < 0 ? -0.5 : 0.5));
+}
+constexpr int64_t FromMs(double ms)
+{
+	return static_cast<int64_t>(ms * NS_PER_MS + (ms < 0 ? -0.5 : 0.5));
+}
+constexpr double ToSec(int64_t ns)
+{
+	return ns / static_cast<double>(NS_PER_SEC);
+}
+constexpr double ToMs(int64_t ns)
+{
+	return ns / static_cast<double>(NS_PER_MS);
+}
+
+}
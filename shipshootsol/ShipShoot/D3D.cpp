@@ -26,7 +26,11 @@ void MyD3D::BeginRender(const Vector4 & colour)
 
 void MyD3D::EndRender()
 {
-	HR(mpSwapChain->Present(0, 0));
+	//nobody's looking, just make sure the work gets done
+	if (mHeadless)
+		mpd3dImmediateContext->Flush();
+	else
+		HR(mpSwapChain->Present(0, 0));
 }
 
 
@@ -106,6 +110,15 @@ void MyD3D::CreateD3D( D3D_FEATURE_LEVEL desiredFeatureLevel)
 
 	md3dDriverType = D3D_DRIVER_TYPE_UNKNOWN;
 	//md3dDriverType = D3D_DRIVER_TYPE_HARDWARE;
+	if (mHeadless)
+	{
+		//the cpu rasteriser, works the same on any machine with or without a gpu
+		md3dDriverType = D3D_DRIVER_TYPE_WARP;
+		D3D_FEATURE_LEVEL featureLevel;
+		HR(D3D11CreateDevice(nullptr, md3dDriverType, 0, createDeviceFlags, 0, 0, D3D11_SDK_VERSION,
+			&mpd3dDevice, &featureLevel, &mpd3dImmediateContext));
+		return;
+	}
 
 	//figure out how many gpus we have
 	IDXGIAdapter * pAdapter;
@@ -250,10 +263,11 @@ void MyD3D::OnResize_Default(int clientWidth, int clientHeight)
 }
 
 
-bool MyD3D::InitDirect3D(void(*pOnResize)(int,int,MyD3D&))
+bool MyD3D::InitDirect3D(void(*pOnResize)(int,int,MyD3D&), bool headless)
 {
 	assert(pOnResize);
 	mpOnResize = pOnResize;
+	mHeadless = headless;
 
 	// Create the device and device context.
 	CreateD3D();
@@ -11,7 +11,8 @@ class MyD3D
 public:
 
 	//main start up function
-	bool InitDirect3D(void(*pOnResize)(int, int, MyD3D&));
+	//headless - render on the cpu (WARP) and never Present, for automated runs
+	bool InitDirect3D(void(*pOnResize)(int, int, MyD3D&), bool headless = false);
 	//default minimum behaviour when ALT+ENTER or drag or resize
 	//parameters are new width and height of window
 	void OnResize_Default(int clientWidth, int clientHeight);
@@ -34,6 +35,7 @@ public:
 	bool GetDeviceReady() const {
 		return mpd3dDevice!=nullptr;
 	}
+	bool IsHeadless() const { return mHeadless; }
 	//see mpOnResize
 	void OnResize(int sw, int sh, MyD3D& d3d) {
 		assert(mpOnResize);
@@ -56,6 +58,8 @@ private:
 	bool mEnable4xMsaa = true;
 	//running in a window?
 	bool mWindowed = false;
+	//software rendering, nothing gets presented
+	bool mHeadless = false;
 	//main handle used to create resources and access D3D
 	ID3D11Device* mpd3dDevice = nullptr;
 	//a handle off the device we can use to give rendering commands
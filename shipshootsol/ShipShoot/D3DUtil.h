@@ -104,8 +104,4 @@ inline bool Equals(float a, float b)
 	return (fabs(a-b) < VERY_SMALL) ? true : false;
 }
 
-//knowing the time always comes in handy
-float GetClock();
-void AddSecToClock(float sec);
-
 
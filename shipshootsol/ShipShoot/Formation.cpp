@@ -0,0 +1,120 @@
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "Formation.h"
+
+using namespace DirectX;
+using namespace DirectX::SimpleMath;
+
+//index of the highest set bit, bits mustn't be 0
+static int HighestBit(uint64_t bits)
+{
+#ifdef _MSC_VER
+	unsigned long idx;
+	_BitScanReverse64(&idx, bits);
+	return static_cast<int>(idx);
+#else
+	return 63 - __builtin_clzll(bits);
+#endif
+}
+
+void Formation::Init(const RenderProxy& proto, const Vector2& origin, const Vector2& spacing, int numCols, int numRows)
+{
+	assert(numRows <= MAX_ROWS && spacing.x > 0 && spacing.y > 0);
+	mProto = proto;
+	mOffset = origin;
+	mDirection = 1;
+	mSpacing = spacing;
+	mNumCols = numCols;
+	mNumRows = numRows;
+	mLocal.clear();
+	for (int row = 0; row < numRows; ++row)
+		for (int col = 0; col < numCols; ++col)
+			mLocal.push_back(Vector2(col * spacing.x, row * spacing.y));
+	mColBits.assign(numCols, numRows == MAX_ROWS ? ~0ull : (1ull << numRows) - 1);
+	mNumAlive = static_cast<int>(mLocal.size());
+	mMinCol = 0;
+	mMaxCol = mNumAlive ? numCols - 1 : -1;
+}
+
+void Formation::Update(float dTime, const RECTF& playArea)
+{
+	if (mNumAlive == 0)
+		return;
+	mOffset.x += mSpeed * mDirection * dTime;
+	//the left of the outermost column is what has to reach the side
+	if ((mDirection > 0 && mOffset.x + mLocal[mMaxCol].x > playArea.right) ||
+		(mDirection < 0 && mOffset.x + mLocal[mMinCol].x < playArea.left))
+	{
+		mDirection = -mDirection;
+		mOffset.y += DROP;
+	}
+}
+
+void Formation::Kill(int slot)
+{
+	assert(IsAlive(slot));
+	uint64_t& bits = mColBits[slot % mNumCols];
+	bits &= ~(1ull << (slot / mNumCols));
+	--mNumAlive;
+	//only the last one out of an end column moves that end in
+	if (bits)
+		return;
+	while (mMinCol <= mMaxCol && mColBits[mMinCol] == 0)
+		++mMinCol;
+	while (mMaxCol >= mMinCol && mColBits[mMaxCol] == 0)
+		--mMaxCol;
+}
+
+int Formation::HitTest(const Vector2& pos, const Vector2& size) const
+{
+	if (mNumAlive == 0)
+		return -1;
+	//the rows and columns with enemies that could reach the box, with one
+	//spare either side: the range is worked out from pos - mOffset and the
+	//overlap check from mOffset + mLocal, which don't round the same, so a
+	//box just touching an edge can't be missed. The overlap check is exact
+	Vector2 enemySize = GetEnemySize();
+	Vector2 local = pos - mOffset;
+	int firstCol = (std::max)(static_cast<int>(std::floor((local.x - enemySize.x) / mSpacing.x)) - 1, mMinCol);
+	int lastCol = (std::min)(static_cast<int>(std::floor((local.x + size.x) / mSpacing.x)) + 1, mMaxCol);
+	int firstRow = (std::max)(static_cast<int>(std::floor((local.y - enemySize.y) / mSpacing.y)) - 1, 0);
+	int lastRow = (std::min)(static_cast<int>(std::floor((local.y + size.y) / mSpacing.y)) + 1, mNumRows - 1);
+	//later slots first, the same one a scan from the back would find
+	for (int row = lastRow; row >= firstRow; --row)
+		for (int col = lastCol; col >= firstCol; --col)
+		{
+			if (!((mColBits[col] >> row) & 1))
+				continue;
+			int slot = row * mNumCols + col;
+			Vector2 enemyPos = GetPos(slot);
+			if (pos.x < enemyPos.x + enemySize.x &&
+				pos.x + size.x > enemyPos.x &&
+				pos.y < enemyPos.y + enemySize.y &&
+				pos.y + size.y > enemyPos.y)
+				return slot;
+		}
+	return -1;
+}
+
+int Formation::GetFront(int col) const
+{
+	uint64_t bits = mColBits[col];
+	return bits ? HighestBit(bits) * mNumCols + col : -1;
+}
+
+void Formation::Render(SpriteBatch& batch, const TexCache& cache) const
+{
+	RenderProxy proxy = mProto;
+	for (int slot = 0; slot < GetNumSlots(); ++slot)
+	{
+		if (!IsAlive(slot))
+			continue;
+		proxy.mPos = GetPos(slot);
+		proxy.Draw(batch, cache);
+	}
+}
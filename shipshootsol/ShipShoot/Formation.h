@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "RenderTypes.h"
+
+/*
+The block of ordinary enemies marching side to side. They all move
+together so the block is one transform, an offset, a direction and a
+speed, and each enemy is a slot with a fixed place relative to it in a
+numCols x numRows lattice. A tick only moves the offset, however many
+are left, and where a slot is on screen is worked out when a collision,
+a shot or the renderer asks. It turns round when its outermost occupied
+column reaches a side, the columns at either end are kept up to date as
+enemies die so checking is two compares. Bosses aren't in here, they
+go their own way.
+Who's alive is a bitboard, a 64 bit word per column with a bit for
+each row. A box is turned into the few rows and columns it could touch
+arithmetically and each of those is a bit test before the real overlap
+check, and the front (lowest) one left in a column is a bit scan.
+*/
+class Formation
+{
+public:
+	//what shooting one is worth, rows fit in a column's word
+	enum { SCORE = 10, MAX_ROWS = 64 };
+	//how far it comes down each time it reaches a side
+	static constexpr float DROP = 20;
+
+	//a full lattice with the top left one at origin, slot = row * numCols + col
+	void Init(const RenderProxy& proto, const DirectX::SimpleMath::Vector2& origin, const DirectX::SimpleMath::Vector2& spacing, int numCols, int numRows);
+	//pixels a second
+	void SetSpeed(float speed) { mSpeed = speed; }
+	//across at the current speed, then down if it's gone past a side of playArea
+	void Update(float dTime, const RECTF& playArea);
+
+	int GetNumSlots() const { return static_cast<int>(mLocal.size()); }
+	int GetNumAlive() const { return mNumAlive; }
+	bool IsEmpty() const { return mNumAlive == 0; }
+	int GetNumCols() const { return mNumCols; }
+	bool IsAlive(int slot) const { return (mColBits[slot % mNumCols] >> (slot / mNumCols)) & 1; }
+	//top left of a slot on screen
+	DirectX::SimpleMath::Vector2 GetPos(int slot) const { return mOffset + mLocal[slot]; }
+	//on screen, they're all the same
+	DirectX::SimpleMath::Vector2 GetEnemySize() const { return mProto.GetScreenSize(); }
+	void Kill(int slot);
+	//an alive slot the box overlaps, later slots are tried first, -1 if none
+	int HitTest(const DirectX::SimpleMath::Vector2& pos, const DirectX::SimpleMath::Vector2& size) const;
+	//the lowest alive slot in a column, the one with nothing in front, -1 if it's empty
+	int GetFront(int col) const;
+	void Render(DirectX::SpriteBatch& batch, const TexCache& cache) const;
+private:
+	RenderProxy mProto;		//what each one looks like, its mPos isn't used
+	DirectX::SimpleMath::Vector2 mOffset = DirectX::SimpleMath::Vector2(0, 0);	//where the lattice has got to
+	float mSpeed = 0;
+	int mDirection = 1;
+	DirectX::SimpleMath::Vector2 mSpacing = DirectX::SimpleMath::Vector2(0, 0);
+	int mNumCols = 0, mNumRows = 0;
+	std::vector<DirectX::SimpleMath::Vector2> mLocal;	//each slot from mOffset, fixed by Init
+	std::vector<uint64_t> mColBits;	//bit row is set if that row of the column is alive
+	int mMinCol = 0, mMaxCol = -1;	//outermost columns with anything left
+	int mNumAlive = 0;
+};
@@ -0,0 +1,104 @@
+#include <cassert>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+#include <algorithm>
+
+#include "FrameArena.h"
+
+using namespace std;
+
+FrameArena::FrameArena(size_t capacity)
+	: mpBuffer(new uint8_t[capacity]), mCapacity(capacity)
+{
+}
+
+void* FrameArena::Alloc(size_t numBytes, size_t align)
+{
+	assert(align && (align & (align - 1)) == 0);
+	uintptr_t base = reinterpret_cast<uintptr_t>(mpBuffer.get());
+	size_t start = ((base + mUsed + align - 1) & ~(align - 1)) - base;
+	if (start + numBytes <= mCapacity)
+	{
+		mUsed = start + numBytes;
+		return mpBuffer.get() + start;
+	}
+	//full, the heap will have to do until the next reset
+	++mNumOverflows;
+	mOverflow.push_back(unique_ptr<uint8_t[]>(new uint8_t[numBytes + align]));
+	uintptr_t p = reinterpret_cast<uintptr_t>(mOverflow.back().get());
+	return reinterpret_cast<void*>((p + align - 1) & ~(align - 1));
+}
+
+const char* FrameArena::Format(const char* pFmt, ...)
+{
+	va_list args;
+	va_start(args, pFmt);
+	va_list copy;
+	va_copy(copy, args);
+	int len = vsnprintf(nullptr, 0, pFmt, copy);
+	va_end(copy);
+	char* pText = AllocArray<char>(len > 0 ? len + 1 : 1);
+	if (len > 0)
+		vsnprintf(pText, len + 1, pFmt, args);
+	else
+		*pText = 0;
+	va_end(args);
+	return pText;
+}
+
+const wchar_t* FrameArena::Format(const wchar_t* pFmt, ...)
+{
+	//no way to ask how long it'll be, so print into scratch and copy in exactly
+	//what it came to, only text too long for the stack has to try the heap
+	const size_t SCRATCH_LEN = 512, MAX_LEN = 64 * 1024;
+	wchar_t scratch[SCRATCH_LEN];
+	unique_ptr<wchar_t[]> pBig;
+	wchar_t* pScratch = scratch;
+	int len = -1;
+	va_list args;
+	va_start(args, pFmt);
+	for (size_t tryLen = SCRATCH_LEN; len < 0 && tryLen <= MAX_LEN; tryLen *= 2)
+	{
+		if (tryLen > SCRATCH_LEN)
+		{
+			pBig.reset(new wchar_t[tryLen]);
+			pScratch = pBig.get();
+		}
+		va_list copy;
+		va_copy(copy, args);
+		len = vswprintf(pScratch, tryLen, pFmt, copy);
+		va_end(copy);
+	}
+	va_end(args);
+	//not something that can be printed, or far too long
+	if (len < 0)
+		len = 0;
+	wchar_t* pText = AllocArray<wchar_t>(len + 1);
+	memcpy(pText, pScratch, len * sizeof(wchar_t));
+	pText[len] = 0;
+	return pText;
+}
+
+void FrameArena::Reset()
+{
+	mHighWater = max(mHighWater, mUsed);
+#ifdef _DEBUG
+	memset(mpBuffer.get(), POISON, mUsed);
+#endif
+	mUsed = 0;
+	mOverflow.clear();
+}
+
+FrameArena& FrameArena::GetFrame()
+{
+	static FrameArena sArena(FRAME_CAPACITY);
+	return sArena;
+}
+
+FrameArena& FrameArena::GetTick()
+{
+	static FrameArena sArena(TICK_CAPACITY);
+	return sArena;
+}
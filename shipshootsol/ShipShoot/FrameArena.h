@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <string>
+
+/*
+Scratch memory that only has to last until the end of a frame (or a
+tick). Allocating is bumping an offset, nothing is freed one at a time,
+Reset throws the lot away at once. Anything that needs a string or a
+container for a moment (text to draw, a list to sort) takes it from
+here instead of the heap. If it runs out it falls back to the heap and
+counts it, so the capacity can be raised, those blocks go on Reset too.
+In debug builds Reset fills what was used with POISON so anything still
+holding on to last frame's memory shows up as 0xdddddddd garbage.
+The game resets GetFrame after each Render and GetTick before each
+simulation tick. Main thread only.
+*/
+class FrameArena
+{
+public:
+	enum { FRAME_CAPACITY = 64 * 1024, TICK_CAPACITY = 64 * 1024 };
+	static const uint8_t POISON = 0xdd;
+
+	explicit FrameArena(size_t capacity);
+	FrameArena(const FrameArena&) = delete;
+	void operator=(const FrameArena&) = delete;
+
+	void* Alloc(size_t numBytes, size_t align = alignof(std::max_align_t));
+	template<typename T>
+	T* AllocArray(size_t num)
+	{
+		return static_cast<T*>(Alloc(num * sizeof(T), alignof(T)));
+	}
+	//printf into the arena, e.g. text for SpriteFont::DrawString
+	const char* Format(const char* pFmt, ...);
+	const wchar_t* Format(const wchar_t* pFmt, ...);
+	//everything handed out so far is gone
+	void Reset();
+
+	size_t GetUsed() const { return mUsed; }
+	size_t GetCapacity() const { return mCapacity; }
+	//most used between two resets, and how often it had to go to the heap
+	size_t GetHighWater() const { return mHighWater > mUsed ? mHighWater : mUsed; }
+	uint64_t GetNumOverflows() const { return mNumOverflows; }
+
+	//the game's two, see above
+	static FrameArena& GetFrame();
+	static FrameArena& GetTick();
+private:
+	std::unique_ptr<uint8_t[]> mpBuffer;
+	size_t mCapacity;
+	size_t mUsed = 0;
+	size_t mHighWater = 0;
+	uint64_t mNumOverflows = 0;
+	std::vector<std::unique_ptr<uint8_t[]>> mOverflow;
+};
+
+/*
+So standard containers can live in an arena. Freeing does nothing, the
+memory comes back when the arena is reset, which had better be after
+the container has gone.
+*/
+template<typename T>
+class ArenaAllocator
+{
+public:
+	typedef T value_type;
+	ArenaAllocator(FrameArena& arena) : mpArena(&arena) {}
+	template<typename U>
+	ArenaAllocator(const ArenaAllocator<U>& rhs) : mpArena(rhs.mpArena) {}
+	T* allocate(size_t num) { return mpArena->AllocArray<T>(num); }
+	void deallocate(T*, size_t) {}
+	template<typename U>
+	bool operator==(const ArenaAllocator<U>& rhs) const { return mpArena == rhs.mpArena; }
+	template<typename U>
+	bool operator!=(const ArenaAllocator<U>& rhs) const { return mpArena != rhs.mpArena; }
+private:
+	template<typename U> friend class ArenaAllocator;
+	FrameArena* mpArena;
+};
+
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+using ArenaString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+using ArenaWString = std::basic_string<wchar_t, std::char_traits<wchar_t>, ArenaAllocator<wchar_t>>;
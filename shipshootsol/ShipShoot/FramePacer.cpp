@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <timeapi.h>
+#endif
+
+#include "FramePacer.h"
+#include "Stats.h"
+#include "Clock.h"
+#include "Profiler.h"
+
+using namespace std;
+
+//the spin margin stays within these, even a perfect scheduler gets a little
+static const int64_t MIN_SPIN_NS = 100000;
+static const int64_t MAX_SPIN_NS = 4000000;
+//how quickly the oversleep estimate follows changes
+static const double OVERSLEEP_BLEND = 0.1;
+
+FramePacer::FramePacer()
+	: mSpinNs(MAX_SPIN_NS / 2), mFrameHist(Stats::Get().GetHistogram("frame_ms"))
+{
+#ifdef _WIN32
+	//without this a 1ms sleep can take 15ms
+	mFineTimer = timeBeginPeriod(1) == TIMERR_NOERROR;
+#endif
+}
+
+FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+	if (mFineTimer)
+		timeEndPeriod(1);
+#endif
+}
+
+void FramePacer::SetTargetHz(double hz)
+{
+	mPeriodNs = hz > 0 ? static_cast<int64_t>(Clock::NS_PER_SEC / hz) : 0;
+	mDeadlineNs = 0;
+}
+
+void FramePacer::Reset()
+{
+	mDeadlineNs = 0;
+	mLastFrameNs = 0;
+}
+
+float FramePacer::Wait()
+{
+	if (mPeriodNs > 0)
+	{
+		PROFILE_ZONE("FramePacer::Wait");
+		int64_t now = Clock::NowNs();
+		int64_t deadline = mDeadlineNs + mPeriodNs;
+		//first frame, or well behind, start the cadence again from now rather
+		//than squeezing the next frame to catch up, that's a second hitch
+		if (mDeadlineNs == 0 || now - deadline > mPeriodNs / 2)
+			deadline = now;
+		if (now < deadline)
+			SleepUntil(deadline);
+		else
+			mLastSpinNs = 0;
+		mDeadlineNs = deadline;
+	}
+
+	int64_t end = Clock::NowNs();
+	int64_t frameNs = mLastFrameNs ? end - mLastFrameNs : 0;
+	mLastFrameNs = end;
+	if (frameNs <= 0)
+		return 0;
+	float ms = static_cast<float>(Clock::ToMs(frameNs));
+	mFrameHist.Add(ms);
+	mRecentMs[mNextRecent] = ms;
+	mNextRecent = (mNextRecent + 1) % WINDOW;
+	mNumRecent = min<unsigned int>(mNumRecent + 1, WINDOW);
+	return static_cast<float>(Clock::ToSec(frameNs));
+}
+
+void FramePacer::SleepUntil(int64_t deadlineNs)
+{
+	//sleep in as few goes as possible, stopping a margin short each time
+	for (;;)
+	{
+		int64_t now = Clock::NowNs();
+		int64_t request = deadlineNs - now - mSpinNs;
+		if (request <= 0)
+			break;
+		this_thread::sleep_for(chrono::nanoseconds(request));
+		double over = static_cast<double>(Clock::NowNs() - now - request);
+		mOversleepNs += (over - mOversleepNs) * OVERSLEEP_BLEND;
+		mOversleepDevNs += (fabs(over - mOversleepNs) - mOversleepDevNs) * OVERSLEEP_BLEND;
+		mSpinNs = clamp(static_cast<int64_t>(mOversleepNs + 4 * mOversleepDevNs), MIN_SPIN_NS, MAX_SPIN_NS);
+	}
+	//the last bit can't be trusted to a sleep
+	int64_t spinStart = Clock::NowNs();
+	while (Clock::NowNs() < deadlineNs)
+		this_thread::yield();
+	mLastSpinNs = Clock::NowNs() - spinStart;
+}
+
+double FramePacer::GetFrameMsPercentile(double percent) const
+{
+	if (mNumRecent == 0)
+		return 0;
+	copy(mRecentMs, mRecentMs + mNumRecent, mScratch);
+	size_t idx = min<size_t>(mNumRecent - 1, static_cast<size_t>(percent / 100 * mNumRecent));
+	nth_element(mScratch, mScratch + idx, mScratch + mNumRecent);
+	return mScratch[idx];
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Clock.h"
+
+class Histogram;
+
+/*
+Holds each frame to a target rate without burning the cpu. Most of the
+wait is an OS sleep, which is cheap but wakes late by an unpredictable
+amount, so it stops short of the deadline by a margin and spins the
+rest. The margin follows how late sleeps have actually been waking up
+recently, a machine with a sloppy scheduler spins a bit longer, a good
+one hardly at all. Deadlines are a fixed cadence, a frame that's a
+little late doesn't push every later one back, but one that's more than
+half a frame late starts the cadence again rather than rushing the next.
+The last WINDOW frame times are kept for runtime percentiles, every
+frame also goes into the "frame_ms" stats histogram.
+*/
+class FramePacer
+{
+public:
+	enum { WINDOW = 256 };
+	FramePacer();
+	~FramePacer();
+	//0 = don't wait at all, run as fast as possible
+	void SetTargetHz(double hz);
+	double GetTargetHz() const { return mPeriodNs ? Clock::NS_PER_SEC / static_cast<double>(mPeriodNs) : 0; }
+	//call once a frame when it's done, waits for the deadline and
+	//returns the seconds since the last call (0 the first time)
+	float Wait();
+	//forget the last frame, e.g. after being paused
+	void Reset();
+
+	//of the last WINDOW frames, e.g. 50, 95, 99
+	double GetFrameMsPercentile(double percent) const;
+	//how early sleeps are stopped, how much was spun last frame
+	double GetSpinMarginMs() const { return Clock::ToMs(mSpinNs); }
+	double GetLastSpinMs() const { return Clock::ToMs(mLastSpinNs); }
+private:
+	int64_t mPeriodNs = 0;
+	int64_t mDeadlineNs = 0;
+	int64_t mLastFrameNs = 0;
+	//oversleep tracking, average and average deviation
+	double mOversleepNs = 0, mOversleepDevNs = 0;
+	int64_t mSpinNs;
+	int64_t mLastSpinNs = 0;
+	float mRecentMs[WINDOW];
+	unsigned int mNumRecent = 0, mNextRecent = 0;
+	//percentiles are found in here so asking doesn't allocate
+	mutable float mScratch[WINDOW];
+	Histogram& mFrameHist;
+	bool mFineTimer = false;
+
+	void SleepUntil(int64_t deadlineNs);
+};
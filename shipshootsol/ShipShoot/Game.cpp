@@ -1,24 +1,32 @@
 #include "Game.h"
 #include "WindowUtils.h"
 #include "CommonStates.h"
-#include <random>
+#include <cmath>
 #include <memory>
 #include <SpriteFont.h>
-#include <fstream>
-#include <sstream>
 #include "AudioMgrFMOD.h"
-#include <filesystem>
+#include "AssetArchive.h"
+#include "Stats.h"
+#include "Clock.h"
+#include "Profiler.h"
+#include "AllocTracker.h"
+#include "FrameArena.h"
 
 
 using namespace std;
 using namespace DirectX;
 using namespace DirectX::SimpleMath;
 
-MouseAndKeys Game::sMKIn;
-Gamepads Game::sGamepads;
 
-//random number engine
-default_random_engine randEngine;
+//from the asset archive if there is one, otherwise the loose file
+static shared_ptr<SpriteFont> LoadFont(MyD3D& d3d, const string& fileName)
+{
+	AssetArchive::Slice slice = AssetArchive::Get().Find(fileName);
+	if (slice)
+		return make_shared<SpriteFont>(&d3d.GetDevice(), slice.pData, slice.size);
+	wstring ws(fileName.begin(), fileName.end());
+	return make_shared<SpriteFont>(&d3d.GetDevice(), ws.c_str());
+}
 
 const RECTF missileSpin[]{
 	{ 0,  0, 53, 48},
@@ -34,13 +42,14 @@ const RECTF thrustAnim[]{
 	{ 48, 0, 64, 16 },
 };
 
-Game::Game(MyD3D& d3d)
-	: mPMode(nullptr), mD3D(d3d), mpSB(nullptr), mTitleSprite(mD3D), mGameOverBackgroundSprite(mD3D),
-	mSpriteFont(std::make_shared<SpriteFont>(&d3d.GetDevice(), L"data\\fonts\\comic.spritefont"))
+Game::Game(MyD3D& d3d, std::unique_ptr<IInputSource> input, std::shared_ptr<IAudioMgr> audio)
+	: mD3D(d3d), mpSB(nullptr), mTitleSprite(mD3D), mGameOverBackgroundSprite(mD3D),
+	mSpriteFont(LoadFont(d3d, "data\\fonts\\comic.spritefont")), mAudio(audio), mpInput(move(input)), mOverlay(d3d)
 {
-	sMKIn.Initialise(WinUtil::Get().GetMainWnd(), true, false);
-	sGamepads.Initialise();
+	assert(mpInput);
+	mVirtualClock = !mpInput->IsRealTime();
 	mpSB = new SpriteBatch(&mD3D.GetDeviceCtx());
+	mpStates = new CommonStates(&mD3D.GetDevice());
 
 	auto* titleTexture = mD3D.GetCache().LoadTexture(&mD3D.GetDevice(), "title.dds");
 	mTitleSprite.SetTex(*titleTexture);
@@ -52,28 +61,133 @@ Game::Game(MyD3D& d3d)
 	mGameOverBackgroundSprite.SetScale(Vector2(1, 1));
 	mGameOverBackgroundSprite.mPos = Vector2(0, 0);
 
-	mKeysPressed.resize(VK_Z + 1);
-
 	File::initialiseSystem();
-	mAudio = std::make_shared<AudioMgrFMOD>();
+	if (!mAudio)
+		mAudio = std::make_shared<AudioMgrFMOD>();
 	mAudio->Initialise();
 
-	if (filesystem::exists("highscores.txt"))
+	//share the machine's leaderboard if there's a server running, otherwise keep our own
+	mUseServer = mLbClient.Connect(LEADERBOARD_SOCKET);
+	if (mUseServer)
+		CallServer("", 0, false);
+	else
+		OpenLocalLeaderboard();
+}
+
+void Game::OpenLocalLeaderboard()
+{
+	if (mLeaderboard.IsOpen())
+		return;
+	//brings in the old highscores.txt the first time, after that the disk work is all on the worker
+	mLeaderboard.SetWorker(&mPersist);
+	mLeaderboard.Open(mLeaderboardFile, mLegacyScoreFile);
+}
+
+void Game::SetLeaderboardFile(const std::string& fileName)
+{
+	//the worker may still be asking the server for its top
+	mPersist.Flush();
+	{
+		std::lock_guard<std::mutex> lock(mReplyLock);
+		mServerReplies.clear();
+	}
+	mLbClient.Close();
+	mUseServer = false;
+	mLeaderboard.Close();
+	mTopScores.clear();
+	mLeaderboardFile = fileName;
+	mLegacyScoreFile.clear();
+	OpenLocalLeaderboard();
+}
+
+void Game::SubmitScore(const std::string& name, int score)
+{
+	AllocScope allocScope(AllocTag::IO);
+	if (!mUseServer)
 	{
-		ifstream highscoresFile("highscores.txt");
-		while (!highscoresFile.eof())
+		AddLocalScore(name, score);
+		return;
+	}
+	//show it among the last top we had until the server's answer replaces it,
+	//after any equal scores as they were there first
+	size_t at = 0;
+	while (at < mTopScores.size() && mTopScores[at].score >= score)
+		++at;
+	if (at < TOP_SCORES)
+	{
+		mTopScores.insert(mTopScores.begin() + at, LeaderboardProtocol::Score{ name, score });
+		if (mTopScores.size() > TOP_SCORES)
+			mTopScores.pop_back();
+	}
+	CallServer(name, score, true);
+}
+
+void Game::CallServer(const std::string& name, int score, bool submit)
+{
+	mPersist.Submit("", [this, name, score, submit]() {
+		AllocScope allocScope(AllocTag::IO);
+		ServerReply reply;
+		reply.name = name;
+		reply.score = score;
+		reply.submit = submit;
+		if (mLbClient.IsConnected())
 		{
-			string name;
-			int score;
-			highscoresFile >> name;
-			if (highscoresFile.eof())
+			if (submit)
 			{
-				break;
+				mLbClient.Queue(name, score);
+				reply.delivered = mLbClient.Flush();
+				reply.unknown = !reply.delivered && mLbClient.GetNumUnknown() > 0;
+				if (!reply.delivered)
+					mLbClient.ClearQueued();
 			}
-			highscoresFile >> score;
-			mHighscores.push_back({ name, score });
+			if (!submit || reply.delivered)
+				reply.haveTop = mLbClient.GetTop(TOP_SCORES, reply.top);
+		}
+		//any failure closes the client, nothing after this will try it
+		reply.connected = mLbClient.IsConnected();
+		bool ok = reply.connected;
+		std::lock_guard<std::mutex> lock(mReplyLock);
+		mServerReplies.push_back(move(reply));
+		return ok;
+	});
+}
+
+bool Game::TakeServerReplies()
+{
+	vector<ServerReply> replies;
+	{
+		std::lock_guard<std::mutex> lock(mReplyLock);
+		if (mServerReplies.empty())
+			return false;
+		replies.swap(mServerReplies);
+	}
+	AllocScope allocScope(AllocTag::IO);
+	for (ServerReply& reply : replies)
+	{
+		if (reply.haveTop)
+			mTopScores = move(reply.top);
+		if (!reply.connected && mUseServer)
+		{
+			//server went away, carry on with the file
+			mUseServer = false;
+			OpenLocalLeaderboard();
 		}
+		//a score the server never got goes in the file, one it got but couldn't list back doesn't,
+		//nor does one that it might have got, better missing from the file than counted twice
+		if (reply.submit && reply.unknown)
+			DBOUT("leaderboard: server may not have " << reply.name << " " << reply.score << ", not kept locally");
+		else if (reply.submit && !reply.delivered)
+			AddLocalScore(reply.name, reply.score);
 	}
+	return true;
+}
+
+void Game::AddLocalScore(const std::string& name, int score)
+{
+	mLeaderboard.Add(name, score);
+	mTopScores.clear();
+	for (auto& e : mLeaderboard.GetTop())
+		mTopScores.push_back(LeaderboardProtocol::Score{ e.name, e.score });
 }
 
   
@@ -81,64 +195,119 @@ Game::Game(MyD3D& d3d)
 //any memory or resources we made need releasing at the end
 void Game::Release()
 {
+	//it stops the music, so before the audio goes
+	mPMode.reset();
 	delete mpSB;
 	mpSB = nullptr;
+	delete mpStates;
+	mpStates = nullptr;
+	mOverlay.Release();
+	mAudio->Shutdown();
+	//everything queued gets written before we go, a score the server
+	//didn't take has to reach the file first
+	mPersist.Flush();
+	TakeServerReplies();
+	mLbClient.Close();
+	mLeaderboard.Close();
+	mPersist.Flush();
 }
 
 //called over and over, use it to update game logic
 void Game::Update(float dTime)
 {
-	sGamepads.Update();
+	PROFILE_ZONE("Game::Update");
+	int64_t updateStart = Clock::NowNs();
 	mAudio->Update();
+	//changing mode, or a score coming back to be filed, is setting up not the steady loop
+	State startState = state;
+	bool tookReplies = TakeServerReplies();
+
+	//step the simulation in fixed ticks that follow the clock, each tick
+	//only sees input from before it ended so a press lands in the right tick
+	if (mSimTimeNs == 0)
+	{
+		mSimTimeNs = mClockNs = Clock::NowNs();
+		mpInput->Start(mSimTimeNs);
+	}
+	int64_t now;
+	if (mVirtualClock)
+	{
+		//whole ticks, a float step added up every frame would slowly gain or lose ticks
+		int64_t numTicks = (std::max)(1ll, llround(dTime * TICK_HZ));
+		now = mClockNs += numTicks * TICK_NS;
+	}
+	else
+	{
+		now = Clock::NowNs();
+		//after a long stall don't try to catch up, the skipped input all goes to the next tick
+		if (now - mSimTimeNs > MAX_TICKS_PER_UPDATE * TICK_NS)
+			mSimTimeNs = now - MAX_TICKS_PER_UPDATE * TICK_NS;
+	}
+	{
+		AllocScope allocScope(AllocTag::INPUT);
+		mpInput->Poll(mInput, now);
+	}
+	while (mSimTimeNs + TICK_NS <= now)
+	{
+		mSimTimeNs += TICK_NS;
+		mInput.ConsumeUntil(mSimTimeNs);
+		//by tick number, so playback gets the same input in the same tick however long anything took
+		mRecorder.Write(++mTickCount, mInput.GetTickEvents());
+		if (mpLatency)
+			mpLatency->OnTickStart(mInput.GetTickEvents(), mSimTimeNs, !mVirtualClock);
+		FrameArena::GetTick().Reset();
+		UpdateTick();
+		if (mpLatency)
+			mpLatency->OnTickEnd();
+	}
+	mSteadyFrame = state == startState && !tookReplies;
+	mUpdateNs = Clock::NowNs() - updateStart;
+}
+
+void Game::UpdateTick()
+{
+	PROFILE_ZONE("Game::UpdateTick");
+	AllocScope allocScope(AllocTag::SIM);
+#if SHIPSHOOT_PROFILING
+	//grab what's been recorded without stopping
+	if (mInput.WasPressed(VK_F9))
+		Profiler::Get().WriteChromeTrace(PROFILE_FILE);
+#endif
+	if (mInput.WasPressed(VK_F1))
+		mOverlay.Toggle();
 	switch (state)
 	{
 	case State::TITLE:
-		if (Game::sMKIn.IsPressed(VK_RETURN))
+		if (mInput.WasPressed(VK_RETURN))
 		{
-			mPMode = new PlayMode(mD3D, mSpriteFont, mAudio.get());
+			mPMode = make_unique<PlayMode>(mD3D, mSpriteFont, mAudio.get(), mInput, mRandom);
 			state = State::PLAY;
 		}
 		else
 		{
 			for (int key = VK_A; key <= VK_Z; ++key)
-			{
-				bool state = Game::sMKIn.IsPressed(key);
-				if (state && !mKeysPressed[key])
-				{
+				if (mInput.WasPressed(key))
 					mPlayerName += (char)key;
-				}
-				mKeysPressed[key] = state;
-			}
 		}
 		break;
 	case State::PLAY:
-		mPMode->Update(dTime);
+		mPMode->Update(TICK_NS);
 		if (mPMode->IsGameOver())
 		{
-			//add an entry to highscores 
-			mHighscores.push_back({ mPlayerName, mPMode->GetScore() });
-			std::sort(begin(mHighscores), end(mHighscores), [](auto item1, auto item2) { return item1.second > item2.second; });
-
-			//remove last entry if there are more than 10
-			if (mHighscores.size() > 10)
-			{
-				mHighscores.erase(begin(mHighscores) + 10);
-			}
-
-			// save the highscores to file
-			ofstream highscoresFile("highscores.txt");
-			for (auto& item : mHighscores)
-			{
-				highscoresFile << item.first << "\n" << item.second << "\n";
-			}
+			//how long this frame stalls for, it should be nothing now the writing is elsewhere
+			int64_t start = Clock::NowNs();
+			//add an entry to highscores, the server or the worker does the writing
+			SubmitScore(mPlayerName, mPMode->GetScore());
 
 			state = State::GAMEOVER;
-			delete mPMode;
-			mPMode = nullptr;
+			mPMode.reset();
+			++mNumGamesPlayed;
+			static Histogram& sTransitionMs = Stats::Get().GetHistogram("gameover_transition_ms");
+			sTransitionMs.Add(Clock::ToMs(Clock::NowNs() - start));
 		}
 		break;
 	case State::GAMEOVER:
-		if (Game::sMKIn.IsPressed(VK_SPACE))
+		if (mInput.WasPressed(VK_SPACE))
 		{
 			state = State::TITLE;
 		}
@@ -149,11 +318,13 @@ void Game::Update(float dTime)
 //called over and over, use it to render things
 void Game::Render(float dTime)
 {
+	PROFILE_ZONE("Game::Render");
+	AllocScope allocScope(AllocTag::RENDER);
+	int64_t renderStart = Clock::NowNs();
 	mD3D.BeginRender(Colours::Black);
 
 
-	CommonStates dxstate(&mD3D.GetDevice());
-	mpSB->Begin(SpriteSortMode_Deferred, dxstate.NonPremultiplied(), &mD3D.GetWrapSampler());
+	mpSB->Begin(SpriteSortMode_Deferred, mpStates->NonPremultiplied(), &mD3D.GetWrapSampler());
 
 	switch (state)
 	{
@@ -169,37 +340,58 @@ void Game::Render(float dTime)
 		mGameOverBackgroundSprite.Draw(*mpSB);
 		mSpriteFont->DrawString(mpSB, "GAME OVER", XMFLOAT2(260, 100));
 		float y = 150;
-		for (auto& item : mHighscores)
+		for (auto& item : mTopScores)
 		{
-			mSpriteFont->DrawString(mpSB, item.first.c_str(), XMFLOAT2(200, y));
-			stringstream s;
-			s << item.second;
-			mSpriteFont->DrawString(mpSB, s.str().c_str(), XMFLOAT2(500, y));
+			mSpriteFont->DrawString(mpSB, item.name.c_str(), XMFLOAT2(200, y));
+			mSpriteFont->DrawString(mpSB, FrameArena::GetFrame().Format("%d", item.score), XMFLOAT2(500, y));
 			y += 40;
 		}
 		mSpriteFont->DrawString(mpSB, "PRESS SPACE TO RETURN TO TITLE SCREEN", XMFLOAT2(120, 600));
 		break;
 	}
 
-	mpSB->End();
+	if (mOverlay.IsVisible())
+	{
+		PerfOverlay::Counts counts;
+		if (mPMode)
+			mPMode->GetCounts(counts);
+		counts.sfxChannels = mAudio->GetSfxMgr()->NumChannelsPlaying();
+		counts.musicChannels = mAudio->GetSongMgr()->NumChannelsPlaying();
+		mOverlay.Render(*mpSB, *mSpriteFont, counts);
+	}
+
+	{
+		PROFILE_ZONE("SpriteBatch::End");
+		mpSB->End();
+	}
+	int64_t renderNs = Clock::NowNs() - renderStart;
 
+	if (mpLatency)
+		mpLatency->OnSubmitted();
+	{
+		PROFILE_ZONE("MyD3D::EndRender");
+		mD3D.EndRender();
+	}
+	if (mpLatency)
+		mpLatency->OnPresented(!mD3D.IsHeadless());
 
-	mD3D.EndRender();
-	sMKIn.PostProcess();
+	//a frame runs from the end of one Render to the end of the next
+	int64_t now = Clock::NowNs();
+	AllocTracker& allocs = AllocTracker::Get();
+	allocs.EndFrame(mSteadyFrame);
+	PROFILE_COUNTER("allocs", allocs.GetFrameAllocs());
+	if (mLastFrameEndNs)
+		mOverlay.AddFrame(now - mLastFrameEndNs, mUpdateNs, renderNs, allocs.GetFrameAllocs());
+	mLastFrameEndNs = now;
+	//the batch has been drawn, nothing needs this frame's text any more
+	FrameArena::GetFrame().Reset();
 }
 
 Bullet::Bullet(DirectX::SimpleMath::Vector2 pos, int direction, bool useBossBulletTexture = false)
-	:bullet(*d3d),
+	:bullet(useBossBulletTexture ? bossProto : proto),
 	direction(direction)
 {
-	if (useBossBulletTexture)
-		bullet.SetTex(*texture2);
-	else	
-		bullet.SetTex(*texture);
-	bullet.GetAnim().Init(0, 3, 15, true);
-	bullet.GetAnim().Play(true);
-	bullet.SetScale(Vector2(0.75f, 0.75f));
-	bullet.origin = Vector2((missileSpin[0].right - missileSpin[0].left) / 2.f, (missileSpin[0].bottom - missileSpin[0].top) / 2.f);
+	anim.Init(bullet, 0, 3, 15, true);
 	const float pi = 3.1415927f;
 	bullet.rotation = direction * pi / 2.0f;
 	bullet.mPos = pos;
@@ -207,21 +399,26 @@ Bullet::Bullet(DirectX::SimpleMath::Vector2 pos, int direction, bool useBossBull
 
 void Bullet::Init(MyD3D& d3d)
 {
-	vector<RECTF> frames2(missileSpin, missileSpin + sizeof(missileSpin) / sizeof(missileSpin[0]));
-	texture = d3d.GetCache().LoadTexture(&d3d.GetDevice(), "missile.dds", "missile", true, &frames2);
-	texture2 = d3d.GetCache().LoadTexture(&d3d.GetDevice(), "missile2.dds", "missile2", true, &frames2);
-	Bullet::d3d = &d3d;
+	//only copied the first time, it's the same for every PlayMode
+	static const vector<RECTF> frames2(missileSpin, missileSpin + sizeof(missileSpin) / sizeof(missileSpin[0]));
+	ID3D11ShaderResourceView* texture = d3d.GetCache().LoadTexture(&d3d.GetDevice(), "missile.dds", "missile", true, &frames2);
+	ID3D11ShaderResourceView* texture2 = d3d.GetCache().LoadTexture(&d3d.GetDevice(), "missile2.dds", "missile2", true, &frames2);
+	proto.SetTex(d3d.GetCache(), *texture);
+	proto.scale = Vector2(0.75f, 0.75f);
+	proto.origin = Vector2((missileSpin[0].right - missileSpin[0].left) / 2.f, (missileSpin[0].bottom - missileSpin[0].top) / 2.f);
+	bossProto = proto;
+	bossProto.SetTex(d3d.GetCache(), *texture2);
 }
 
-void Bullet::Render(SpriteBatch& batch)
+void Bullet::Render(SpriteBatch& batch, const TexCache& cache)
 {
-	bullet.Draw(batch);
+	bullet.Draw(batch, cache);
 }
 
 void Bullet::Update(float dTime)
 {
 	bullet.mPos.y += 300 * dTime * direction;
-	bullet.GetAnim().Update(dTime);
+	anim.Update(bullet, dTime);
 	
 }
 
@@ -230,51 +427,40 @@ bool Bullet::OutOfBounds()
 	return bullet.mPos.y < 0;
 }
 
-Enemy::Enemy(MyD3D& d3d, ID3D11ShaderResourceView* texture, DirectX::SimpleMath::Vector2 pos):
-	sprite(d3d)
-{
-	sprite.SetTex(*texture);
-	sprite.SetScale(Vector2(0.5f, 0.5f));
-	//sprite.origin = Vector2((missileSpin[0].right - missileSpin[0].left) / 2.f, (missileSpin[0].bottom - missileSpin[0].top) / 2.f);
-	sprite.mPos = pos;
-}
-
-void Enemy::Render(SpriteBatch& batch)
+Enemy::Enemy(MyD3D& d3d, ID3D11ShaderResourceView* texture, DirectX::SimpleMath::Vector2 pos)
 {
-	sprite.Draw(batch);
+	proxy.SetTex(d3d.GetCache(), *texture);
+	proxy.scale = Vector2(0.5f, 0.5f);
+	proxy.mPos = pos;
 }
 
-void Enemy::Update(float dTime)
+void Enemy::Render(SpriteBatch& batch, const TexCache& cache)
 {
-	sprite.mPos.x += sharedXSpeed * sharedXDirection * dTime;
+	proxy.Draw(batch, cache);
 }
 
-void Enemy::MoveDown()
-{
-	sprite.mPos.y += 20;
-}
 
-bool Enemy::CheckSwitchDirection(const RECTF& playArea)
+PlayMode::PlayMode(MyD3D & d3d, std::shared_ptr<SpriteFont> spriteFont, IAudioMgr* audio, const InputQueue& input, Random& random)
+	:mD3D(d3d), mLifeSprite(d3d), mBossPool(BOSS_POOL),
+	mSpriteFont(spriteFont), mAudio(audio), mInput(input), mRandom(random), mSfx(*audio)
 {
-	if ((sharedXDirection > 0 && sprite.mPos.x > playArea.right) || (sharedXDirection < 0 && sprite.mPos.x < playArea.left))
-	{
-		sharedXDirection = -sharedXDirection;
-		return true;
-	}
-	return false;
-}
+	mEnemies.reserve(BOSS_POOL);
+	mpFirePattern = make_unique<RandomFirePattern>();
+	mEvents.AddListener(mSfx);
+	mEvents.AddListener(mScore);
+	mEvents.AddListener(mTelemetry);
 
-
-PlayMode::PlayMode(MyD3D & d3d, std::shared_ptr<SpriteFont> spriteFont, IAudioMgr* audio)
-	:mD3D(d3d), mPlayer(d3d), mSpriteFont(spriteFont), mAudio(audio)
-{
 	InitBgnd();
 	InitPlayer();
 	Bullet::Init(d3d);
 
 	mLivesTexture = mD3D.GetCache().LoadTexture(&mD3D.GetDevice(), "ship.dds");
+	mLifeSprite.SetTex(*mLivesTexture);
+	mLifeSprite.SetScale(Vector2(0.05f, 0.05f));
 	mEnemyTexture = mD3D.GetCache().LoadTexture(&mD3D.GetDevice(), "shipYellow_manned.dds");
 	mBossTexture = mD3D.GetCache().LoadTexture(&mD3D.GetDevice(), "shipBeige_manned.dds");
+	mEnemyProto.SetTex(mD3D.GetCache(), *mEnemyTexture);
+	mEnemyProto.scale = Vector2(0.5f, 0.5f);
 
 	NewLevel();
 
@@ -284,13 +470,9 @@ PlayMode::PlayMode(MyD3D & d3d, std::shared_ptr<SpriteFont> spriteFont, IAudioMg
 
 void PlayMode::InitEnemies()
 {
-	for (float y = 50; y < 230; y += 40)
-	{
-		for (float x = 100; x < 500; x += 70)
-		{
-			mEnemies.push_back(new Enemy(mD3D, mEnemyTexture, Vector2(x,y)));
-		}
-	}
+	//6 across and 5 down, back at the top
+	mFormation.Init(mEnemyProto, Vector2(100, 50), Vector2(70, 40), 6, 5);
+	mShooters.Reset(mFormation, BOSS_POOL);
 }
 
 void PlayMode::InitShields()
@@ -306,31 +488,26 @@ void PlayMode::NewLevel()
 {
 	InitEnemies();
 	InitShields();
-	if (mLevel == 1)
-	{
-		Enemy::ResetXSpeed();
-	}
-	else
-	{
-		Enemy::IncreaseXSpeed();
-	}
+	mFormation.SetSpeed(ENEMY_SPEED + ENEMY_SPEED_PER_LEVEL * (mLevel - 1));
 }
 
 PlayMode::~PlayMode()
 {
 	mAudio->GetSongMgr()->Stop();
+	if (mEvents.GetNumDropped() || mEvents.GetNumGrown())
+		DBOUT("Game events: " << mEvents.GetNumDropped() << " dropped, queue grown " << mEvents.GetNumGrown() << " times");
 }
 
 void PlayMode::UpdateBullets(float dTime)
 {
-	if (mRespawnTimer <= 0 && mPlayerBullets.size() < 3 && Game::sMKIn.IsPressed(VK_SPACE) && !mFireDown)
+	PROFILE_ZONE("PlayMode::UpdateBullets");
+	//one missile per press, holding it down doesn't auto fire
+	if (mRespawnTimer <= 0 && mPlayerBullets.size() < 3 && mInput.WasPressed(VK_SPACE))
 	{
 		mPlayerBullets.emplace_back(Vector2(mPlayer.mPos.x + mPlayer.GetScreenSize().x / 2.f - 20, mPlayer.mPos.y), -1);
-		mAudio->GetSfxMgr()->Play("laser", false, false);
+		mEvents.Push(GameEventType::FIRE, mPlayer.mPos.x, mPlayer.mPos.y);
 	}
 
-	mFireDown = Game::sMKIn.IsPressed(VK_SPACE);
-
 	for (int bulletI = mPlayerBullets.size() - 1; bulletI >= 0; --bulletI)
 	{
 		mPlayerBullets[bulletI].Update(dTime);
@@ -340,13 +517,21 @@ void PlayMode::UpdateBullets(float dTime)
 
 	// enemy firing
 	mEnemyBulletTimer -= dTime;
-	if (mEnemyBulletTimer <= 0 && !mEnemies.empty())
+	if (mEnemyBulletTimer <= 0 && mShooters.GetNumShooters() > 0)
 	{
-		uniform_int_distribution<int> range(0, mEnemies.size() - 1);
-		int chosenI = range(randEngine);
-		auto& enemySprite = mEnemies[chosenI]->GetSprite();
-		mEnemyBullets.emplace_back(Vector2(enemySprite.mPos.x + enemySprite.GetScreenSize().x / 8.f, enemySprite.mPos.y), 1, mEnemies[chosenI]->FiresBossBullet());
-		mEnemyBulletTimer = 60.f / mEnemies.size();
+		const ShooterIndex::Shooter& shooter = mShooters.Get(mpFirePattern->Pick(mShooters, mRandom));
+		if (shooter.pEnemy)
+		{
+			auto& enemySprite = shooter.pEnemy->GetProxy();
+			mEnemyBullets.emplace_back(Vector2(enemySprite.mPos.x + enemySprite.GetScreenSize().x / 8.f, enemySprite.mPos.y), 1, shooter.pEnemy->FiresBossBullet());
+		}
+		else
+		{
+			Vector2 pos = mFormation.GetPos(shooter.slot);
+			mEnemyBullets.emplace_back(Vector2(pos.x + mFormation.GetEnemySize().x / 8.f, pos.y), 1, false);
+		}
+		int numEnemies = mFormation.GetNumAlive() + static_cast<int>(mEnemies.size());
+		mEnemyBulletTimer = mpFirePattern->GetInterval(mShooters, numEnemies);
 	}
 	for (int bulletI = mEnemyBullets.size() - 1; bulletI >= 0; --bulletI)
 	{
@@ -360,6 +545,7 @@ void PlayMode::UpdateBullets(float dTime)
 
 void PlayMode::UpdateBgnd(float dTime)
 {
+	PROFILE_ZONE("PlayMode::UpdateBgnd");
 	//scroll the background layers
 	int i = 0;
 	for (auto& s : mBgnd)
@@ -368,37 +554,38 @@ void PlayMode::UpdateBgnd(float dTime)
 
 void PlayMode::UpdateInput(float dTime)
 {
+	PROFILE_ZONE("PlayMode::UpdateInput");
 	if (mRespawnTimer > 0)
 		return;
 
-	Vector2 mouse{ Game::sMKIn.GetMousePos(false) };
-	bool keypressed = Game::sMKIn.IsPressed(VK_UP) || Game::sMKIn.IsPressed(VK_DOWN) ||
-		Game::sMKIn.IsPressed(VK_RIGHT) || Game::sMKIn.IsPressed(VK_LEFT);
-	bool sticked = false;
-	if (Game::sGamepads.IsConnected(0) &&
-		(Game::sGamepads.GetState(0).leftStickX != 0 || Game::sGamepads.GetState(0).leftStickX != 0))
-		sticked = true;
+	Vector2 mouse{ mInput.GetMouseDX(), mInput.GetMouseDY() };
+	bool keypressed = mInput.IsDown(VK_UP) || mInput.IsDown(VK_DOWN) ||
+		mInput.IsDown(VK_RIGHT) || mInput.IsDown(VK_LEFT);
+	//a pad that goes away reports its sticks back at zero
+	Vector2 stick;
+	mInput.GetPadStick(0, 0, stick.x, stick.y);
+	bool sticked = stick.x != 0 || stick.y != 0;
 
 	if (keypressed || (mouse.Length() >VERY_SMALL) || sticked)
 	{
 		//move the ship around
 		Vector2 pos(0, 0);
-		if (Game::sMKIn.IsPressed(VK_UP))
+		if (mInput.IsDown(VK_UP))
 			pos.y -= SPEED * dTime;
-		else if (Game::sMKIn.IsPressed(VK_DOWN))
+		else if (mInput.IsDown(VK_DOWN))
 			pos.y += SPEED * dTime;
-		if (Game::sMKIn.IsPressed(VK_RIGHT))
+		if (mInput.IsDown(VK_RIGHT))
 			pos.x += SPEED * dTime;
-		else if (Game::sMKIn.IsPressed(VK_LEFT))
+		else if (mInput.IsDown(VK_LEFT))
 			pos.x -= SPEED * dTime;
 
-		pos += mouse * MOUSE_SPEED * dTime;
+		pos += mouse * MOUSE_SPEED * MOUSE_STEP;
 
 		if (sticked)
 		{
-			DBOUT("left stick x=" << Game::sGamepads.GetState(0).leftStickX << " y=" << Game::sGamepads.GetState(0).leftStickY);
-			pos.x += Game::sGamepads.GetState(0).leftStickX * PAD_SPEED * dTime;
-			pos.y -= Game::sGamepads.GetState(0).leftStickY * PAD_SPEED * dTime;
+			DBOUT("left stick x=" << stick.x << " y=" << stick.y);
+			pos.x += stick.x * PAD_SPEED * dTime;
+			pos.y -= stick.y * PAD_SPEED * dTime;
 		}
 
 		//keep it within the play area
@@ -413,11 +600,19 @@ void PlayMode::UpdateInput(float dTime)
 			pos.y = mPlayArea.bottom;
 
 		mPlayer.mPos = pos;
-		mThrusting = GetClock() + 0.2f;
+		mThrustUntilNs = mTimeNs + THRUST_NS;
 	}
 }
 
 void PlayMode::UpdateCollisions()
+{
+	PROFILE_ZONE("PlayMode::UpdateCollisions");
+	CollidePlayerBullets();
+	CollideEnemyBullets();
+	CollideShields();
+}
+
+void PlayMode::CollidePlayerBullets()
 {
 	//going through the list backwards so that items can be deleted without skipping items
 	for (int bulletI = mPlayerBullets.size() - 1; bulletI >= 0; --bulletI)
@@ -431,7 +626,7 @@ void PlayMode::UpdateCollisions()
 
 		for (int enemyI = mEnemies.size() - 1; enemyI >= 0; --enemyI)
 		{
-			auto& enemySprite = mEnemies[enemyI]->GetSprite();
+			auto& enemySprite = mEnemies[enemyI]->GetProxy();
 			auto enemySize = enemySprite.GetScreenSize();
 			float enemyWidth = enemySize.x;   
 
@@ -443,16 +638,29 @@ void PlayMode::UpdateCollisions()
 				)
 			{
 				// Collision detected!
-				mScore += mEnemies[enemyI]->GetScore();
+				mEvents.Push(GameEventType::KILL, enemySprite.mPos.x, enemySprite.mPos.y, mEnemies[enemyI]->GetScore());
 				mPlayerBullets.erase(begin(mPlayerBullets) + bulletI);
-				delete mEnemies[enemyI];
+				mShooters.Remove(*mEnemies[enemyI]);
 				mEnemies.erase(begin(mEnemies) + enemyI);
-				mAudio->GetSfxMgr()->Play("bang", false, false);
 				collided = true;
 				break;
 			}
 		}
 
+		if (!collided)
+		{
+			int slot = mFormation.HitTest(bulletSprite.mPos, Vector2(bulletWidth, bulletHeight));
+			if (slot >= 0)
+			{
+				Vector2 pos = mFormation.GetPos(slot);
+				mEvents.Push(GameEventType::KILL, pos.x, pos.y, Formation::SCORE);
+				mPlayerBullets.erase(begin(mPlayerBullets) + bulletI);
+				mFormation.Kill(slot);
+				mShooters.OnKilled(mFormation, slot);
+				collided = true;
+			}
+		}
+
 		if (!collided)
 		{
 			//Check for collisions between player and enemy bullets
@@ -471,16 +679,19 @@ void PlayMode::UpdateCollisions()
 					)
 				{
 					// Collision detected!
+					mEvents.Push(GameEventType::HIT, enemyBulletSprite.mPos.x, enemyBulletSprite.mPos.y);
 					mPlayerBullets.erase(begin(mPlayerBullets) + bulletI);
 					mEnemyBullets.erase(begin(mEnemyBullets) + enemyBulletI);
-					mAudio->GetSfxMgr()->Play("bang", false, false);
 					collided = true;
 					break;
 				}
 			}
 		}
 	}
+}
 
+void PlayMode::CollideEnemyBullets()
+{
 	//check for enemy bullet collision with player 
 	if (mRespawnTimer <= 0)
 	{
@@ -500,15 +711,18 @@ void PlayMode::UpdateCollisions()
 				)
 			{
 				// Collision detected!
+				mEvents.Push(GameEventType::LIFE_LOST, mPlayer.mPos.x, mPlayer.mPos.y);
 				mEnemyBullets.erase(begin(mEnemyBullets) + bulletI);
-				mAudio->GetSfxMgr()->Play("bang", false, false);
 				mLives--;
 				mRespawnTimer = 3;
 				break;
 			}
 		}
 	}
+}
 
+void PlayMode::CollideShields()
+{
 	//check collisions between bullets and shield
 	for (int shieldI = mShields.size() - 1; shieldI >= 0; --shieldI)
 	{
@@ -516,24 +730,29 @@ void PlayMode::UpdateCollisions()
 		{
 			if (mShields[shieldI].CheckCollision(mEnemyBullets[bulletI]))
 			{
+				auto& pos = mEnemyBullets[bulletI].bullet.mPos;
+				mEvents.Push(GameEventType::SHIELD_CHIP, pos.x, pos.y);
 				mEnemyBullets.erase(begin(mEnemyBullets) + bulletI);
-				mAudio->GetSfxMgr()->Play("bang", false, false);
 			}
 		}
 		for (int bulletI = mPlayerBullets.size() - 1; bulletI >= 0; --bulletI)
 		{
 			if (mShields[shieldI].CheckCollision(mPlayerBullets[bulletI]))
 			{
+				auto& pos = mPlayerBullets[bulletI].bullet.mPos;
+				mEvents.Push(GameEventType::SHIELD_CHIP, pos.x, pos.y);
 				mPlayerBullets.erase(begin(mPlayerBullets) + bulletI);
-				mAudio->GetSfxMgr()->Play("bang", false, false);
 			}
 		}
 	}
 }
 
 
-void PlayMode::Update(float dTime)
+void PlayMode::Update(int64_t dTimeNs)
 {
+	PROFILE_ZONE("PlayMode::Update");
+	mTimeNs += dTimeNs;
+	float dTime = static_cast<float>(Clock::ToSec(dTimeNs));
 	mRespawnTimer -= dTime;
 
 	UpdateBgnd(dTime);
@@ -546,20 +765,26 @@ void PlayMode::Update(float dTime)
 		
 	UpdateCollisions();
 
-	if (mEnemies.empty())
+	if (mFormation.IsEmpty() && mEnemies.empty())
 	{
 		mLevel++;
+		mEvents.Push(GameEventType::LEVEL_UP, 0, 0, mLevel);
 		NewLevel();
 	}
+
+	//the tick is over, now sound, score and telemetry get to see what happened
+	mEvents.Dispatch();
 }
 
 void PlayMode::UpdateEnemies(float dTime)
 {
+	PROFILE_ZONE("PlayMode::UpdateEnemies");
 	// create a boss enemy every so often 
 	mBossTimer -= dTime;
 	if (mBossTimer <= 0)
 	{
-		mEnemies.push_back(new BossEnemy(mD3D, mBossTexture, Vector2 (0,20)));
+		mEnemies.push_back(mBossPool.Make<Enemy>(mD3D, mBossTexture, Vector2 (0,20)));
+		mShooters.Add(*mEnemies.back());
 		mBossTimer = 20;
 	}
 
@@ -568,61 +793,57 @@ void PlayMode::UpdateEnemies(float dTime)
 		mEnemies[enemyI]->Update(dTime);
 		if (mEnemies[enemyI]->ShouldDestroy())
 		{
+			mShooters.Remove(*mEnemies[enemyI]);
 			mEnemies.erase(begin(mEnemies) + enemyI);
 		}
 	}
 
-	for (auto enemy : mEnemies)
-	{
-		if (enemy->CheckSwitchDirection(mPlayArea))
-		{
-			for (auto enemy2 : mEnemies)
-			{
-				enemy2->MoveDown();
-			}
-			break;
-		}
-	}
-
-	
+	mFormation.Update(dTime, mPlayArea);
 }
 
 void PlayMode::Render(float dTime, DirectX::SpriteBatch & batch) {
+	PROFILE_ZONE("PlayMode::Render");
 	for (auto& s : mBgnd)
 		s.Draw(batch);
+	const TexCache& cache = mD3D.GetCache();
 	for (auto& bullet : mPlayerBullets)
-		bullet.Render(batch);
+		bullet.Render(batch, cache);
 	for (auto& bullet : mEnemyBullets)
-		bullet.Render(batch);
+		bullet.Render(batch, cache);
 
 	if (mRespawnTimer <= 0)
-		mPlayer.Draw(batch);
+		mPlayer.Draw(batch, cache);
 
+	mFormation.Render(batch, cache);
 	for (auto& enemy : mEnemies)
-		enemy->Render(batch);
+		enemy->Render(batch, cache);
 
 	for (auto& shield : mShields)
-		shield.Render(batch);
+		shield.Render(batch, cache);
 
 	//display lives
-	Sprite lifeSprite(mD3D);
 	for (int i = 0; i < mLives; ++i)
 	{
-		lifeSprite.SetTex(*mLivesTexture); 
-		lifeSprite.SetScale(Vector2(0.05f, 0.05f));
-		lifeSprite.mPos = Vector2(i * 20.f, 10.f);
-		lifeSprite.Draw(batch);
+		mLifeSprite.mPos = Vector2(i * 20.f, 10.f);
+		mLifeSprite.Draw(batch);
 	}
 
 	// display score
-	wstringstream ss;
-	ss << "Score: " << mScore;
-	mSpriteFont->DrawString(&batch, ss.str().c_str(), XMFLOAT2(0, 50));
+	FrameArena& arena = FrameArena::GetFrame();
+	mSpriteFont->DrawString(&batch, arena.Format(L"Score: %d", mScore.GetScore()), XMFLOAT2(0, 50));
 
 	//display level
-	wstringstream ss2;
-	ss2 << "Level: " << mLevel;
-	mSpriteFont->DrawString(&batch, ss2.str().c_str(), XMFLOAT2(0, 80));
+	mSpriteFont->DrawString(&batch, arena.Format(L"Level: %d", mLevel), XMFLOAT2(0, 80));
+}
+
+void PlayMode::GetCounts(PerfOverlay::Counts& counts) const
+{
+	counts.enemies = static_cast<unsigned int>(mFormation.GetNumAlive() + mEnemies.size());
+	counts.playerBullets = static_cast<unsigned int>(mPlayerBullets.size());
+	counts.enemyBullets = static_cast<unsigned int>(mEnemyBullets.size());
+	counts.shieldPieces = 0;
+	for (auto& shield : mShields)
+		counts.shieldPieces += static_cast<unsigned int>(shield.GetNumPieces());
 }
 
 bool PlayMode::IsGameOver()
@@ -634,7 +855,9 @@ void PlayMode::InitBgnd()
 {
 	//a sprite for each layer
 	assert(mBgnd.empty());
-	mBgnd.insert(mBgnd.begin(), BGND_LAYERS, Sprite(mD3D));
+	mBgnd.reserve(BGND_LAYERS);
+	for (int i = 0; i < BGND_LAYERS; ++i)
+		mBgnd.emplace_back(mD3D);
 
 	//a neat way to package pairs of things (nicknames and filenames)
 	pair<string, string> files[BGND_LAYERS]{
@@ -657,9 +880,9 @@ void PlayMode::InitPlayer()
 {
 	//load a orientate the ship
 	ID3D11ShaderResourceView *p = mD3D.GetCache().LoadTexture(&mD3D.GetDevice(), "ship.dds");
-	mPlayer.SetTex(*p);
-	mPlayer.SetScale(Vector2(0.1f, 0.1f));
-	mPlayer.origin = mPlayer.GetTexData().dim / 2.f;
+	mPlayer.SetTex(mD3D.GetCache(), *p);
+	mPlayer.scale = Vector2(0.1f, 0.1f);
+	mPlayer.origin = mPlayer.size / 2.f;
 	//mPlayer.rotation = PI / 2.f;
 
 	//setup the play area
@@ -675,24 +898,14 @@ void PlayMode::InitPlayer()
 
 void BossEnemy::Update(float dTime)
 {
-	sprite.mPos.x += xSpeed * dTime;
-}
-
-void BossEnemy::MoveDown()
-{
-	//do nothing - boss does not move down 
-}
-
-bool BossEnemy::CheckSwitchDirection(const RECTF& playArea)
-{
-	return false;
+	proxy.mPos.x += xSpeed * dTime;
 }
 
 bool BossEnemy::ShouldDestroy()
 {
 	int w, h;
 	WinUtil::Get().GetClientExtents(w, h);
-	return sprite.mPos.x > w; 
+	return proxy.mPos.x > w; 
 }
 
 Shield::Shield(MyD3D& d3d, DirectX::SimpleMath::Vector2 pos)
@@ -706,25 +919,26 @@ Shield::Shield(MyD3D& d3d, DirectX::SimpleMath::Vector2 pos)
 	{
 		for (int x = pos.x - range; x <= pos.x + range; x += gap)
 		{
-			pieceSprites.emplace_back(d3d);
-			pieceSprites.back().SetTex(*p);
-			pieceSprites.back().SetScale(Vector2(0.5f, 0.5f));
-			pieceSprites.back().mPos = XMFLOAT2(x, y);
+			RenderProxy piece;
+			piece.SetTex(d3d.GetCache(), *p);
+			piece.scale = Vector2(0.5f, 0.5f);
+			piece.mPos = Vector2(static_cast<float>(x), static_cast<float>(y));
+			pieces.push_back(piece);
 		}
 	}
 }
 
-void Shield::Render(DirectX::SpriteBatch& batch)
+void Shield::Render(DirectX::SpriteBatch& batch, const TexCache& cache)
 {
-	for (auto& sprite : pieceSprites)
+	for (auto& piece : pieces)
 	{
-		sprite.Draw(batch);
+		piece.Draw(batch, cache);
 	}
 }
 
 bool Shield::CheckCollision(Bullet& bullet)
 {
-	if (pieceSprites.empty())
+	if (pieces.empty())
 	{
 		return false;
 	}
@@ -734,9 +948,9 @@ bool Shield::CheckCollision(Bullet& bullet)
 	float bulletWidth = bulletSize.y;   // bullet sprite is rotated 90 degrees 
 	float bulletHeight = bulletSize.x / 4;   //4 frame animation 
 
-	for (int pieceI = pieceSprites.size() - 1; pieceI >= 0; --pieceI)
+	for (int pieceI = pieces.size() - 1; pieceI >= 0; --pieceI)
 	{
-		auto& pieceSprite = pieceSprites[pieceI];
+		auto& pieceSprite = pieces[pieceI];
 		auto pieceSize = pieceSprite.GetScreenSize();
 
 		if (
@@ -747,7 +961,7 @@ bool Shield::CheckCollision(Bullet& bullet)
 			)
 		{
 			// Collision detected!
-			pieceSprites.erase(begin(pieceSprites) + pieceI);
+			pieces.erase(begin(pieces) + pieceI);
 			return true;
 		}
 	}
@@ -2,12 +2,26 @@
 
 #include <vector>
 #include <memory>
+#include <mutex>
 #include "Input.h"
 #include "D3D.h"
 #include "SpriteBatch.h"
+#include "CommonStates.h"
 #include "Sprite.h"
+#include "RenderProxy.h"
 
 #include "SpriteFont.h"
+#include "GameEvents.h"
+#include "Leaderboard.h"
+#include "PersistWorker.h"
+#include "LeaderboardClient.h"
+#include "Clock.h"
+#include "InputLatency.h"
+#include "PerfOverlay.h"
+#include "ObjectPool.h"
+#include "Formation.h"
+#include "Random.h"
+#include "ShooterIndex.h"
 
 class AudioMgrFMOD;
 class IAudioMgr;
@@ -21,39 +35,37 @@ class Bullet
 {
 public:
 	Bullet(DirectX::SimpleMath::Vector2 pos, int direction, bool useBossBulletTexture);
-	Sprite bullet;
+	RenderProxy bullet;
+	FrameAnim anim;
 
 	static void Init(MyD3D& d3d);
-	static inline ID3D11ShaderResourceView* texture = nullptr;
-	static inline ID3D11ShaderResourceView* texture2 = nullptr;
-	static inline MyD3D* d3d;
+	//every bullet starts as a copy of one of these
+	static inline RenderProxy proto, bossProto;
 
-	void Render(DirectX::SpriteBatch& batch);
+	void Render(DirectX::SpriteBatch& batch, const TexCache& cache);
 	void Update(float dTime);
 	bool OutOfBounds();
 private:
 	int direction;
 };
 
+/*
+An enemy that moves by itself, the ones marching in step are slots
+in a Formation instead. Only bosses for now.
+*/
 class Enemy
 {
 public:
 	Enemy(MyD3D& d3d, ID3D11ShaderResourceView* texture, DirectX::SimpleMath::Vector2 pos);
-	void Render(DirectX::SpriteBatch& batch);
-	virtual void Update(float dTime);
-	virtual void MoveDown();
-	virtual bool CheckSwitchDirection(const RECTF& playArea);
+	virtual ~Enemy() {}
+	void Render(DirectX::SpriteBatch& batch, const TexCache& cache);
+	virtual void Update(float dTime) {}
 	virtual bool ShouldDestroy() { return false; }
 	virtual int GetScore() { return 10; }
 	virtual bool FiresBossBullet() { return false; }
-	Sprite GetSprite() { return sprite; }
-	static void ResetXSpeed() { sharedXSpeed = 20; }
-	static void IncreaseXSpeed() { sharedXSpeed += 10; }
+	const RenderProxy& GetProxy() const { return proxy; }
 protected:				  // variables can be accessed by derived clases 
-	Sprite sprite;
-private:
-	inline static int sharedXSpeed = 20;
-	inline static int sharedXDirection = 1;
+	RenderProxy proxy;
 };
 
 class BossEnemy : public Enemy
@@ -63,8 +75,6 @@ public:
 		Enemy(d3d, texture, pos)
 	{}
 	virtual void Update(float dTime);
-	virtual void MoveDown();
-	virtual bool CheckSwitchDirection(const RECTF& playArea);
 	virtual bool ShouldDestroy();
 	virtual int GetScore() { return 100; }
 	virtual bool FiresBossBullet() { return true; }
@@ -76,59 +86,90 @@ class Shield
 {
 public:
 	Shield(MyD3D& d3d, DirectX::SimpleMath::Vector2 pos);
-	void Render(DirectX::SpriteBatch& batch);
+	void Render(DirectX::SpriteBatch& batch, const TexCache& cache);
 	bool CheckCollision(Bullet& bullet);
 	virtual bool ShouldDestroy() { return false; }
 	//Sprite GetSprite() { return sprite; }
+	size_t GetNumPieces() const { return pieces.size(); }
 private:				
-	std::vector<Sprite> pieceSprites;
+	std::vector<RenderProxy> pieces;
 };
 
 //horizontal scrolling with player controlled ship
 class PlayMode
 {
 public:
-	PlayMode(MyD3D& d3d, std::shared_ptr<DirectX::DX11::SpriteFont> spriteFont, IAudioMgr* audio);
+	//input - what the player is doing, updated by the game every tick
+	//random - where the game's random numbers come from, the game owns it
+	PlayMode(MyD3D& d3d, std::shared_ptr<DirectX::DX11::SpriteFont> spriteFont, IAudioMgr* audio, const InputQueue& input, Random& random);
 	~PlayMode();
-	void Update(float dTime);
+	//dTimeNs - one tick, Game::TICK_NS
+	void Update(int64_t dTimeNs);
 	void UpdateEnemies(float dTime);
 	void Render(float dTime, DirectX::SpriteBatch& batch);
 	bool IsGameOver();
-	int GetScore() { return mScore; }
+	int GetScore() { return mScore.GetScore(); }
+	//what happened each tick, add a listener to hear about it
+	GameEventQueue& GetEvents() { return mEvents; }
+	//what's alive, for the perf overlay
+	void GetCounts(PerfOverlay::Counts& counts) const;
+	//how the enemies shoot, RandomFirePattern unless this says otherwise
+	void SetFirePattern(std::unique_ptr<IFirePattern> pattern) { mpFirePattern = std::move(pattern); }
 
 private:
 	const float SCROLL_SPEED = 10.f;
 	static const int BGND_LAYERS = 2;
 	const float SPEED = 250;
 	const float MOUSE_SPEED = 5000;
+	const float MOUSE_STEP = 1 / 60.f;	//mouse moves are distances not rates, scale them like the old 60Hz frame did
 	const float PAD_SPEED = 500;
+	const float ENEMY_SPEED = 20;			//the formation on level 1
+	const float ENEMY_SPEED_PER_LEVEL = 10;	//and how much faster each level after
 
 	MyD3D& mD3D;
 	std::shared_ptr<DirectX::DX11::SpriteFont> mSpriteFont;
 	IAudioMgr* mAudio;
+	const InputQueue& mInput;
+	Random& mRandom;
 	std::vector<Sprite> mBgnd; //parallax layers
-	Sprite mPlayer;		//jet
+	RenderProxy mPlayer;	//jet
+	Sprite mLifeSprite;	//drawn once for each life left
 	RECTF mPlayArea;	//don't go outside this	
 	std::vector<Bullet> mPlayerBullets; 
 	std::vector<Bullet> mEnemyBullets;
-	std::vector<Enemy*> mEnemies;
+	//the enemies marching in step, one transform for all of them
+	Formation mFormation;
+	RenderProxy mEnemyProto;	//what a formation enemy looks like
+	//bosses come out of this so one turning up doesn't go to the heap
+	enum { BOSS_POOL = 2 };
+	ObjectPool<BossEnemy> mBossPool;
+	std::vector<PoolPtr<Enemy>> mEnemies;	//the ones moving by themselves
+	//who can shoot, kept up to date as enemies come and go
+	ShooterIndex mShooters;
+	std::unique_ptr<IFirePattern> mpFirePattern;
 	std::vector<Shield> mShields;
 
 	//once we start thrusting we have to keep doing it for 
 	//at least a fraction of a second or it looks whack
-	float mThrusting = 0; 
+	int64_t mThrustUntilNs = 0;
+	const int64_t THRUST_NS = Clock::FromMs(200);
+	//how long this game has been running, in whole ticks so it never drifts
+	int64_t mTimeNs = 0;
 
 
 	float mEnemyBulletTimer = 2;
 	int mLives = 3;
 	float mRespawnTimer = 0;
-	int mScore = 0;
 	int mLevel = 1;
 
+	//the simulation only records events, these react to them after each tick
+	GameEventQueue mEvents;
+	AudioEventListener mSfx;
+	ScoreListener mScore;
+	TelemetryListener mTelemetry;
+
 	float mBossTimer = 5;
 
-	bool mFireDown = false;  // is the fire button currently being held down 
-	
 	ID3D11ShaderResourceView* mLivesTexture;
 	ID3D11ShaderResourceView* mEnemyTexture;
 	ID3D11ShaderResourceView* mBossTexture;
@@ -149,6 +190,13 @@ private:
 	void UpdateInput(float dTime);
 	//check for collision between bullets, and the player 
 	void UpdateCollisions();
+	//the passes UpdateCollisions makes, in this order
+	void CollidePlayerBullets();	//with enemies and enemy bullets
+	void CollideEnemyBullets();		//with the player
+	void CollideShields();			//every bullet with every shield
+
+	//ShipShootBench times the parts of a tick one at a time
+	friend class PlayModeBench;
 };
 
 
@@ -159,26 +207,103 @@ class Game
 {
 public:
 	enum class State { TITLE, PLAY, GAMEOVER };
-	static MouseAndKeys sMKIn;
-	static Gamepads sGamepads;
+	//simulation rate, input is applied at this resolution whatever the frame rate
+	enum { TICK_HZ = 120, MAX_TICKS_PER_UPDATE = 8 };
+	//every clock the simulation keeps moves on by this, whole nanoseconds so none of them drift
+	static const int64_t TICK_NS = Clock::NS_PER_SEC / TICK_HZ;
 	State state = State::TITLE;
-	Game(MyD3D& d3d);
+	//input - where the player's input comes from, e.g. Win32InputSource for the real devices
+	//audio - optional replacement for the default fmod audio manager
+	Game(MyD3D& d3d, std::unique_ptr<IInputSource> input, std::shared_ptr<IAudioMgr> audio = nullptr);
 
 	void Release();
+	//runs however many fixed ticks fit into the time since last call
 	void Update(float dTime);
 	void Render(float dTime);
+	//step by the dTime passed to Update instead of the real clock, for running
+	//flat out, a source that isn't real time turns this on by itself
+	void SetVirtualClock(bool on) { mVirtualClock = on; }
+	//write every tick's input to a file RecordedInputSource can play back
+	bool RecordInput(const std::string& fileName) { return mRecorder.Open(fileName, TICK_HZ, mRandom.GetState()); }
+	//every game played draws from this one after the other, set it before the
+	//first game (and before RecordInput) for a session that plays out the same
+	void SetRandom(const Random& random) { mRandom = random; }
+	IInputSource& GetInputSource() { return *mpInput; }
+	//follow every press through to the screen, see InputLatencyProbe
+	void MeasureInputLatency() { mpLatency = std::make_unique<InputLatencyProbe>(); }
+	const InputLatencyProbe* GetInputLatency() const { return mpLatency.get(); }
+	//games that have reached game over since we started
+	int GetNumGamesPlayed() const { return mNumGamesPlayed; }
+	//keep scores in this file and nowhere else, not the server or the usual
+	//file, so test runs don't fill the real leaderboard
+	void SetLeaderboardFile(const std::string& fileName);
+	//where a shared LeaderboardServer listens, relative to bin
+	static constexpr const char* LEADERBOARD_SOCKET = "leaderboard.sock";
+	//how many the game over screen lists
+	static const size_t TOP_SCORES = 10;
+	//F9 writes the profiler's trace here, see Profiler
+	static constexpr const char* PROFILE_FILE = "profile.json";
 private:
 	MyD3D& mD3D;
 	DirectX::SpriteBatch *mpSB = nullptr;
+	DirectX::CommonStates *mpStates = nullptr;
 	//not much of a game, but this is it
-	PlayMode* mPMode;
+	std::unique_ptr<PlayMode> mPMode;
 	Sprite mTitleSprite;
 	Sprite mGameOverBackgroundSprite;
 	std::shared_ptr<DirectX::DX11::SpriteFont> mSpriteFont;
-	std::shared_ptr<AudioMgrFMOD> mAudio;
-	std::vector<bool> mKeysPressed;
+	std::shared_ptr<IAudioMgr> mAudio;
 	std::string mPlayerName;
-	std::vector<std::pair<std::string, int> > mHighscores;
+	//slow disk writes, declared before anything that uses it so it's destroyed after them
+	PersistWorker mPersist;
+	Leaderboard mLeaderboard;				//only used if there's no server
+	std::string mLeaderboardFile = "leaderboard.dat";
+	std::string mLegacyScoreFile = "highscores.txt";	//imported the first time, if there's one
+	LeaderboardClient mLbClient;			//after Connect only the worker touches it
+	bool mUseServer = false;				//false once the server's gone, the worker finds out first
+	std::vector<LeaderboardProtocol::Score> mTopScores;	//what the game over screen shows
+	//what came back from the server, the worker adds them and Update takes them
+	struct ServerReply
+	{
+		std::string name;
+		int32_t score = 0;
+		bool submit = false;
+		bool delivered = false;		//the server has the score, it mustn't go in the file as well
+		bool unknown = false;		//sent but never acknowledged, it may have it so it can't go in the file either
+		bool connected = false;		//still there afterwards
+		bool haveTop = false;
+		std::vector<LeaderboardProtocol::Score> top;
+	};
+	std::mutex mReplyLock;
+	std::vector<ServerReply> mServerReplies;
+	//what the simulation reads, one fixed tick at a time
+	InputQueue mInput;
+	std::unique_ptr<IInputSource> mpInput;
+	InputRecorder mRecorder;
+	Random mRandom;
+	std::unique_ptr<InputLatencyProbe> mpLatency;
+	bool mVirtualClock = false;
+	int64_t mSimTimeNs = 0;		//end of the last tick, Clock::NowNs()
+	int64_t mClockNs = 0;		//where the virtual clock has got to
+	uint64_t mTickCount = 0;
+	int mNumGamesPlayed = 0;
+	//F1 shows it, timings are gathered whether it's showing or not
+	PerfOverlay mOverlay;
+	int64_t mUpdateNs = 0;			//how long the last Update took
+	bool mSteadyFrame = false;		//the last Update stayed in the same mode, see AllocTracker::EndFrame
+	int64_t mLastFrameEndNs = 0;
+
+	void UpdateTick();
+
+	void OpenLocalLeaderboard();
+	//to the server if it's there, the local file if not, never waits for either
+	void SubmitScore(const std::string& name, int score);
+	//send the score (if submit) and fetch the top on the worker, the reply goes in mServerReplies
+	void CallServer(const std::string& name, int score, bool submit);
+	//take whatever the server has sent back, anything it didn't get goes in the file
+	//false if there wasn't anything
+	bool TakeServerReplies();
+	void AddLocalScore(const std::string& name, int score);
 };
 
 
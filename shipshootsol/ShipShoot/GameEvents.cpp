@@ -0,0 +1,124 @@
+#include <cassert>
+#include <algorithm>
+
+#include "GameEvents.h"
+#include "AudioMgr.h"
+#include "Stats.h"
+
+using namespace std;
+
+GameEventQueue::GameEventQueue(size_t capacity)
+	: mEvents(capacity)
+{
+	assert(capacity > 0);
+	mListeners.reserve(8);
+}
+
+void GameEventQueue::Push(GameEventType type, float x, float y, int value)
+{
+	if (mCount == mEvents.size())
+	{
+		if (!MustKeep(type))
+		{
+			++mNumDropped;
+			return;
+		}
+		++mNumGrown;
+		mEvents.resize(mEvents.size() * 2);
+	}
+	GameEvent& e = mEvents[mCount++];
+	e.type = type;
+	e.value = static_cast<int16_t>(value);
+	e.x = x;
+	e.y = y;
+}
+
+bool GameEventQueue::MustKeep(GameEventType type)
+{
+	return type == GameEventType::KILL || type == GameEventType::LIFE_LOST || type == GameEventType::LEVEL_UP;
+}
+
+void GameEventQueue::AddListener(IGameEventListener& listener)
+{
+	assert(find(mListeners.begin(), mListeners.end(), &listener) == mListeners.end());
+	mListeners.push_back(&listener);
+}
+
+void GameEventQueue::RemoveListener(IGameEventListener& listener)
+{
+	mListeners.erase(remove(mListeners.begin(), mListeners.end(), &listener), mListeners.end());
+}
+
+void GameEventQueue::Dispatch()
+{
+	//listeners still hear about empty ticks, telemetry wants to count them
+	for (auto* pL : mListeners)
+		pL->OnGameEvents(mEvents.data(), mCount);
+	mCount = 0;
+}
+
+
+
+AudioEventListener::AudioEventListener(IAudioMgr& audio)
+	: mAudio(audio)
+{
+	const char* names[static_cast<int>(GameEventType::COUNT)]{
+		"laser",	//FIRE
+		"bang",		//HIT
+		"bang",		//KILL
+		"bang",		//SHIELD_CHIP
+		"bang",		//LIFE_LOST
+		nullptr,	//LEVEL_UP
+	};
+	for (int i = 0; i < static_cast<int>(GameEventType::COUNT); ++i)
+	{
+		mSoundIdx[i] = -1;
+		if (names[i] && !mAudio.GetSfxMgr()->Exists(names[i], &mSoundIdx[i]))
+			mSoundIdx[i] = -1;
+	}
+}
+
+void AudioEventListener::OnGameEvents(const GameEvent* pEvents, size_t count)
+{
+	//one bit per loaded sound, anything past 64 sounds just isn't coalesced
+	uint64_t started = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		int idx = mSoundIdx[static_cast<int>(pEvents[i].type)];
+		if (idx < 0)
+			continue;
+		if (idx < 64)
+		{
+			uint64_t bit = 1ull << idx;
+			if (started & bit)
+				continue;
+			started |= bit;
+		}
+		mAudio.GetSfxMgr()->Play(static_cast<unsigned int>(idx), false, false);
+	}
+}
+
+
+
+void ScoreListener::OnGameEvents(const GameEvent* pEvents, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (pEvents[i].type == GameEventType::KILL)
+			mScore += pEvents[i].value;
+	}
+}
+
+
+
+TelemetryListener::TelemetryListener()
+	: mPerTick(Stats::Get().GetHistogram("events_per_tick"))
+{
+}
+
+void TelemetryListener::OnGameEvents(const GameEvent* pEvents, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		++mTotals[static_cast<int>(pEvents[i].type)];
+	mPerTick.Add(static_cast<double>(count));
+}
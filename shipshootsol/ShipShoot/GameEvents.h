@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class IAudioMgr;
+class Histogram;
+
+//things that happen in the simulation other systems care about
+enum class GameEventType : uint8_t
+{
+	FIRE,			//player launched a missile
+	HIT,			//two bullets took each other out
+	KILL,			//an enemy died, value = score
+	SHIELD_CHIP,	//a piece of shield was shot away
+	LIFE_LOST,		//player got hit
+	LEVEL_UP,		//all enemies gone, value = new level
+	COUNT
+};
+
+//small and flat so a whole tick's worth can be copied around in one go
+struct GameEvent
+{
+	GameEventType type;
+	int16_t value;
+	float x, y;		//where it happened
+};
+
+//anything that wants to react to a tick's events in one go
+class IGameEventListener
+{
+public:
+	virtual ~IGameEventListener() {}
+	virtual void OnGameEvents(const GameEvent* pEvents, size_t count) = 0;
+};
+
+/*
+The simulation just writes down what happened into this while it runs,
+nobody gets called from inside the collision loops. Once the tick is done
+Dispatch hands the whole lot to each listener and empties it ready for
+the next tick. The buffer is allocated once up front. If a tick ever
+makes more events than that, ones that are only heard or counted (FIRE,
+HIT, SHIELD_CHIP) are dropped and counted, but KILL, LIFE_LOST and
+LEVEL_UP carry the score and the game's progress so the buffer grows to
+fit them, also counted, raise the capacity if either happens.
+*/
+class GameEventQueue
+{
+public:
+	GameEventQueue(size_t capacity = 256);
+	void Push(GameEventType type, float x, float y, int value = 0);
+	//listeners aren't owned, they're told in the order they were added
+	void AddListener(IGameEventListener& listener);
+	void RemoveListener(IGameEventListener& listener);
+	//give every listener this tick's events then start again
+	void Dispatch();
+	size_t GetCount() const { return mCount; }
+	uint64_t GetNumDropped() const { return mNumDropped; }
+	//times the buffer had to grow to keep an event that mattered
+	uint64_t GetNumGrown() const { return mNumGrown; }
+	//false for events that can be lost without changing the game
+	static bool MustKeep(GameEventType type);
+private:
+	std::vector<GameEvent> mEvents;
+	size_t mCount = 0;
+	uint64_t mNumDropped = 0;
+	uint64_t mNumGrown = 0;
+	std::vector<IGameEventListener*> mListeners;
+};
+
+/*
+Turns events into sound effects. Each sound is started at most once per
+tick however many events asked for it, five things exploding on the same
+frame is one bang, and that's decided here before the mixer is touched.
+Sound names are looked up once, not per event.
+*/
+class AudioEventListener : public IGameEventListener
+{
+public:
+	AudioEventListener(IAudioMgr& audio);
+	void OnGameEvents(const GameEvent* pEvents, size_t count) override;
+private:
+	IAudioMgr& mAudio;
+	int mSoundIdx[static_cast<int>(GameEventType::COUNT)];	//-1 = silent
+};
+
+//keeps the score, kills are worth whatever the event says
+class ScoreListener : public IGameEventListener
+{
+public:
+	void OnGameEvents(const GameEvent* pEvents, size_t count) override;
+	int GetScore() const { return mScore; }
+private:
+	int mScore = 0;
+};
+
+//running totals of each event type, plus events per tick into the stats
+class TelemetryListener : public IGameEventListener
+{
+public:
+	TelemetryListener();
+	void OnGameEvents(const GameEvent* pEvents, size_t count) override;
+	uint64_t GetTotal(GameEventType type) const { return mTotals[static_cast<int>(type)]; }
+private:
+	uint64_t mTotals[static_cast<int>(GameEventType::COUNT)] = {};
+	Histogram& mPerTick;
+};
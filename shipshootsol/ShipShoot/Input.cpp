@@ -8,6 +8,7 @@
 #include "D3D.h"
 #include "D3DUtil.h"
 #include "WindowUtils.h"
+#include "Profiler.h"
 
 using namespace std;
 using namespace DirectX;
@@ -15,9 +16,15 @@ using namespace DirectX::SimpleMath;
 
 void Gamepads::Update()
 {
+	PROFILE_ZONE("Gamepads::Update");
+	ULONGLONG nowMs = GetTickCount64();
 	for (DWORD i = 0; i < XUSER_MAX_COUNT; i++)
 	{
 		State& s = mPads[i];
+		//XInputGetState on an empty port can take a good fraction of a millisecond
+		if (s.port == -1 && nowMs < s.nextPollMs)
+			continue;
+		State last = s;
 		s.port = -1;
 		ZeroMemory(&s.state, sizeof(XINPUT_STATE));
 		if (XInputGetState(i, &s.state) == ERROR_SUCCESS)
@@ -49,14 +56,37 @@ void Gamepads::Update()
 
 			s.port = i;
 		}
+		else
+		{
+			s.leftStickX = s.leftStickY = s.rightStickX = s.rightStickY = 0;
+			s.leftTrigger = s.rightTrigger = 0;
+			s.nextPollMs = nowMs + DISCONNECTED_POLL_MS;
+		}
+		if (mpQueue)
+			PushChanges(i, last);
 	}
 
 }
 
+void Gamepads::PushChanges(int idx, const State& last)
+{
+	const State& s = mPads[idx];
+	int64_t now = Clock::NowNs();
+	if (s.state.Gamepad.wButtons != last.state.Gamepad.wButtons)
+		mpQueue->PushPadButtons(idx, s.state.Gamepad.wButtons, now);
+	if (s.leftStickX != last.leftStickX || s.leftStickY != last.leftStickY)
+		mpQueue->PushPadStick(idx, 0, s.leftStickX, s.leftStickY, now);
+	if (s.rightStickX != last.rightStickX || s.rightStickY != last.rightStickY)
+		mpQueue->PushPadStick(idx, 1, s.rightStickX, s.rightStickY, now);
+}
+
 void Gamepads::Initialise()
 {
 	for (int i = 0; i < XUSER_MAX_COUNT; ++i)
+	{
 		mPads[i].port = -1;
+		mPads[i].nextPollMs = 0;
+	}
 }
 
 
@@ -200,15 +230,21 @@ void MouseAndKeys::ProcessKeys(RAWINPUT* raw)
 	if (vkey >= 255)
 		return;
 
+	bool wasDown = mKeyBuffer[vkey] != 0;
 	if (flags & RI_KEY_BREAK) //key up
 		mKeyBuffer[vkey] = 0;
 	else
 		mKeyBuffer[vkey] = scanCode;
+	//held keys auto-repeat, only the changes are events
+	bool isDown = mKeyBuffer[vkey] != 0;
+	if (mpQueue && isDown != wasDown)
+		mpQueue->PushKey(vkey, isDown, mEventTimeNs);
 }
 
 void MouseAndKeys::ProcessMouse(RAWINPUT* raw)
 {
 	unsigned short flags = raw->data.mouse.usButtonFlags;
+	bool wasDown[MAX_BUTTONS] = { mButtons[0], mButtons[1], mButtons[2] };
 
 	if (flags & RI_MOUSE_LEFT_BUTTON_DOWN)
 		mButtons[LBUTTON] = true;
@@ -226,6 +262,14 @@ void MouseAndKeys::ProcessMouse(RAWINPUT* raw)
 	Vector2 last(mMouseScreen);
 	GetMousePosAbsolute(mMouseScreen);
 	mMouseMove = mMouseScreen - last;
+
+	if (!mpQueue)
+		return;
+	for (int i = 0; i < MAX_BUTTONS; ++i)
+		if (mButtons[i] != wasDown[i])
+			mpQueue->PushMouseButton(i, mButtons[i], mEventTimeNs);
+	if (mMouseMove.x != 0 || mMouseMove.y != 0)
+		mpQueue->PushMouseMove(mMouseMove.x, mMouseMove.y, mEventTimeNs);
 }
 
 void MouseAndKeys::GetMousePosAbsolute(Vector2& pos)
@@ -263,6 +307,13 @@ void MouseAndKeys::MessageEvent(HRAWINPUT rawInput)
 
 	RAWINPUT* raw = (RAWINPUT*)mInBuffer;
 
+	//the message may have sat in the queue a while, back date it by however long
+	//GetMessageTime is GetTickCount based, so this is only good to a few ms
+	LONG ageMs = (LONG)(GetTickCount() - (DWORD)GetMessageTime());
+	if (ageMs < 0 || ageMs > 1000)
+		ageMs = 0;
+	mEventTimeNs = Clock::NowNs() - ageMs * Clock::NS_PER_MS;
+
 	if (raw->header.dwType == RIM_TYPEKEYBOARD)
 	{
 		ProcessKeys(raw);
@@ -372,6 +423,17 @@ void MouseAndKeys::Initialise(HWND hwnd, bool showMouse, bool confineMouse)
 
 void MouseAndKeys::OnLost()
 {
+	//we won't see the key ups, so make them up
+	if (mpQueue)
+	{
+		int64_t now = Clock::NowNs();
+		for (unsigned short i = 0; i < KEYBUFF_SIZE; ++i)
+			if (mKeyBuffer[i] != 0)
+				mpQueue->PushKey(i, false, now);
+		for (int i = 0; i < MAX_BUTTONS; ++i)
+			if (mButtons[i])
+				mpQueue->PushMouseButton(i, false, now);
+	}
 	Reset();
 	ClipCursor(&mOldClip);
 }
@@ -390,3 +452,22 @@ void MouseAndKeys::PostProcess()
 
 
 
+
+
+
+//-------------------------------------------------------------
+Win32InputSource::Win32InputSource(HWND hwnd)
+{
+	mMKIn.Initialise(hwnd, true, false);
+	mGamepads.Initialise();
+}
+
+void Win32InputSource::Poll(InputQueue& queue, int64_t untilNs)
+{
+	//keys and mouse go straight in from the message pump, once we know where
+	mMKIn.SetEventQueue(&queue);
+	mGamepads.SetEventQueue(&queue);
+	mGamepads.Update();
+	//nobody reads the polled mouse movement any more, but keep it meaning "since last time"
+	mMKIn.PostProcess();
+}
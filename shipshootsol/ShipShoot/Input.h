@@ -8,6 +8,8 @@
 
 #include "D3D.h"
 #include "SimpleMath.h"
+#include "InputQueue.h"
+#include "InputSource.h"
 
 /*ideally we'd create a complete set of our key codes
 completely independently of windows, but as I'm lazy
@@ -112,10 +114,15 @@ public:
 	//case WM_INPUT:
 	//	input.MessageEvent((HRAWINPUT)lParam);
 	void MessageEvent(HRAWINPUT rawInput);
+	//also send every key/button change and mouse move here, stamped with
+	//when windows saw it, call from the same thread as MessageEvent
+	void SetEventQueue(InputQueue* pQueue) { mpQueue = pQueue; }
 
 private:
 	//copy of main window handle
 	HWND mHwnd;
+	InputQueue* mpQueue = nullptr;
+	int64_t mEventTimeNs = 0;	//when the message being processed happened
 	enum { RAWBUFF_SIZE = 512, KEYBUFF_SIZE = 255, KMASK_IS_DOWN = 1, MAX_BUTTONS = 3 };
 	//raw input buffer
 	BYTE mInBuffer[RAWBUFF_SIZE];
@@ -156,7 +163,10 @@ public:
 		float deadzoneX = 0.1f;
 		float deadzoneY = 0.1f;
 		XINPUT_STATE state;
+		ULONGLONG nextPollMs = 0;	//when to look for it again if it's not there
 	};
+	//asking about an empty port is slow, so only look for new pads this often
+	enum { DISCONNECTED_POLL_MS = 1000 };
 	//as a mechanical device the pad may generate data even when
 	//nobody is touching it, especially if it's old. The deadzone
 	//specifies a small range of input that will be ignored.
@@ -182,6 +192,8 @@ public:
 	}
 	//called every update
 	void Update();
+	//button and stick changes found by Update get pushed here too
+	void SetEventQueue(InputQueue* pQueue) { mpQueue = pQueue; }
 
 	/*
 	Is the user holding down a button or stick
@@ -208,8 +220,32 @@ public:
 private:
 	//a copy of state for each of 4 pads
 	State mPads[XUSER_MAX_COUNT];
+	InputQueue* mpQueue = nullptr;
+
+	//tell the queue about anything that changed since last time
+	void PushChanges(int idx, const State& last);
 
 };
 
 
+/*
+The real devices, raw input for mouse and keys and XInput for pads.
+Keys and mouse arrive through the window's message pump, so it needs
+MessageEvent calling from there, pads are looked at on Poll.
+*/
+class Win32InputSource : public IInputSource
+{
+public:
+	Win32InputSource(HWND hwnd);
+	void Poll(InputQueue& queue, int64_t untilNs) override;
+	bool IsRealTime() const override { return true; }
+	//from the window procedure on WM_INPUT
+	void MessageEvent(HRAWINPUT rawInput) { mMKIn.MessageEvent(rawInput); }
+	MouseAndKeys& GetMouseAndKeys() { return mMKIn; }
+	Gamepads& GetGamepads() { return mGamepads; }
+private:
+	MouseAndKeys mMKIn;
+	Gamepads mGamepads;
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "InputLatency.h"
+#include "Stats.h"
+
+//the things a player waits to see happen, not every twitch of the mouse
+static bool IsPress(const InputEvent& e)
+{
+	return e.type == InputEvent::KEY_DOWN || e.type == InputEvent::MOUSE_DOWN ||
+		(e.type == InputEvent::PAD_BUTTONS && e.code != 0);
+}
+
+InputLatencyProbe::InputLatencyProbe()
+	: mWaitHist(Stats::Get().GetHistogram("input_wait_ms")),
+	mSimHist(Stats::Get().GetHistogram("input_sim_ms")),
+	mRenderHist(Stats::Get().GetHistogram("input_render_ms")),
+	mPresentHist(Stats::Get().GetHistogram("input_present_ms")),
+	mTotalHist(Stats::Get().GetHistogram("input_total_ms"))
+{
+}
+
+void InputLatencyProbe::OnTickStart(const std::vector<InputEvent>& events, int64_t tickEndNs, bool realTime)
+{
+	int64_t now = Clock::NowNs();
+	mFirstInTick = mNumPending;
+	for (const InputEvent& e : events)
+	{
+		if (!IsPress(e))
+			continue;
+		if (mNumPending == MAX_PENDING)
+		{
+			++mNumDropped;
+			continue;
+		}
+		Record& r = mPending[mNumPending++];
+		r.waitNs = (realTime ? now : tickEndNs) - e.timeNs;
+		r.tickStartNs = now;
+		r.tickEndNs = 0;
+	}
+}
+
+void InputLatencyProbe::OnTickEnd()
+{
+	int64_t now = Clock::NowNs();
+	for (unsigned int i = mFirstInTick; i < mNumPending; ++i)
+		mPending[i].tickEndNs = now;
+	mFirstInTick = mNumPending;
+}
+
+void InputLatencyProbe::OnSubmitted()
+{
+	mSubmittedNs = Clock::NowNs();
+}
+
+void InputLatencyProbe::OnPresented(bool didPresent)
+{
+	int64_t now = Clock::NowNs();
+	int64_t presentNs = didPresent ? now - mSubmittedNs : 0;
+	for (unsigned int i = 0; i < mNumPending; ++i)
+	{
+		const Record& r = mPending[i];
+		int64_t simNs = r.tickEndNs - r.tickStartNs;
+		int64_t renderNs = mSubmittedNs - r.tickEndNs;
+		mWaitHist.Add(Clock::ToMs(r.waitNs));
+		mSimHist.Add(Clock::ToMs(simNs));
+		mRenderHist.Add(Clock::ToMs(renderNs));
+		if (didPresent)
+			mPresentHist.Add(Clock::ToMs(presentNs));
+		mTotalHist.Add(Clock::ToMs(r.waitNs + simNs + renderNs + presentNs));
+	}
+	mNumMeasured += mNumPending;
+	mNumPending = mFirstInTick = 0;
+}
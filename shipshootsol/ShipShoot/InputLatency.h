@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "InputQueue.h"
+
+class Histogram;
+
+/*
+Measures how long it takes from pressing something to seeing the result.
+Each press (key, mouse button or pad button going down) is followed
+through four stages:
+	wait	- from the device seeing it to the start of the tick that used it
+	sim		- the tick running
+	render	- from the end of the tick to the frame's draw calls being submitted
+	present	- Present, left out when running headless
+Each stage has its own "input_<stage>_ms" stats histogram, plus
+"input_total_ms" for the whole thing. On a virtual clock the wait is
+measured in simulation time, because the tick doesn't wait for the real
+clock. The other stages are always real time.
+Nothing here allocates, presses wait in a fixed table.
+*/
+class InputLatencyProbe
+{
+public:
+	enum { MAX_PENDING = 256 };
+	InputLatencyProbe();
+	//a tick has consumed these, it ends at tickEndNs on the simulation clock
+	//realTime - is the simulation clock the real one
+	void OnTickStart(const std::vector<InputEvent>& events, int64_t tickEndNs, bool realTime);
+	void OnTickEnd();
+	//the frame's draw calls have been sent
+	void OnSubmitted();
+	//Present returned, or would have if we weren't headless
+	void OnPresented(bool didPresent);
+
+	uint64_t GetNumMeasured() const { return mNumMeasured; }
+	uint64_t GetNumDropped() const { return mNumDropped; }
+private:
+	struct Record
+	{
+		int64_t waitNs;
+		int64_t tickStartNs, tickEndNs;
+	};
+	Record mPending[MAX_PENDING];
+	unsigned int mNumPending = 0;
+	//records that have started but not finished their tick
+	unsigned int mFirstInTick = 0;
+	int64_t mSubmittedNs = 0;
+	uint64_t mNumMeasured = 0;
+	uint64_t mNumDropped = 0;
+	Histogram& mWaitHist;
+	Histogram& mSimHist;
+	Histogram& mRenderHist;
+	Histogram& mPresentHist;
+	Histogram& mTotalHist;
+};
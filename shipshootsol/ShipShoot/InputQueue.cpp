@@ -0,0 +1,160 @@
+#include "InputQueue.h"
+
+using namespace std;
+
+InputQueue::InputQueue(size_t capacity)
+	: mRing(capacity)
+{
+	mTickEvents.reserve(mRing.GetCapacity());
+}
+
+bool InputQueue::Push(const InputEvent& e)
+{
+	//devices stamp their own times, never let one go backwards past another
+	InputEvent ordered = e;
+	if (ordered.timeNs < mLastPushNs)
+		ordered.timeNs = mLastPushNs;
+	mLastPushNs = ordered.timeNs;
+	if (mRing.Push(ordered))
+		return true;
+	mNumDropped.fetch_add(1, memory_order_relaxed);
+	return false;
+}
+
+bool InputQueue::PushKey(uint16_t vkey, bool down, int64_t timeNs)
+{
+	return Push(InputEvent{ timeNs, down ? InputEvent::KEY_DOWN : InputEvent::KEY_UP, 0, vkey, 0, 0 });
+}
+
+bool InputQueue::PushMouseMove(float dx, float dy, int64_t timeNs)
+{
+	return Push(InputEvent{ timeNs, InputEvent::MOUSE_MOVE, 0, 0, dx, dy });
+}
+
+bool InputQueue::PushMouseButton(int button, bool down, int64_t timeNs)
+{
+	return Push(InputEvent{ timeNs, down ? InputEvent::MOUSE_DOWN : InputEvent::MOUSE_UP, static_cast<uint8_t>(button), 0, 0, 0 });
+}
+
+bool InputQueue::PushPadButtons(int pad, uint16_t buttons, int64_t timeNs)
+{
+	return Push(InputEvent{ timeNs, InputEvent::PAD_BUTTONS, static_cast<uint8_t>(pad), buttons, 0, 0 });
+}
+
+bool InputQueue::PushPadStick(int pad, int stick, float x, float y, int64_t timeNs)
+{
+	return Push(InputEvent{ timeNs, InputEvent::PAD_STICK, static_cast<uint8_t>(pad), static_cast<uint16_t>(stick), x, y });
+}
+
+void InputQueue::ConsumeUntil(int64_t tickEndNs)
+{
+	mKeysPressed.reset();
+	mKeysReleased.reset();
+	for (bool& b : mButtonsPressed)
+		b = false;
+	for (Pad& p : mPads)
+		p.pressed = 0;
+	mMouseDX = mMouseDY = 0;
+	mTickEvents.clear();
+
+	//events are pushed in time order, so the first late one ends the tick
+	const InputEvent* pE;
+	while ((pE = mRing.Peek()) != nullptr && pE->timeNs <= tickEndNs)
+	{
+		Apply(*pE);
+		mTickEvents.push_back(*pE);
+		mRing.Pop();
+	}
+}
+
+void InputQueue::Apply(const InputEvent& e)
+{
+	switch (e.type)
+	{
+	case InputEvent::KEY_DOWN:
+		if (e.code < NUM_KEYS)
+		{
+			mKeysPressed[e.code] = mKeysPressed[e.code] || !mKeysDown[e.code];
+			mKeysDown[e.code] = true;
+		}
+		break;
+	case InputEvent::KEY_UP:
+		if (e.code < NUM_KEYS)
+		{
+			mKeysReleased[e.code] = mKeysReleased[e.code] || mKeysDown[e.code];
+			mKeysDown[e.code] = false;
+		}
+		break;
+	case InputEvent::MOUSE_MOVE:
+		mMouseDX += e.x;
+		mMouseDY += e.y;
+		break;
+	case InputEvent::MOUSE_DOWN:
+		if (e.index < NUM_BUTTONS)
+		{
+			mButtonsPressed[e.index] = mButtonsPressed[e.index] || !mButtons[e.index];
+			mButtons[e.index] = true;
+		}
+		break;
+	case InputEvent::MOUSE_UP:
+		if (e.index < NUM_BUTTONS)
+			mButtons[e.index] = false;
+		break;
+	case InputEvent::PAD_BUTTONS:
+		if (e.index < NUM_PADS)
+		{
+			Pad& p = mPads[e.index];
+			p.pressed |= e.code & ~p.buttons;
+			p.buttons = e.code;
+		}
+		break;
+	case InputEvent::PAD_STICK:
+		if (e.index < NUM_PADS && e.code < 2)
+		{
+			mPads[e.index].stick[e.code][0] = e.x;
+			mPads[e.index].stick[e.code][1] = e.y;
+		}
+		break;
+	}
+}
+
+void InputQueue::Reset()
+{
+	mKeysDown.reset();
+	mKeysPressed.reset();
+	mKeysReleased.reset();
+	for (int i = 0; i < NUM_BUTTONS; ++i)
+		mButtons[i] = mButtonsPressed[i] = false;
+	for (Pad& p : mPads)
+		p = Pad();
+	mMouseDX = mMouseDY = 0;
+}
+
+bool InputQueue::IsMouseDown(int button) const
+{
+	return button >= 0 && button < NUM_BUTTONS && mButtons[button];
+}
+
+bool InputQueue::WasMousePressed(int button) const
+{
+	return button >= 0 && button < NUM_BUTTONS && mButtonsPressed[button];
+}
+
+uint16_t InputQueue::GetPadButtons(int pad) const
+{
+	return pad >= 0 && pad < NUM_PADS ? mPads[pad].buttons : 0;
+}
+
+bool InputQueue::WasPadPressed(int pad, uint16_t button) const
+{
+	return pad >= 0 && pad < NUM_PADS && (mPads[pad].pressed & button) != 0;
+}
+
+void InputQueue::GetPadStick(int pad, int stick, float& x, float& y) const
+{
+	x = y = 0;
+	if (pad < 0 || pad >= NUM_PADS || stick < 0 || stick > 1)
+		return;
+	x = mPads[pad].stick[stick][0];
+	y = mPads[pad].stick[stick][1];
+}
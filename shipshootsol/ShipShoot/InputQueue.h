@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+#include "SpscRing.h"
+#include "Clock.h"
+
+//one thing the player did, stamped with when it happened
+struct InputEvent
+{
+	enum Type : uint8_t
+	{
+		KEY_DOWN,		//code = virtual key
+		KEY_UP,
+		MOUSE_MOVE,		//x,y = change in position
+		MOUSE_DOWN,		//index = button
+		MOUSE_UP,
+		PAD_BUTTONS,	//index = pad, code = every button held now
+		PAD_STICK,		//index = pad, code = 0 left 1 right, x,y = position
+	};
+	int64_t timeNs;		//Clock::NowNs()
+	Type type;
+	uint8_t index;
+	uint16_t code;
+	float x, y;
+};
+
+/*
+Input arrives whenever windows or the pads say so, the simulation wants
+it a tick at a time. Devices push timestamped events in from one thread
+(the message pump), the game calls ConsumeUntil with the end time of
+each fixed tick and only sees what happened up to then, anything later
+waits for the next tick. Edges are remembered per tick, so a key that
+goes down and up between two ticks still reads as pressed once.
+The events each tick consumed are kept in order for anything that wants
+to record them.
+*/
+class InputQueue
+{
+public:
+	enum { CAPACITY = 1024, NUM_KEYS = 256, NUM_BUTTONS = 3, NUM_PADS = 4 };
+	InputQueue(size_t capacity = CAPACITY);
+
+	//producer side, false and counted if the ring is full
+	bool Push(const InputEvent& e);
+	bool PushKey(uint16_t vkey, bool down, int64_t timeNs);
+	bool PushMouseMove(float dx, float dy, int64_t timeNs);
+	bool PushMouseButton(int button, bool down, int64_t timeNs);
+	bool PushPadButtons(int pad, uint16_t buttons, int64_t timeNs);
+	bool PushPadStick(int pad, int stick, float x, float y, int64_t timeNs);
+
+	//consumer side, once per tick, apply everything stamped at or before tickEndNs
+	void ConsumeUntil(int64_t tickEndNs);
+	//forget everything held, e.g. after losing focus nobody sees the key ups
+	void Reset();
+
+	//state at the end of the current tick
+	bool IsDown(uint16_t vkey) const { return vkey < NUM_KEYS && mKeysDown[vkey]; }
+	//went down/up at least once during the current tick
+	bool WasPressed(uint16_t vkey) const { return vkey < NUM_KEYS && mKeysPressed[vkey]; }
+	bool WasReleased(uint16_t vkey) const { return vkey < NUM_KEYS && mKeysReleased[vkey]; }
+	bool IsMouseDown(int button) const;
+	bool WasMousePressed(int button) const;
+	//total mouse movement during the current tick
+	float GetMouseDX() const { return mMouseDX; }
+	float GetMouseDY() const { return mMouseDY; }
+	uint16_t GetPadButtons(int pad) const;
+	bool WasPadPressed(int pad, uint16_t button) const;
+	void GetPadStick(int pad, int stick, float& x, float& y) const;
+
+	const std::vector<InputEvent>& GetTickEvents() const { return mTickEvents; }
+	uint64_t GetNumDropped() const { return mNumDropped; }
+private:
+	struct Pad
+	{
+		uint16_t buttons = 0, pressed = 0;
+		float stick[2][2] = {};
+	};
+	void Apply(const InputEvent& e);
+
+	SpscRing<InputEvent> mRing;
+	int64_t mLastPushNs = 0;	//producer only
+	std::atomic<uint64_t> mNumDropped{ 0 };
+
+	std::bitset<NUM_KEYS> mKeysDown, mKeysPressed, mKeysReleased;
+	bool mButtons[NUM_BUTTONS] = {}, mButtonsPressed[NUM_BUTTONS] = {};
+	float mMouseDX = 0, mMouseDY = 0;
+	Pad mPads[NUM_PADS];
+	std::vector<InputEvent> mTickEvents;
+};
@@ -0,0 +1,148 @@
+#include <cstring>
+#include <algorithm>
+
+#include "InputSource.h"
+
+using namespace std;
+
+//"SSIN", version, tick rate, Random state (from version 2), then one record per event
+static const char MAGIC[4] = { 'S', 'S', 'I', 'N' };
+static const uint32_t VERSION = 2;
+
+//tick, type, index, code, x, y
+static const size_t RECORD_SIZE = 8 + 1 + 1 + 2 + 4 + 4;
+
+ScriptedInputSource::ScriptedInputSource(int tickHz, size_t maxPending)
+	: mTickNs(Clock::NS_PER_SEC / tickHz)
+{
+	mEvents.reserve(maxPending);
+}
+
+void ScriptedInputSource::Add(uint64_t tick, const InputEvent& e)
+{
+	mEvents.push_back(Pending{ tick, mNextSeq++, e });
+	push_heap(mEvents.begin(), mEvents.end(), Later());
+}
+
+void ScriptedInputSource::Key(uint64_t tick, uint16_t vkey, bool down)
+{
+	Add(tick, InputEvent{ 0, down ? InputEvent::KEY_DOWN : InputEvent::KEY_UP, 0, vkey, 0, 0 });
+}
+
+void ScriptedInputSource::Tap(uint64_t tick, uint16_t vkey, uint64_t holdTicks)
+{
+	Key(tick, vkey, true);
+	Key(tick + holdTicks, vkey, false);
+}
+
+void ScriptedInputSource::MouseMove(uint64_t tick, float dx, float dy)
+{
+	Add(tick, InputEvent{ 0, InputEvent::MOUSE_MOVE, 0, 0, dx, dy });
+}
+
+void ScriptedInputSource::MouseButton(uint64_t tick, int button, bool down)
+{
+	Add(tick, InputEvent{ 0, down ? InputEvent::MOUSE_DOWN : InputEvent::MOUSE_UP, static_cast<uint8_t>(button), 0, 0, 0 });
+}
+
+void ScriptedInputSource::PadButtons(uint64_t tick, int pad, uint16_t buttons)
+{
+	Add(tick, InputEvent{ 0, InputEvent::PAD_BUTTONS, static_cast<uint8_t>(pad), buttons, 0, 0 });
+}
+
+void ScriptedInputSource::PadStick(uint64_t tick, int pad, int stick, float x, float y)
+{
+	Add(tick, InputEvent{ 0, InputEvent::PAD_STICK, static_cast<uint8_t>(pad), static_cast<uint16_t>(stick), x, y });
+}
+
+void ScriptedInputSource::Start(int64_t startNs)
+{
+	mStartNs = startNs;
+	mNextBotTick = 1;
+}
+
+void ScriptedInputSource::Poll(InputQueue& queue, int64_t untilNs)
+{
+	if (untilNs < mStartNs)
+		return;
+	uint64_t lastTick = static_cast<uint64_t>((untilNs - mStartNs) / mTickNs);
+	for (; mBot && mNextBotTick <= lastTick; ++mNextBotTick)
+		mBot(*this, mNextBotTick);
+	//stamp with the end of the tick so it's consumed by that tick and no earlier
+	while (!mEvents.empty() && mEvents.front().tick <= lastTick)
+	{
+		InputEvent e = mEvents.front().e;
+		e.timeNs = mStartNs + static_cast<int64_t>(mEvents.front().tick) * mTickNs;
+		if (!queue.Push(e))
+			break;
+		pop_heap(mEvents.begin(), mEvents.end(), Later());
+		mEvents.pop_back();
+	}
+}
+
+bool RecordedInputSource::Load(const std::string& fileName)
+{
+	FILE* pFile = fopen(fileName.c_str(), "rb");
+	if (!pFile)
+		return false;
+	char magic[4];
+	uint32_t version, tickHz;
+	bool ok = fread(magic, 4, 1, pFile) == 1 && memcmp(magic, MAGIC, 4) == 0 &&
+		fread(&version, 4, 1, pFile) == 1 && version >= 1 && version <= VERSION &&
+		fread(&tickHz, 4, 1, pFile) == 1 && tickHz != 0 && Clock::NS_PER_SEC / tickHz == mTickNs;
+	if (ok && version >= 2)
+		ok = fread(mRandomState.s, sizeof(mRandomState.s), 1, pFile) == 1;
+	uint8_t rec[RECORD_SIZE];
+	while (ok && fread(rec, RECORD_SIZE, 1, pFile) == 1)
+	{
+		uint64_t tick;
+		InputEvent e{};
+		memcpy(&tick, rec, 8);
+		e.type = static_cast<InputEvent::Type>(rec[8]);
+		e.index = rec[9];
+		memcpy(&e.code, rec + 10, 2);
+		memcpy(&e.x, rec + 12, 4);
+		memcpy(&e.y, rec + 16, 4);
+		Add(tick, e);
+	}
+	fclose(pFile);
+	return ok;
+}
+
+bool InputRecorder::Open(const std::string& fileName, int tickHz, const Random::State& random)
+{
+	Close();
+	mpFile = fopen(fileName.c_str(), "wb");
+	if (!mpFile)
+		return false;
+	uint32_t hz = static_cast<uint32_t>(tickHz);
+	fwrite(MAGIC, 4, 1, mpFile);
+	fwrite(&VERSION, 4, 1, mpFile);
+	fwrite(&hz, 4, 1, mpFile);
+	fwrite(random.s, sizeof(random.s), 1, mpFile);
+	return true;
+}
+
+void InputRecorder::Write(uint64_t tick, const std::vector<InputEvent>& events)
+{
+	if (!mpFile)
+		return;
+	uint8_t rec[RECORD_SIZE];
+	for (const InputEvent& e : events)
+	{
+		memcpy(rec, &tick, 8);
+		rec[8] = e.type;
+		rec[9] = e.index;
+		memcpy(rec + 10, &e.code, 2);
+		memcpy(rec + 12, &e.x, 4);
+		memcpy(rec + 16, &e.y, 4);
+		fwrite(rec, RECORD_SIZE, 1, mpFile);
+	}
+}
+
+void InputRecorder::Close()
+{
+	if (mpFile)
+		fclose(mpFile);
+	mpFile = nullptr;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "InputQueue.h"
+#include "Random.h"
+
+/*
+Somewhere input comes from. The game owns one and polls it once per
+update with how far the simulation is about to run, the source pushes
+whatever has happened by then into the queue. Live devices (see
+Win32InputSource in Input.h) push as things happen and follow the real
+clock, the others here make their input up and are happy for the game
+to run as fast as it can.
+*/
+class IInputSource
+{
+public:
+	virtual ~IInputSource() {}
+	//the simulation clock starts at startNs, tick n ends at startNs + n * tick length
+	virtual void Start(int64_t /*startNs*/) {}
+	//push everything up to untilNs
+	virtual void Poll(InputQueue& queue, int64_t untilNs) = 0;
+	//false if the game should step on its own clock rather than the real one
+	virtual bool IsRealTime() const = 0;
+	//nothing more will ever come
+	virtual bool IsFinished() const { return false; }
+};
+
+/*
+Input made up by code, for automated players and tests. Events are
+queued against the tick they should be seen in, counting from 1 for the
+first tick, and a bot callback gets to queue more at the start of every
+tick so it can react to whatever it's watching. Runs on the simulation's
+clock, never the real one. Waiting events are a binary heap in a vector
+that's reserved up front, so a bot queueing a few every tick doesn't
+allocate once it's going.
+*/
+class ScriptedInputSource : public IInputSource
+{
+public:
+	//called once per tick before the game sees it
+	typedef std::function<void(ScriptedInputSource& src, uint64_t tick)> Bot;
+
+	//maxPending - events that can be waiting before the vector has to grow
+	ScriptedInputSource(int tickHz, size_t maxPending = 256);
+
+	void Key(uint64_t tick, uint16_t vkey, bool down);
+	//down at tick, up again holdTicks later
+	void Tap(uint64_t tick, uint16_t vkey, uint64_t holdTicks = 1);
+	void MouseMove(uint64_t tick, float dx, float dy);
+	void MouseButton(uint64_t tick, int button, bool down);
+	void PadButtons(uint64_t tick, int pad, uint16_t buttons);
+	void PadStick(uint64_t tick, int pad, int stick, float x, float y);
+	void SetBot(Bot bot) { mBot = bot; }
+
+	void Start(int64_t startNs) override;
+	void Poll(InputQueue& queue, int64_t untilNs) override;
+	bool IsRealTime() const override { return false; }
+	bool IsFinished() const override { return !mBot && mEvents.empty(); }
+protected:
+	void Add(uint64_t tick, const InputEvent& e);
+	int64_t mTickNs;
+private:
+	int64_t mStartNs = 0;
+	uint64_t mNextBotTick = 1;
+	struct Pending
+	{
+		uint64_t tick;
+		uint64_t seq;		//order added, same tick keeps it
+		InputEvent e;
+	};
+	//soonest on top
+	struct Later
+	{
+		bool operator()(const Pending& a, const Pending& b) const
+		{
+			return a.tick != b.tick ? a.tick > b.tick : a.seq > b.seq;
+		}
+	};
+	std::vector<Pending> mEvents;
+	uint64_t mNextSeq = 0;
+	Bot mBot;
+};
+
+/*
+Plays back a file InputRecorder wrote. Events come back in exactly the
+ticks they were consumed in when recorded, so the game sees the same
+input tick for tick however fast either run went. The game's random
+numbers have to start where the recording's did too, see
+GetRandomState.
+*/
+class RecordedInputSource : public ScriptedInputSource
+{
+public:
+	RecordedInputSource(int tickHz) : ScriptedInputSource(tickHz) {}
+	//false if it's missing, damaged or recorded at a different tick rate
+	bool Load(const std::string& fileName);
+	//what the game's Random was when recording started, the default seed for old files
+	const Random::State& GetRandomState() const { return mRandomState; }
+private:
+	Random::State mRandomState = Random().GetState();
+};
+
+/*
+Writes down each tick's input as the game consumes it, ready for
+RecordedInputSource. Buffered, a tick with no input costs nothing.
+*/
+class InputRecorder
+{
+public:
+	~InputRecorder() { Close(); }
+	//random - the game's Random as it is now, saved with the input
+	bool Open(const std::string& fileName, int tickHz, const Random::State& random);
+	void Write(uint64_t tick, const std::vector<InputEvent>& events);
+	void Close();
+	bool IsOpen() const { return mpFile != nullptr; }
+private:
+	FILE* mpFile = nullptr;
+};
@@ -0,0 +1,416 @@
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+#include "Leaderboard.h"
+#include "PersistWorker.h"
+
+using namespace std;
+
+static const char SNAPSHOT_MAGIC[4] = { 'S','S','L','B' };
+static const uint32_t SNAPSHOT_VERSION = 1;
+//biggest the rank tree gets, higher scores are ranked as if they were this
+static const size_t MAX_RANK_SLOTS = 1 << 20;
+//what the rank tree starts with, it doubles when a score doesn't fit
+static const size_t FIRST_RANK_SLOTS = 1024;
+
+struct Crc32Table
+{
+	uint32_t entries[256];
+};
+
+static constexpr Crc32Table MakeCrc32Table()
+{
+	Crc32Table table = {};
+	for (uint32_t i = 0; i < 256; ++i)
+	{
+		uint32_t c = i;
+		for (int k = 0; k < 8; ++k)
+			c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+		table.entries[i] = c;
+	}
+	return table;
+}
+
+//built by the compiler, the server's shard threads all use it
+static constexpr Crc32Table CRC32_TABLE = MakeCrc32Table();
+
+static constexpr uint32_t Crc32(const uint8_t* p, size_t numBytes)
+{
+	uint32_t crc = 0xFFFFFFFFu;
+	for (size_t i = 0; i < numBytes; ++i)
+		crc = CRC32_TABLE.entries[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+	return crc ^ 0xFFFFFFFFu;
+}
+
+//the standard check value, a table or loop that's wrong doesn't build
+static constexpr uint8_t CRC32_CHECK[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+static_assert(Crc32(CRC32_CHECK, sizeof(CRC32_CHECK)) == 0xCBF43926u, "Crc32 isn't CRC-32");
+
+//little helpers for packing records into a byte buffer
+template<typename T> static void Put(vector<uint8_t>& buf, T v)
+{
+	const uint8_t* p = reinterpret_cast<const uint8_t*>(&v);
+	buf.insert(buf.end(), p, p + sizeof(T));
+}
+template<typename T> static bool Get(const uint8_t*& p, const uint8_t* pEnd, T& v)
+{
+	if (pEnd - p < static_cast<ptrdiff_t>(sizeof(T)))
+		return false;
+	memcpy(&v, p, sizeof(T));
+	p += sizeof(T);
+	return true;
+}
+static void PutEntry(vector<uint8_t>& buf, const Leaderboard::Entry& e)
+{
+	Put(buf, e.score);
+	Put(buf, e.seq);
+	Put(buf, static_cast<uint8_t>(e.name.size()));
+	buf.insert(buf.end(), e.name.begin(), e.name.end());
+}
+static bool GetEntry(const uint8_t*& p, const uint8_t* pEnd, Leaderboard::Entry& e)
+{
+	uint8_t len;
+	if (!Get(p, pEnd, e.score) || !Get(p, pEnd, e.seq) || !Get(p, pEnd, len) || pEnd - p < len)
+		return false;
+	e.name.assign(reinterpret_cast<const char*>(p), len);
+	p += len;
+	return true;
+}
+
+static bool ReadWholeFile(const std::string& fileName, vector<uint8_t>& bytes)
+{
+	ifstream in(fileName, ios::binary);
+	if (!in)
+		return false;
+	bytes.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+	return true;
+}
+
+Leaderboard::Leaderboard(size_t topK)
+	: mTopK(topK)
+{
+	assert(topK > 0);
+	//usable in memory without ever being opened
+	mRanks.assign(FIRST_RANK_SLOTS + 1, 0);
+}
+
+Leaderboard::~Leaderboard()
+{
+	Close();
+}
+
+bool Leaderboard::Open(const std::string& fileName, const std::string& legacyFile)
+{
+	Close();
+	mTop.clear();
+	mCounts.clear();
+	mRanks.assign(FIRST_RANK_SLOTS + 1, 0);
+	mNumEntries = mNextSeq = 0;
+	mJournalRecords = 0;
+	mFileName = fileName;
+	mJournalName = fileName + ".log";
+
+	error_code ec;
+	bool haveSnapshot = filesystem::exists(mFileName, ec);
+	bool haveJournal = filesystem::exists(mJournalName, ec);
+	if (haveSnapshot && !LoadSnapshot(mFileName))
+	{
+		//keep it for inspection but carry on with what the journal has
+		filesystem::rename(mFileName, mFileName + ".bad", ec);
+	}
+	long goodBytes = 0;
+	bool torn = false;
+	if (haveJournal)
+	{
+		ReplayJournal(mJournalName, goodBytes);
+		torn = goodBytes != static_cast<long>(filesystem::file_size(mJournalName, ec));
+	}
+	bool imported = !haveSnapshot && !haveJournal && !legacyFile.empty() && ImportLegacy(legacyFile);
+
+	mpJournal = fopen(mJournalName.c_str(), "ab");
+	if (!mpJournal)
+		return false;
+	mOpen = true;
+	//a torn record at the end would hide everything appended after it, so start a fresh journal
+	if (imported || torn || mJournalRecords >= GetCompactThreshold())
+		return Compact();
+	return true;
+}
+
+void Leaderboard::Close()
+{
+	if (!mOpen)
+		return;
+	if (mJournalRecords)
+		Compact();
+	//the worker may still be using the journal
+	if (mpWorker)
+		mpWorker->Flush();
+	if (mpJournal)
+		fclose(mpJournal);
+	mpJournal = nullptr;
+	mOpen = false;
+}
+
+bool Leaderboard::Add(const std::string& name, int32_t score, bool sync, uint64_t seq)
+{
+	//the journal replay skips anything below the snapshot's seq, so it can only go up
+	assert(seq == NEXT_SEQ || seq >= mNextSeq);
+	Entry e;
+	e.name = name.substr(0, MAX_NAME);
+	e.score = score;
+	e.seq = seq == NEXT_SEQ ? mNextSeq : seq;
+	mNextSeq = e.seq + 1;
+	Insert(e);
+	if (!mOpen)
+		return false;
+	bool ok = AppendJournal(e, sync);
+	if (++mJournalRecords >= GetCompactThreshold())
+		ok = Compact() && ok;
+	return ok;
+}
+
+size_t Leaderboard::GetCompactThreshold() const
+{
+	//the snapshot grows with the number of different scores, don't rewrite it more often than the journal catches up
+	return max<size_t>(COMPACT_EVERY, mCounts.size());
+}
+
+bool Leaderboard::Sync()
+{
+	if (!mOpen)
+		return false;
+	return RunDiskJob("", [this]() { return mpJournal && PersistWorker::FlushToDisk(mpJournal); });
+}
+
+bool Leaderboard::RunDiskJob(const std::string& key, std::function<bool()> job)
+{
+	if (!mpWorker)
+		return job();
+	mpWorker->Submit(key, move(job));
+	return true;
+}
+
+uint64_t Leaderboard::GetRank(int32_t score) const
+{
+	size_t slot = min(ScoreSlot(score), mRanks.size() - 1);
+	return mNumEntries - CountUpTo(slot) + 1;
+}
+
+void Leaderboard::Insert(const Entry& e)
+{
+	++mCounts[e.score];
+	++mNumEntries;
+	GrowRanks(e.score);
+	AddRank(ScoreSlot(e.score), 1);
+	if (mTop.size() < mTopK)
+		mTop.insert(e);
+	else if (Better()(e, *mTop.rbegin()))
+	{
+		mTop.insert(e);
+		mTop.erase(prev(mTop.end()));
+	}
+}
+
+//**************************************************************************************************
+//ranks
+
+size_t Leaderboard::ScoreSlot(int32_t score) const
+{
+	if (score < 0)
+		return 1;
+	return min(static_cast<size_t>(score) + 1, MAX_RANK_SLOTS);
+}
+
+void Leaderboard::GrowRanks(int32_t score)
+{
+	size_t slot = ScoreSlot(score);
+	size_t n = mRanks.size() - 1;
+	while (slot > n)
+	{
+		//doubling a power of two sized tree only adds one non zero node, the total at the new top
+		uint64_t total = CountUpTo(n);
+		mRanks.resize(n * 2 + 1, 0);
+		n *= 2;
+		mRanks[n] = total;
+	}
+}
+
+void Leaderboard::AddRank(size_t slot, uint64_t count)
+{
+	for (size_t i = slot; i < mRanks.size(); i += i & (~i + 1))
+		mRanks[i] += count;
+}
+
+uint64_t Leaderboard::CountUpTo(size_t slot) const
+{
+	uint64_t sum = 0;
+	for (size_t i = slot; i > 0; i -= i & (~i + 1))
+		sum += mRanks[i];
+	return sum;
+}
+
+//**************************************************************************************************
+//disk
+
+/*
+snapshot:
+	"SSLB" version nextSeq numEntries numTop numCounts
+	numTop x (score seq nameLen name)
+	numCounts x (score count)
+	crc32 of all the above
+journal record:
+	uint16 length, length bytes of (score seq nameLen name), crc32 of those bytes
+*/
+bool Leaderboard::LoadSnapshot(const std::string& fileName)
+{
+	vector<uint8_t> bytes;
+	if (!ReadWholeFile(fileName, bytes) || bytes.size() < 36 || memcmp(bytes.data(), SNAPSHOT_MAGIC, 4) != 0)
+		return false;
+	uint32_t crc;
+	memcpy(&crc, bytes.data() + bytes.size() - 4, 4);
+	if (crc != Crc32(bytes.data(), bytes.size() - 4))
+		return false;
+
+	const uint8_t* p = bytes.data() + 4;
+	const uint8_t* pEnd = bytes.data() + bytes.size() - 4;
+	uint32_t version, numTop, numCounts;
+	uint64_t nextSeq, numEntries;
+	if (!Get(p, pEnd, version) || version != SNAPSHOT_VERSION || !Get(p, pEnd, nextSeq) || !Get(p, pEnd, numEntries) ||
+		!Get(p, pEnd, numTop) || !Get(p, pEnd, numCounts))
+		return false;
+	TopSet top;
+	for (uint32_t i = 0; i < numTop; ++i)
+	{
+		Entry e;
+		if (!GetEntry(p, pEnd, e))
+			return false;
+		top.insert(e);
+	}
+	map<int32_t, uint64_t> counts;
+	for (uint32_t i = 0; i < numCounts; ++i)
+	{
+		int32_t score;
+		uint64_t count;
+		if (!Get(p, pEnd, score) || !Get(p, pEnd, count))
+			return false;
+		counts[score] = count;
+	}
+
+	//all good, take it
+	while (top.size() > mTopK)
+		top.erase(prev(top.end()));
+	mTop.swap(top);
+	mCounts.swap(counts);
+	for (auto& c : mCounts)
+	{
+		GrowRanks(c.first);
+		AddRank(ScoreSlot(c.first), c.second);
+	}
+	mNumEntries = numEntries;
+	mNextSeq = nextSeq;
+	return true;
+}
+
+void Leaderboard::ReplayJournal(const std::string& fileName, long& goodBytes)
+{
+	goodBytes = 0;
+	vector<uint8_t> bytes;
+	if (!ReadWholeFile(fileName, bytes))
+		return;
+	const uint8_t* p = bytes.data();
+	const uint8_t* pEnd = p + bytes.size();
+	uint16_t len;
+	while (Get(p, pEnd, len) && pEnd - p >= len + 4)
+	{
+		uint32_t crc;
+		memcpy(&crc, p + len, 4);
+		if (crc != Crc32(p, len))
+			break;
+		const uint8_t* pRec = p;
+		Entry e;
+		if (!GetEntry(pRec, p + len, e))
+			break;
+		p += len + 4;
+		goodBytes = static_cast<long>(p - bytes.data());
+		//anything before the snapshot's seq is already in it (we died between writing it and clearing this)
+		if (e.seq < mNextSeq)
+			continue;
+		Insert(e);
+		mNextSeq = e.seq + 1;
+		++mJournalRecords;
+	}
+}
+
+bool Leaderboard::ImportLegacy(const std::string& fileName)
+{
+	//name on one line, score on the next
+	ifstream in(fileName);
+	if (!in)
+		return false;
+	string name, score;
+	bool any = false;
+	while (getline(in, name) && getline(in, score))
+	{
+		if (!name.empty() && name.back() == '\r')
+			name.pop_back();
+		Entry e;
+		e.name = name.substr(0, MAX_NAME);
+		e.score = atoi(score.c_str());
+		e.seq = mNextSeq++;
+		Insert(e);
+		any = true;
+	}
+	return any;
+}
+
+bool Leaderboard::AppendJournal(const Entry& e, bool sync)
+{
+	vector<uint8_t> rec;
+	rec.reserve(64);
+	Put(rec, uint16_t(0));
+	PutEntry(rec, e);
+	uint16_t len = static_cast<uint16_t>(rec.size() - 2);
+	memcpy(rec.data(), &len, 2);
+	Put(rec, Crc32(rec.data() + 2, len));
+	return RunDiskJob("", [this, rec, sync]() {
+		return mpJournal && fwrite(rec.data(), 1, rec.size(), mpJournal) == rec.size() &&
+			(!sync || PersistWorker::FlushToDisk(mpJournal));
+	});
+}
+
+bool Leaderboard::Compact()
+{
+	vector<uint8_t> buf;
+	buf.insert(buf.end(), SNAPSHOT_MAGIC, SNAPSHOT_MAGIC + 4);
+	Put(buf, SNAPSHOT_VERSION);
+	Put(buf, mNextSeq);
+	Put(buf, mNumEntries);
+	Put(buf, static_cast<uint32_t>(mTop.size()));
+	Put(buf, static_cast<uint32_t>(mCounts.size()));
+	for (auto& e : mTop)
+		PutEntry(buf, e);
+	for (auto& c : mCounts)
+	{
+		Put(buf, c.first);
+		Put(buf, c.second);
+	}
+	Put(buf, Crc32(buf.data(), buf.size()));
+
+	//the snapshot is built here, only the writing goes to the worker
+	//a newer one waiting to be written replaces this one, the journal records in between are
+	//written after it and skipped on load because the snapshot already has them
+	mJournalRecords = 0;
+	return RunDiskJob(mFileName, [this, buf = move(buf)]() {
+		if (!PersistWorker::WriteFileAtomic(mFileName, buf.data(), buf.size()))
+			return false;
+		//now the journal is redundant
+		if (mpJournal)
+			fclose(mpJournal);
+		mpJournal = fopen(mJournalName.c_str(), "wb");
+		return mpJournal != nullptr;
+	});
+}
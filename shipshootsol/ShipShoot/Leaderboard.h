@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <functional>
+
+class PersistWorker;
+
+/*
+Every score anyone has ever got, kept so that adding one is cheap however
+many there are already.
+On disk there's a snapshot (the top entries with names plus a count of how
+many times each score was reached) and a journal that every new score is
+appended to. Loading reads the snapshot then replays the journal. Every so
+often the journal is folded into a new snapshot, written to a temp file and
+renamed over the old one, so a crash at any point loses at most the record
+being written. Journal records carry a crc and a torn one at the end is
+ignored.
+The disk work can be handed to a PersistWorker so adding a score never
+waits for the disk, without one it all happens in the calling thread.
+In memory only the best few entries keep their names (a set, so adding is
+O(log K)) and all scores go into a Fenwick tree so the rank of any score
+is O(log range) even with millions of them.
+*/
+class Leaderboard
+{
+public:
+	struct Entry
+	{
+		std::string name;
+		int32_t score = 0;
+		uint64_t seq = 0;		//order they were added, the earlier of two equal scores ranks higher
+	};
+	struct Better
+	{
+		bool operator()(const Entry& a, const Entry& b) const
+		{
+			return a.score != b.score ? a.score > b.score : a.seq < b.seq;
+		}
+	};
+	typedef std::set<Entry, Better> TopSet;
+	//names are cut to this
+	enum { MAX_NAME = 32 };
+	//the journal gets folded into the snapshot after at least this many records
+	enum { COMPACT_EVERY = 4096 };
+
+	Leaderboard(size_t topK = 10);
+	~Leaderboard();
+	Leaderboard(const Leaderboard&) = delete;
+	void operator=(const Leaderboard&) = delete;
+
+	//fileName - the snapshot, the journal is the same name + ".log"
+	//legacyFile - old name/score text file to import if there's no snapshot or journal yet
+	bool Open(const std::string& fileName, const std::string& legacyFile = "");
+	//compacts and closes the journal, waits for the worker to finish with it
+	void Close();
+	bool IsOpen() const { return mOpen; }
+	//disk writes go through this from now on, nullptr = write them straight away
+	//set it before Open and keep it alive until after Close
+	void SetWorker(PersistWorker* pWorker) { mpWorker = pWorker; }
+	//false if it couldn't be written to disk (with a worker it's just queued, see its failure count)
+	//either way it's on the board until we quit
+	//sync - wait for it to reach the disk, batch runs pass false and Sync() at the end
+	//seq - where it goes among equal scores, NEXT_SEQ for after everything so far,
+	//otherwise at least GetNextSeq() (several boards sharing one order, see LeaderboardServer)
+	static const uint64_t NEXT_SEQ = UINT64_MAX;
+	bool Add(const std::string& name, int32_t score, bool sync = true, uint64_t seq = NEXT_SEQ);
+	bool Sync();
+	//fold the journal into a new snapshot
+	bool Compact();
+
+	//best first
+	const TopSet& GetTop() const { return mTop; }
+	//1 = best, entries with the same score share a rank (negative scores count as 0)
+	uint64_t GetRank(int32_t score) const;
+	uint64_t GetNumEntries() const { return mNumEntries; }
+	uint64_t GetNextSeq() const { return mNextSeq; }
+	size_t GetNumJournalRecords() const { return mJournalRecords; }
+private:
+	void Insert(const Entry& e);
+	size_t GetCompactThreshold() const;
+	bool LoadSnapshot(const std::string& fileName);
+	void ReplayJournal(const std::string& fileName, long& goodBytes);
+	bool ImportLegacy(const std::string& fileName);
+	bool AppendJournal(const Entry& e, bool sync);
+	//run it now or hand it to the worker
+	bool RunDiskJob(const std::string& key, std::function<bool()> job);
+	//score -> Fenwick index, negative scores rank as 0 and scores past the end share the last slot
+	size_t ScoreSlot(int32_t score) const;
+	void GrowRanks(int32_t score);
+	void AddRank(size_t slot, uint64_t count);
+	uint64_t CountUpTo(size_t slot) const;
+
+	size_t mTopK;
+	TopSet mTop;
+	std::map<int32_t, uint64_t> mCounts;	//every score reached and how often, what the snapshot stores
+	std::vector<uint64_t> mRanks;			//Fenwick tree over score, 1 based, size is a power of two
+	uint64_t mNumEntries = 0;
+	uint64_t mNextSeq = 0;
+	std::string mFileName, mJournalName;
+	FILE* mpJournal = nullptr;			//only touched by disk jobs once open
+	bool mOpen = false;
+	PersistWorker* mpWorker = nullptr;
+	size_t mJournalRecords = 0;
+};
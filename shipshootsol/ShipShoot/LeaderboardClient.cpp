@@ -0,0 +1,105 @@
+#include <algorithm>
+
+#include "LeaderboardClient.h"
+
+using namespace std;
+using namespace LeaderboardProtocol;
+
+bool LeaderboardClient::Connect(const std::string& path, int timeoutMs)
+{
+	return mSock.Connect(path, timeoutMs);
+}
+
+void LeaderboardClient::Close()
+{
+	mSock.Close();
+}
+
+void LeaderboardClient::Queue(const std::string& name, int32_t score)
+{
+	Score s;
+	s.name = name.substr(0, MAX_NAME);
+	s.score = score;
+	mQueued.push_back(s);
+}
+
+bool LeaderboardClient::Flush()
+{
+	size_t sent = 0;
+	mNumUnknown = 0;
+	while (sent < mQueued.size())
+	{
+		size_t count = min<size_t>(mQueued.size() - sent, MAX_BATCH);
+		mRequest.Clear();
+		mRequest.Put(static_cast<uint16_t>(count));
+		for (size_t i = 0; i < count; ++i)
+			mRequest.PutScore(mQueued[sent + i]);
+		uint32_t accepted = 0;
+		bool requestSent = false;
+		if (!Call(SUBMIT, SUBMIT_OK, &requestSent) || !Reader(mReply).Get(accepted) || accepted != count)
+		{
+			//only a request that never got out whole is certain not to have been stored
+			mQueued.erase(mQueued.begin(), mQueued.begin() + sent);
+			mNumUnknown = requestSent ? count : 0;
+			Close();
+			return false;
+		}
+		sent += count;
+	}
+	mQueued.clear();
+	return true;
+}
+
+bool LeaderboardClient::GetTop(size_t n, std::vector<LeaderboardProtocol::Score>& top)
+{
+	mRequest.Clear();
+	mRequest.Put(static_cast<uint16_t>(min<size_t>(n, 0xFFFF)));
+	if (!Call(TOP, TOP_OK))
+		return false;
+	Reader r(mReply);
+	uint16_t count;
+	if (!r.Get(count))
+		return false;
+	top.resize(count);
+	for (auto& s : top)
+	{
+		if (!r.GetScore(s))
+		{
+			Close();
+			return false;
+		}
+	}
+	return true;
+}
+
+bool LeaderboardClient::GetRank(int32_t score, uint64_t& rank, uint64_t& total)
+{
+	mRequest.Clear();
+	mRequest.Put(score);
+	if (!Call(RANK, RANK_OK))
+		return false;
+	Reader r(mReply);
+	return r.Get(rank) && r.Get(total);
+}
+
+bool LeaderboardClient::Call(LeaderboardProtocol::MsgType type, LeaderboardProtocol::MsgType expect, bool* pSent)
+{
+	if (pSent)
+		*pSent = false;
+	if (!IsConnected())
+		return false;
+	if (!Send(mSock, type, mRequest.GetBytes()))
+	{
+		Close();
+		return false;
+	}
+	if (pSent)
+		*pSent = true;
+	MsgType got;
+	if (!Receive(mSock, got, mReply) || got != expect)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "LocalSocket.h"
+#include "LeaderboardProtocol.h"
+
+/*
+Talks to a LeaderboardServer running on the same machine. Scores are
+queued and sent together by Flush, one message per batch. Any failure
+closes the connection so the caller can fall back to its own file.
+*/
+class LeaderboardClient
+{
+public:
+	//timeoutMs - how long any one call can wait for the server
+	bool Connect(const std::string& path, int timeoutMs = 250);
+	void Close();
+	bool IsConnected() const { return mSock.IsOpen(); }
+
+	void Queue(const std::string& name, int32_t score);
+	//send everything queued, whatever wasn't acknowledged stays queued
+	bool Flush();
+	//after a failed Flush, how many at the front of the queue went out whole but
+	//weren't acknowledged, the server may well have them so sending again could count them twice
+	size_t GetNumUnknown() const { return mNumUnknown; }
+	const std::vector<LeaderboardProtocol::Score>& GetQueued() const { return mQueued; }
+	void ClearQueued() { mQueued.clear(); }
+
+	//best first
+	bool GetTop(size_t n, std::vector<LeaderboardProtocol::Score>& top);
+	//1 = best, total = how many scores the server has
+	bool GetRank(int32_t score, uint64_t& rank, uint64_t& total);
+private:
+	//send a request and wait for the one reply it should get
+	//pSent - set if the whole request went, whether or not an answer came
+	bool Call(LeaderboardProtocol::MsgType type, LeaderboardProtocol::MsgType expect, bool* pSent = nullptr);
+
+	LocalSocket mSock;
+	std::vector<LeaderboardProtocol::Score> mQueued;
+	size_t mNumUnknown = 0;
+	LeaderboardProtocol::Writer mRequest;
+	std::vector<uint8_t> mReply;
+};
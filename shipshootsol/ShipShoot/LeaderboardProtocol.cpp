@@ -0,0 +1,52 @@
+#include <algorithm>
+
+#include "LeaderboardProtocol.h"
+#include "LocalSocket.h"
+
+using namespace std;
+
+namespace LeaderboardProtocol
+{
+
+void Writer::PutScore(const Score& s)
+{
+	size_t len = min<size_t>(s.name.size(), MAX_NAME);
+	Put(s.score);
+	Put(static_cast<uint8_t>(len));
+	mBuf.insert(mBuf.end(), s.name.begin(), s.name.begin() + len);
+}
+
+bool Reader::GetScore(Score& s)
+{
+	uint8_t len;
+	if (!Get(s.score) || !Get(len) || static_cast<size_t>(mpEnd - mpAt) < len)
+		return false;
+	s.name.assign(reinterpret_cast<const char*>(mpAt), len);
+	mpAt += len;
+	return true;
+}
+
+bool Send(LocalSocket& sock, MsgType type, const std::vector<uint8_t>& body)
+{
+	//one send for the lot, small messages shouldn't turn into three packets
+	uint32_t len = static_cast<uint32_t>(body.size() + 1);
+	vector<uint8_t> msg(4 + len);
+	memcpy(msg.data(), &len, 4);
+	msg[4] = type;
+	if (!body.empty())
+		memcpy(msg.data() + 5, body.data(), body.size());
+	return sock.SendAll(msg.data(), msg.size());
+}
+
+bool Receive(LocalSocket& sock, MsgType& type, std::vector<uint8_t>& body)
+{
+	uint32_t len;
+	uint8_t t;
+	if (!sock.RecvAll(&len, 4) || len == 0 || len > MAX_MESSAGE || !sock.RecvAll(&t, 1))
+		return false;
+	type = static_cast<MsgType>(t);
+	body.resize(len - 1);
+	return body.empty() || sock.RecvAll(body.data(), body.size());
+}
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+class LocalSocket;
+
+/*
+What the leaderboard server and its clients say to each other. Every
+message is
+	uint32 length of what follows, uint8 type, body
+little endian. Each request gets exactly one reply.
+	SUBMIT	uint16 count, count x score		-> SUBMIT_OK uint32 accepted
+	TOP		uint16 n						-> TOP_OK uint16 count, count x score
+	RANK	int32 score						-> RANK_OK uint64 rank, uint64 total
+where a score is int32 score, uint8 name length, name. Anything the
+server doesn't understand gets FAIL and the connection is closed.
+*/
+namespace LeaderboardProtocol
+{
+
+enum MsgType : uint8_t
+{
+	SUBMIT = 1,
+	TOP = 2,
+	RANK = 3,
+	SUBMIT_OK = 0x81,
+	TOP_OK = 0x82,
+	RANK_OK = 0x83,
+	FAIL = 0xFF
+};
+enum
+{
+	MAX_MESSAGE = 64 * 1024,	//bigger than this and the connection is dropped
+	MAX_BATCH = 1024,			//scores per SUBMIT
+	MAX_NAME = 32
+};
+
+struct Score
+{
+	std::string name;
+	int32_t score = 0;
+};
+
+//builds a message body
+class Writer
+{
+public:
+	void Clear() { mBuf.clear(); }
+	template<typename T> void Put(T v)
+	{
+		//not insert, gcc 12 wrongly warns that it overflows
+		size_t at = mBuf.size();
+		mBuf.resize(at + sizeof(T));
+		memcpy(mBuf.data() + at, &v, sizeof(T));
+	}
+	void PutScore(const Score& s);
+	const std::vector<uint8_t>& GetBytes() const { return mBuf; }
+private:
+	std::vector<uint8_t> mBuf;
+};
+
+//takes one apart, every Get fails once it runs off the end
+class Reader
+{
+public:
+	Reader(const std::vector<uint8_t>& body) : mpAt(body.data()), mpEnd(body.data() + body.size()) {}
+	template<typename T> bool Get(T& v)
+	{
+		if (static_cast<size_t>(mpEnd - mpAt) < sizeof(T))
+			return false;
+		memcpy(&v, mpAt, sizeof(T));
+		mpAt += sizeof(T);
+		return true;
+	}
+	bool GetScore(Score& s);
+	bool AtEnd() const { return mpAt == mpEnd; }
+private:
+	const uint8_t* mpAt;
+	const uint8_t* mpEnd;
+};
+
+bool Send(LocalSocket& sock, MsgType type, const std::vector<uint8_t>& body);
+bool Receive(LocalSocket& sock, MsgType& type, std::vector<uint8_t>& body);
+
+}
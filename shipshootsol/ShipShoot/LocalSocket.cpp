@@ -0,0 +1,204 @@
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <afunix.h>
+typedef int socklen_t;
+#define CLOSE_SOCKET closesocket
+#define SHUT_RDWR SD_BOTH
+#define SEND_FLAGS 0
+#else
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define CLOSE_SOCKET close
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
+#endif
+
+#include "LocalSocket.h"
+
+using namespace std;
+
+static bool Startup()
+{
+#ifdef _WIN32
+	static bool sOk = []() {
+		WSADATA data;
+		return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+	}();
+	return sOk;
+#else
+	return true;
+#endif
+}
+
+static bool MakeAddress(const std::string& path, sockaddr_un& addr)
+{
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (path.empty() || path.size() >= sizeof(addr.sun_path))
+		return false;
+	memcpy(addr.sun_path, path.c_str(), path.size());
+	return true;
+}
+
+//nothing answers at addr, so whatever file is there was left by a server that's gone
+static bool IsStale(const sockaddr_un& addr)
+{
+	uintptr_t sock = static_cast<uintptr_t>(socket(AF_UNIX, SOCK_STREAM, 0));
+	if (sock == ~uintptr_t(0))
+		return false;
+	bool refused = false;
+	if (connect(sock, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0)
+	{
+#ifdef _WIN32
+		refused = WSAGetLastError() == WSAECONNREFUSED;
+#else
+		refused = errno == ECONNREFUSED;
+#endif
+	}
+	CLOSE_SOCKET(sock);
+	return refused;
+}
+
+LocalSocket::~LocalSocket()
+{
+	Close();
+}
+
+LocalSocket::LocalSocket(LocalSocket&& rhs)
+	: mSock(rhs.mSock), mListenPath(move(rhs.mListenPath))
+{
+	rhs.mSock = BAD_SOCKET;
+	rhs.mListenPath.clear();
+}
+
+LocalSocket& LocalSocket::operator=(LocalSocket&& rhs)
+{
+	if (this != &rhs)
+	{
+		Close();
+		mSock = rhs.mSock;
+		mListenPath = move(rhs.mListenPath);
+		rhs.mSock = BAD_SOCKET;
+		rhs.mListenPath.clear();
+	}
+	return *this;
+}
+
+bool LocalSocket::Connect(const std::string& path, int timeoutMs)
+{
+	Close();
+	sockaddr_un addr;
+	if (!Startup() || !MakeAddress(path, addr))
+		return false;
+	mSock = static_cast<uintptr_t>(socket(AF_UNIX, SOCK_STREAM, 0));
+	if (!IsOpen())
+		return false;
+	if (connect(mSock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+	{
+		Close();
+		return false;
+	}
+	SetTimeout(timeoutMs);
+	return true;
+}
+
+bool LocalSocket::Listen(const std::string& path, int backlog)
+{
+	Close();
+	sockaddr_un addr;
+	if (!Startup() || !MakeAddress(path, addr))
+		return false;
+	mSock = static_cast<uintptr_t>(socket(AF_UNIX, SOCK_STREAM, 0));
+	if (!IsOpen())
+		return false;
+	if (::bind(mSock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+	{
+		//never take the path from a server that's still running
+		if (!IsStale(addr) || remove(path.c_str()) != 0 ||
+			::bind(mSock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+		{
+			Close();
+			return false;
+		}
+	}
+	if (listen(mSock, backlog) != 0)
+	{
+		Close();
+		return false;
+	}
+	mListenPath = path;
+	return true;
+}
+
+LocalSocket LocalSocket::Accept()
+{
+	if (!IsOpen())
+		return LocalSocket();
+	return LocalSocket(static_cast<uintptr_t>(accept(mSock, nullptr, nullptr)));
+}
+
+bool LocalSocket::SendAll(const void* pData, size_t numBytes)
+{
+	const char* p = static_cast<const char*>(pData);
+	while (numBytes)
+	{
+		int sent = send(mSock, p, static_cast<int>(numBytes), SEND_FLAGS);
+		if (sent <= 0)
+			return false;
+		p += sent;
+		numBytes -= sent;
+	}
+	return true;
+}
+
+bool LocalSocket::RecvAll(void* pData, size_t numBytes)
+{
+	char* p = static_cast<char*>(pData);
+	while (numBytes)
+	{
+		int got = recv(mSock, p, static_cast<int>(numBytes), 0);
+		if (got <= 0)
+			return false;
+		p += got;
+		numBytes -= got;
+	}
+	return true;
+}
+
+void LocalSocket::SetTimeout(int timeoutMs)
+{
+	if (!IsOpen())
+		return;
+#ifdef _WIN32
+	DWORD tv = timeoutMs;
+#else
+	timeval tv{ timeoutMs / 1000, (timeoutMs % 1000) * 1000 };
+#endif
+	setsockopt(mSock, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&tv), sizeof(tv));
+	setsockopt(mSock, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&tv), sizeof(tv));
+}
+
+void LocalSocket::Shutdown()
+{
+	if (IsOpen())
+		shutdown(mSock, SHUT_RDWR);
+}
+
+void LocalSocket::Close()
+{
+	if (!IsOpen())
+		return;
+	CLOSE_SOCKET(mSock);
+	mSock = BAD_SOCKET;
+	if (!mListenPath.empty())
+		remove(mListenPath.c_str());
+	mListenPath.clear();
+}
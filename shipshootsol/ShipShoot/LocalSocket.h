@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+/*
+A stream socket between processes on the same machine (AF_UNIX, which
+Windows 10 has too). The address is a file path. Blocking, with optional
+timeouts so a dead peer can't hang whoever's waiting.
+*/
+class LocalSocket
+{
+public:
+	LocalSocket() = default;
+	~LocalSocket();
+	LocalSocket(LocalSocket&& rhs);
+	LocalSocket& operator=(LocalSocket&& rhs);
+	LocalSocket(const LocalSocket&) = delete;
+	void operator=(const LocalSocket&) = delete;
+
+	//timeoutMs - 0 = wait forever on sends and receives
+	bool Connect(const std::string& path, int timeoutMs = 0);
+	//fails if something is already listening at path, a stale socket file
+	//left by one that died (connecting is refused) is replaced
+	//finding out connects, so a running server accepts one that hangs up straight away
+	bool Listen(const std::string& path, int backlog = 128);
+	//blocks, the result isn't open if listening stopped
+	LocalSocket Accept();
+	bool SendAll(const void* pData, size_t numBytes);
+	bool RecvAll(void* pData, size_t numBytes);
+	void SetTimeout(int timeoutMs);
+	//wakes up anything blocked on it in another thread, it still needs closing
+	void Shutdown();
+	void Close();
+	bool IsOpen() const { return mSock != BAD_SOCKET; }
+private:
+	static const uintptr_t BAD_SOCKET = ~uintptr_t(0);
+	explicit LocalSocket(uintptr_t sock) : mSock(sock) {}
+	uintptr_t mSock = BAD_SOCKET;
+	std::string mListenPath;		//removed again on close
+};
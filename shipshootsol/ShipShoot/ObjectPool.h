@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+/*
+How a PoolPtr gives its object back. Made by an ObjectPool it goes back
+to that pool, default constructed it's a plain delete, so a PoolPtr can
+hold something made with new as well.
+*/
+template<typename Base>
+struct PoolDeleter
+{
+	void (*pFree)(void* pPool, Base* p) = nullptr;
+	void* pPool = nullptr;
+	void operator()(Base* p) const
+	{
+		if (pFree)
+			pFree(pPool, p);
+		else
+			delete p;
+	}
+};
+
+//owns something from a pool, Base can be a base class of what's in it
+template<typename Base>
+using PoolPtr = std::unique_ptr<Base, PoolDeleter<Base>>;
+
+/*
+Fixed number of T made in one block up front, handing one out and
+taking it back is a free list push or pop, so a game that keeps making
+and losing the same things stops going to the heap once it's warmed up.
+If it runs out the extra come from new and are counted, raise the
+capacity if that happens in a normal game. Objects are constructed and
+destroyed as they're made and given back, only the memory is kept.
+Every PoolPtr has to be gone before the pool is, declare the pool first.
+*/
+template<typename T>
+class ObjectPool
+{
+public:
+	explicit ObjectPool(size_t capacity)
+		: mSlots(capacity)
+	{
+		mFree.reserve(capacity);
+		for (size_t i = capacity; i > 0; --i)
+			mFree.push_back(&mSlots[i - 1]);
+	}
+	~ObjectPool()
+	{
+		assert(mNumLive == 0);
+	}
+	ObjectPool(const ObjectPool&) = delete;
+	void operator=(const ObjectPool&) = delete;
+
+	//e.g. PoolPtr<Enemy> p = bossPool.Make<Enemy>(d3d, tex, pos);
+	template<typename Base = T, typename... Args>
+	PoolPtr<Base> Make(Args&&... args)
+	{
+		T* p;
+		if (mFree.empty())
+		{
+			++mNumOverflows;
+			p = new T(std::forward<Args>(args)...);
+		}
+		else
+		{
+			p = new (mFree.back()) T(std::forward<Args>(args)...);
+			mFree.pop_back();
+		}
+		++mNumLive;
+		PoolDeleter<Base> deleter;
+		deleter.pFree = &ObjectPool::Free<Base>;
+		deleter.pPool = this;
+		return PoolPtr<Base>(p, deleter);
+	}
+
+	size_t GetCapacity() const { return mSlots.size(); }
+	size_t GetNumLive() const { return mNumLive; }
+	//how many weren't in the pool and came from the heap
+	uint64_t GetNumOverflows() const { return mNumOverflows; }
+private:
+	struct Slot
+	{
+		alignas(T) unsigned char bytes[sizeof(T)];
+	};
+	std::vector<Slot> mSlots;
+	std::vector<Slot*> mFree;
+	size_t mNumLive = 0;
+	uint64_t mNumOverflows = 0;
+
+	template<typename Base>
+	static void Free(void* pPool, Base* pBase)
+	{
+		ObjectPool& pool = *static_cast<ObjectPool*>(pPool);
+		T* p = static_cast<T*>(pBase);
+		--pool.mNumLive;
+		Slot* pSlot = reinterpret_cast<Slot*>(p);
+		if (pSlot < pool.mSlots.data() || pSlot >= pool.mSlots.data() + pool.mSlots.size())
+		{
+			delete p;
+			return;
+		}
+		p->~T();
+		pool.mFree.push_back(pSlot);
+	}
+};
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <cwchar>
+
+#include "PerfOverlay.h"
+#include "D3DUtil.h"
+#include "Clock.h"
+#include "AllocTracker.h"
+
+using namespace std;
+using namespace DirectX;
+using namespace DirectX::SimpleMath;
+
+//where it goes and how big, in pixels
+static const long LEFT = 270, TOP = 10, WIDTH = 2 * PerfOverlay::GRAPH_FRAMES + 20;
+static const long LINE_HEIGHT = 18, NUM_LINES = 6;
+static const long GRAPH_TOP = TOP + 10 + NUM_LINES * LINE_HEIGHT, GRAPH_HEIGHT = 80;
+static const long HEIGHT = GRAPH_TOP + GRAPH_HEIGHT + 10 - TOP;
+//the top of the graph, and lines for 120 and 60Hz
+static const float GRAPH_MS = 33.3f;
+static const float GUIDE_MS[]{ 1000 / 120.f, 1000 / 60.f };
+static const float TEXT_SCALE = 0.5f;
+
+PerfOverlay::PerfOverlay(MyD3D& d3d)
+{
+	const uint32_t white = 0xffffffff;
+	D3D11_TEXTURE2D_DESC desc{};
+	desc.Width = desc.Height = 1;
+	desc.MipLevels = desc.ArraySize = 1;
+	desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_IMMUTABLE;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	D3D11_SUBRESOURCE_DATA data{ &white, sizeof(white), 0 };
+	ID3D11Texture2D* pTex = nullptr;
+	HR(d3d.GetDevice().CreateTexture2D(&desc, &data, &pTex));
+	HR(d3d.GetDevice().CreateShaderResourceView(pTex, nullptr, &mpWhite));
+	ReleaseCOM(pTex);
+}
+
+PerfOverlay::~PerfOverlay()
+{
+	Release();
+}
+
+void PerfOverlay::Release()
+{
+	ReleaseCOM(mpWhite);
+}
+
+void PerfOverlay::AddFrame(int64_t frameNs, int64_t simNs, int64_t renderNs, uint64_t numAllocs)
+{
+	Sample& s = mSamples[mNext];
+	s.frameMs = static_cast<float>(Clock::ToMs(frameNs));
+	s.simMs = static_cast<float>(Clock::ToMs(simNs));
+	s.renderMs = static_cast<float>(Clock::ToMs(renderNs));
+	s.numAllocs = static_cast<uint32_t>(min<uint64_t>(numAllocs, UINT32_MAX));
+	mNext = (mNext + 1) % GRAPH_FRAMES;
+}
+
+double PerfOverlay::GetCostMs() const
+{
+	return Clock::ToMs(mCostNs);
+}
+
+void PerfOverlay::DrawRect(SpriteBatch& batch, long x, long y, long w, long h, FXMVECTOR colour)
+{
+	RECT r{ x, y, x + w, y + h };
+	batch.Draw(mpWhite, r, colour);
+}
+
+void PerfOverlay::Render(SpriteBatch& batch, SpriteFont& font, const Counts& counts)
+{
+	if (!mVisible || !mpWhite)
+		return;
+	int64_t start = Clock::NowNs();
+
+	DrawRect(batch, LEFT, TOP, WIDTH, HEIGHT, Vector4(0, 0, 0, 0.6f));
+
+	//oldest on the left, each bar is sim then render then the rest of the frame
+	float avgFrame = 0, maxFrame = 0, avgSim = 0, avgRender = 0;
+	uint32_t maxAllocs = 0;
+	const float pxPerMs = GRAPH_HEIGHT / GRAPH_MS;
+	const long bottom = GRAPH_TOP + GRAPH_HEIGHT;
+	for (unsigned int i = 0; i < GRAPH_FRAMES; ++i)
+	{
+		const Sample& s = mSamples[(mNext + i) % GRAPH_FRAMES];
+		avgFrame += s.frameMs;
+		avgSim += s.simMs;
+		avgRender += s.renderMs;
+		maxFrame = max(maxFrame, s.frameMs);
+		maxAllocs = max(maxAllocs, s.numAllocs);
+		long x = LEFT + 10 + 2 * i;
+		long sim = static_cast<long>(min(s.simMs, GRAPH_MS) * pxPerMs);
+		long render = static_cast<long>(min(s.renderMs, GRAPH_MS) * pxPerMs);
+		long total = max(sim + render, static_cast<long>(min(s.frameMs, GRAPH_MS) * pxPerMs));
+		render = min(render, GRAPH_HEIGHT - sim);
+		total = min(total, GRAPH_HEIGHT);
+		DrawRect(batch, x, bottom - total, 2, total - sim - render, Vector4(0.5f, 0.5f, 0.5f, 0.8f));
+		DrawRect(batch, x, bottom - sim - render, 2, render, Vector4(0.3f, 0.6f, 1, 1));
+		DrawRect(batch, x, bottom - sim, 2, sim, Vector4(0.2f, 1, 0.2f, 1));
+	}
+	for (float ms : GUIDE_MS)
+		DrawRect(batch, LEFT + 10, bottom - static_cast<long>(ms * pxPerMs), 2 * GRAPH_FRAMES, 1, Vector4(1, 1, 0, 0.5f));
+	avgFrame /= GRAPH_FRAMES;
+	avgSim /= GRAPH_FRAMES;
+	avgRender /= GRAPH_FRAMES;
+
+	const Sample& last = mSamples[(mNext + GRAPH_FRAMES - 1) % GRAPH_FRAMES];
+	wchar_t text[NUM_LINES][96];
+	swprintf(text[0], 96, L"frame %.2fms avg %.2f max %.2f (%.0f fps)", last.frameMs, avgFrame, maxFrame,
+		avgFrame > 0 ? 1000 / avgFrame : 0.f);
+	swprintf(text[1], 96, L"sim %.2fms render %.2fms", avgSim, avgRender);
+	swprintf(text[2], 96, L"enemies %u bullets %u/%u shield %u", counts.enemies, counts.playerBullets,
+		counts.enemyBullets, counts.shieldPieces);
+	swprintf(text[3], 96, L"audio sfx %u music %u", counts.sfxChannels, counts.musicChannels);
+	int len = swprintf(text[4], 96, L"allocs/frame %u max %u", last.numAllocs, maxAllocs);
+	//and where the last frame's came from
+	const AllocTracker& allocs = AllocTracker::Get();
+	for (int i = 0; i < AllocTracker::NUM_TAGS && len > 0; ++i)
+	{
+		AllocTag tag = static_cast<AllocTag>(i);
+		if (!allocs.GetFrameAllocs(tag))
+			continue;
+		int n = swprintf(text[4] + len, 96 - len, L" %hs %llu", AllocTracker::GetTagName(tag),
+			static_cast<unsigned long long>(allocs.GetFrameAllocs(tag)));
+		if (n < 0)
+			break;
+		len += n;
+	}
+	swprintf(text[5], 96, L"overlay %.3fms", GetCostMs());
+	for (int i = 0; i < NUM_LINES; ++i)
+	{
+		XMVECTOR colour = Colours::White;
+		if ((i == 4 && last.numAllocs > 0) || (i == 5 && GetCostMs() > BUDGET_MS))
+			colour = Colours::Red;
+		font.DrawString(&batch, text[i], XMFLOAT2(static_cast<float>(LEFT + 10), static_cast<float>(TOP + 5 + i * LINE_HEIGHT)),
+			colour, 0, XMFLOAT2(0, 0), TEXT_SCALE);
+	}
+
+	//what it costs to queue all that, SpriteBatch::End does the rest for everything at once
+	mCostNs = Clock::NowNs() - start;
+}
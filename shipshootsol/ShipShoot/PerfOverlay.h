@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+
+#include "D3D.h"
+#include "SpriteBatch.h"
+#include "SpriteFont.h"
+
+/*
+Performance on screen for whoever is standing in front of the machine,
+no tools needed. A scrolling graph of the last GRAPH_FRAMES frames, each
+bar split into simulation, rendering and whatever else (waiting for the
+next frame mostly), with the numbers underneath: frame, sim and render
+times, what's alive in the game, audio channels playing and heap
+allocations per frame split by AllocTag. It draws with the game's own
+SpriteBatch and font and doesn't allocate, text is formatted into
+fixed buffers. What it costs to draw is timed and shown in red if it's
+over BUDGET_MS.
+*/
+class PerfOverlay
+{
+public:
+	enum { GRAPH_FRAMES = 200 };
+	const double BUDGET_MS = 0.25;
+	//what's in the game right now, filled in by whoever owns it
+	struct Counts
+	{
+		unsigned int enemies = 0, playerBullets = 0, enemyBullets = 0, shieldPieces = 0;
+		unsigned int sfxChannels = 0, musicChannels = 0;
+	};
+
+	PerfOverlay(MyD3D& d3d);
+	~PerfOverlay();
+	void Release();
+	void Toggle() { mVisible = !mVisible; }
+	bool IsVisible() const { return mVisible; }
+	//every frame, showing or not, so the graph is already full when it's turned on
+	void AddFrame(int64_t frameNs, int64_t simNs, int64_t renderNs, uint64_t numAllocs);
+	//call between Begin and End on the batch
+	void Render(DirectX::SpriteBatch& batch, DirectX::SpriteFont& font, const Counts& counts);
+	//how long the last Render took
+	double GetCostMs() const;
+private:
+	struct Sample
+	{
+		float frameMs, simMs, renderMs;
+		uint32_t numAllocs;
+	};
+	Sample mSamples[GRAPH_FRAMES] = {};
+	unsigned int mNext = 0;		//oldest sample, where the next one goes
+	ID3D11ShaderResourceView* mpWhite = nullptr;	//1x1 white texel, stretched and tinted for the graph
+	int64_t mCostNs = 0;
+	bool mVisible = false;
+
+	//a solid rectangle in screen pixels
+	void DrawRect(DirectX::SpriteBatch& batch, long x, long y, long w, long h, DirectX::FXMVECTOR colour);
+};
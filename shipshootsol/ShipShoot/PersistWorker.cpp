@@ -0,0 +1,135 @@
+#include <cassert>
+#include <filesystem>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "PersistWorker.h"
+#include "Profiler.h"
+#include "AllocTracker.h"
+
+using namespace std;
+
+PersistWorker::PersistWorker(size_t maxQueued)
+	: mMaxQueued(maxQueued)
+{
+	assert(maxQueued > 0);
+	mThread = thread(&PersistWorker::Run, this);
+}
+
+PersistWorker::~PersistWorker()
+{
+	Stop();
+}
+
+void PersistWorker::Submit(const std::string& key, std::function<bool()> job)
+{
+	unique_lock<mutex> lock(mLock);
+	if (mStop)
+	{
+		//nobody left to hand it to
+		lock.unlock();
+		++mNumRun;
+		if (!job())
+			++mNumFailed;
+		return;
+	}
+	if (!key.empty())
+	{
+		for (auto& j : mQueue)
+		{
+			if (j.key == key)
+			{
+				//keeps its place in the queue but does the newer thing
+				j.fn = move(job);
+				++mNumCoalesced;
+				return;
+			}
+		}
+	}
+	mDone.wait(lock, [this]() { return mQueue.size() < mMaxQueued; });
+	mQueue.push_back(Job{ key, move(job) });
+	mWake.notify_one();
+}
+
+void PersistWorker::WriteFile(const std::string& fileName, std::vector<uint8_t> bytes)
+{
+	Submit(fileName, [fileName, bytes = move(bytes)]() {
+		return WriteFileAtomic(fileName, bytes.data(), bytes.size());
+	});
+}
+
+void PersistWorker::Flush()
+{
+	unique_lock<mutex> lock(mLock);
+	mDone.wait(lock, [this]() { return mQueue.empty() && !mBusy; });
+}
+
+void PersistWorker::Stop()
+{
+	{
+		lock_guard<mutex> lock(mLock);
+		if (mStop)
+			return;
+		mStop = true;
+	}
+	mWake.notify_one();
+	mThread.join();
+}
+
+void PersistWorker::Run()
+{
+	PROFILE_THREAD("persist");
+	AllocTracker::GetTag() = AllocTag::IO;
+	unique_lock<mutex> lock(mLock);
+	while (true)
+	{
+		mWake.wait(lock, [this]() { return !mQueue.empty() || mStop; });
+		//only stop once it's all written
+		if (mQueue.empty())
+			break;
+		Job job = move(mQueue.front());
+		mQueue.pop_front();
+		mBusy = true;
+		mDone.notify_all();
+		lock.unlock();
+		bool ok;
+		{
+			PROFILE_ZONE("PersistWorker::Job");
+			ok = job.fn();
+		}
+		lock.lock();
+		mBusy = false;
+		++mNumRun;
+		if (!ok)
+			++mNumFailed;
+		mDone.notify_all();
+	}
+}
+
+bool PersistWorker::WriteFileAtomic(const std::string& fileName, const void* pData, size_t numBytes)
+{
+	string tmpName = fileName + ".tmp";
+	FILE* pFile = fopen(tmpName.c_str(), "wb");
+	if (!pFile)
+		return false;
+	bool ok = fwrite(pData, 1, numBytes, pFile) == numBytes && FlushToDisk(pFile);
+	fclose(pFile);
+	error_code ec;
+	if (ok)
+		filesystem::rename(tmpName, fileName, ec);
+	return ok && !ec;
+}
+
+bool PersistWorker::FlushToDisk(FILE* pFile)
+{
+	if (fflush(pFile) != 0)
+		return false;
+#ifdef _WIN32
+	return _commit(_fileno(pFile)) == 0;
+#else
+	return fsync(fileno(pFile)) == 0;
+#endif
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+
+/*
+Does the slow disk work (high scores, settings, saves) on its own thread
+so the game never waits for a disk. Jobs run in the order they were
+queued. A job with a key replaces one with the same key that is still
+waiting, so saving the same file twice in a row only writes it once.
+The queue is bounded, if it fills up whoever is adding waits for space.
+Everything queued is finished before it's destroyed.
+*/
+class PersistWorker
+{
+public:
+	PersistWorker(size_t maxQueued = 64);
+	~PersistWorker();
+	PersistWorker(const PersistWorker&) = delete;
+	void operator=(const PersistWorker&) = delete;
+
+	//key - empty never coalesces, anything else replaces a waiting job with the same key
+	//job - returns false if it failed, it runs on the worker thread
+	void Submit(const std::string& key, std::function<bool()> job);
+	//write a whole file safely, coalesces by file name
+	void WriteFile(const std::string& fileName, std::vector<uint8_t> bytes);
+	//wait for everything queued so far to finish
+	void Flush();
+	//finish everything and stop the thread, jobs submitted afterwards run straight away
+	void Stop();
+
+	uint64_t GetNumRun() const { return mNumRun; }
+	uint64_t GetNumCoalesced() const { return mNumCoalesced; }
+	uint64_t GetNumFailed() const { return mNumFailed; }
+
+	//write to fileName.tmp, flush it to disk, rename it over fileName
+	//the old file is intact until the rename so a crash leaves one or the other
+	static bool WriteFileAtomic(const std::string& fileName, const void* pData, size_t numBytes);
+	//past the OS and onto the disk, or as close as we can get
+	static bool FlushToDisk(FILE* pFile);
+private:
+	struct Job
+	{
+		std::string key;
+		std::function<bool()> fn;
+	};
+	void Run();
+
+	size_t mMaxQueued;
+	std::deque<Job> mQueue;
+	std::mutex mLock;
+	std::condition_variable mWake;		//the worker waits on this for work
+	std::condition_variable mDone;		//everyone else waits on this for space or idle
+	bool mBusy = false;
+	bool mStop = false;
+	std::thread mThread;
+	std::atomic<uint64_t> mNumRun{ 0 }, mNumCoalesced{ 0 }, mNumFailed{ 0 };
+};
@@ -0,0 +1,139 @@
+#include <cstdio>
+#include <algorithm>
+
+#include "Profiler.h"
+
+using namespace std;
+
+Profiler::Block* Profiler::ThreadBuffer::NextBlock()
+{
+	lock_guard<mutex> guard(lock);
+	if (blocks.size() < MAX_BLOCKS)
+		blocks.push_back(make_unique<Block>());
+	else
+	{
+		//oldest to the back, what was in it is lost
+		rotate(blocks.begin(), blocks.begin() + 1, blocks.end());
+		blocks.back()->count.store(0, memory_order_relaxed);
+	}
+	pCurrent = blocks.back().get();
+	return pCurrent;
+}
+
+Profiler::ThreadBuffer& Profiler::AddThread()
+{
+	lock_guard<mutex> guard(mLock);
+	mThreads.push_back(make_unique<ThreadBuffer>());
+	ThreadBuffer& buf = *mThreads.back();
+	buf.tid = static_cast<uint32_t>(mThreads.size());
+	buf.name = "thread " + to_string(buf.tid);
+	buf.blocks.push_back(make_unique<Block>());
+	buf.pCurrent = buf.blocks.back().get();
+	return buf;
+}
+
+void Profiler::SetThreadName(const std::string& name)
+{
+	ThreadBuffer& buf = GetThreadBuffer();
+	lock_guard<mutex> guard(buf.lock);
+	buf.name = name;
+}
+
+uint64_t Profiler::GetNumEvents() const
+{
+	uint64_t num = 0;
+	lock_guard<mutex> guard(mLock);
+	for (auto& pBuf : mThreads)
+	{
+		lock_guard<mutex> bufGuard(pBuf->lock);
+		for (auto& pBlock : pBuf->blocks)
+			num += pBlock->count.load(memory_order_acquire);
+	}
+	return num;
+}
+
+//names are literals from our own code, but keep the json valid whatever they are
+static void WriteJsonString(FILE* pFile, const char* pStr)
+{
+	fputc('"', pFile);
+	for (; *pStr; ++pStr)
+	{
+		if (*pStr == '"' || *pStr == '\\')
+			fputc('\\', pFile);
+		if (static_cast<unsigned char>(*pStr) >= ' ')
+			fputc(*pStr, pFile);
+	}
+	fputc('"', pFile);
+}
+
+bool Profiler::WriteChromeTrace(const std::string& fileName) const
+{
+	FILE* pFile = fopen(fileName.c_str(), "w");
+	if (!pFile)
+		return false;
+	int64_t clearedNs = mClearedNs;
+	const char* pSep = "";
+	fprintf(pFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	lock_guard<mutex> guard(mLock);
+	for (auto& pBuf : mThreads)
+	{
+		//recording carries on while we write, only a thread filling a block waits for us
+		lock_guard<mutex> bufGuard(pBuf->lock);
+		fprintf(pFile, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", pSep, pBuf->tid);
+		WriteJsonString(pFile, pBuf->name.c_str());
+		fprintf(pFile, "}}");
+		pSep = ",\n";
+		for (auto& pBlock : pBuf->blocks)
+		{
+			uint32_t count = pBlock->count.load(memory_order_acquire);
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				const Event& e = pBlock->events[i];
+				if (e.startNs < clearedNs)
+					continue;
+				fprintf(pFile, "%s{\"name\":", pSep);
+				WriteJsonString(pFile, e.pName);
+				if (e.isCounter)
+				{
+					//one series per counter, named after it
+					fprintf(pFile, ",\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{", pBuf->tid,
+						(e.startNs - mStartNs) / static_cast<double>(Clock::NS_PER_US));
+					WriteJsonString(pFile, e.pName);
+					fprintf(pFile, ":%lld}}", static_cast<long long>(e.endNs));
+					continue;
+				}
+				//complete events, times in microseconds
+				fprintf(pFile, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", pBuf->tid,
+					(e.startNs - mStartNs) / static_cast<double>(Clock::NS_PER_US),
+					(e.endNs - e.startNs) / static_cast<double>(Clock::NS_PER_US));
+			}
+		}
+	}
+	fprintf(pFile, "\n]}\n");
+	bool ok = !ferror(pFile);
+	return fclose(pFile) == 0 && ok;
+}
+
+Profiler::BenchResult Profiler::Benchmark(uint64_t numZones)
+{
+	BenchResult res{ numZones, 0, 0 };
+	if (numZones == 0)
+		return res;
+	//the same loop with and without a zone in it
+	volatile uint64_t sink = 0;
+	int64_t start = Clock::NowNs();
+	for (uint64_t i = 0; i < numZones; ++i)
+		sink = sink + i;
+	int64_t emptyNs = Clock::NowNs() - start;
+
+	start = Clock::NowNs();
+	for (uint64_t i = 0; i < numZones; ++i)
+	{
+		ProfileZone zone("bench");
+		sink = sink + i;
+	}
+	int64_t zoneNs = Clock::NowNs() - start;
+	res.nsPerEmptyLoop = emptyNs / static_cast<double>(numZones);
+	res.nsPerZone = (zoneNs - emptyNs) / static_cast<double>(numZones);
+	return res;
+}
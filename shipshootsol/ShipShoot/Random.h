@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+xoshiro256** (Blackman and Vigna), small and fast and the same numbers
+on every platform, which the std engines and distributions don't
+promise. Each game owns one so a session repeats from its seed and
+games side by side don't share. The whole state is four words,
+GetState and SetState save and restore it, it's what a replay starts
+from.
+*/
+class Random
+{
+public:
+	//what a game starts from unless it's told otherwise
+	static const uint64_t DEFAULT_SEED = 0x5eed;
+	struct State { uint64_t s[4]; };
+
+	explicit Random(uint64_t seed = DEFAULT_SEED) { Seed(seed); }
+	//splitmix64 spreads the seed over the state, so any seed is fine, 0 included
+	void Seed(uint64_t seed)
+	{
+		for (uint64_t& word : mState.s)
+		{
+			seed += 0x9e3779b97f4a7c15ull;
+			uint64_t z = seed;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+			word = z ^ (z >> 31);
+		}
+	}
+	uint64_t Next()
+	{
+		uint64_t* s = mState.s;
+		const uint64_t result = Rotl(s[1] * 5, 7) * 9;
+		const uint64_t t = s[1] << 17;
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = Rotl(s[3], 45);
+		return result;
+	}
+	//0 to bound - 1 with no bias and usually no divide (Lemire's method), bound > 0
+	uint32_t Below(uint32_t bound)
+	{
+		uint64_t m = (Next() >> 32) * bound;
+		uint32_t low = static_cast<uint32_t>(m);
+		if (low < bound)
+		{
+			const uint32_t threshold = (0u - bound) % bound;
+			while (low < threshold)
+			{
+				m = (Next() >> 32) * bound;
+				low = static_cast<uint32_t>(m);
+			}
+		}
+		return static_cast<uint32_t>(m >> 32);
+	}
+	//lo to hi, both included
+	int Range(int lo, int hi) { return lo + static_cast<int>(Below(static_cast<uint32_t>(hi - lo) + 1)); }
+	//[0, 1) in steps of 2^-24 so every value is exact
+	float Float01() { return (Next() >> 40) * (1.f / 16777216.f); }
+	//as if Next had been called 2^128 times, seed once and Jump k times
+	//for the kth of several streams that mustn't overlap
+	void Jump()
+	{
+		static const uint64_t JUMP[] = { 0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull, 0xa9582618e03fc9aaull, 0x39abdc4529b1661cull };
+		State jumped = {};
+		for (uint64_t bits : JUMP)
+			for (int b = 0; b < 64; ++b)
+			{
+				if (bits & (1ull << b))
+					for (int i = 0; i < 4; ++i)
+						jumped.s[i] ^= mState.s[i];
+				Next();
+			}
+		mState = jumped;
+	}
+	const State& GetState() const { return mState; }
+	void SetState(const State& state) { mState = state; }
+private:
+	State mState;
+
+	static uint64_t Rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+};
@@ -0,0 +1,50 @@
+#include "RenderProxy.h"
+
+using namespace DirectX;
+using namespace DirectX::SimpleMath;
+
+void RenderProxy::SetTex(const TexCache& cache, ID3D11ShaderResourceView& texture)
+{
+	const TexCache::Data& data = cache.Get(&texture);
+	tex = data.handle;
+	size = data.dim;
+	frame = NO_FRAME;
+}
+
+void RenderProxy::Draw(SpriteBatch& batch, const TexCache& cache) const
+{
+	const TexCache::Data& data = cache.Get(tex);
+	RECTF r = frame == NO_FRAME ? RECTF{ 0, 0, data.dim.x, data.dim.y } : data.frames[frame];
+	const Vector2& ts = data.texScale;
+	if (ts.x == 1 && ts.y == 1)
+	{
+		RECT rect = r;
+		batch.Draw(data.pTex, mPos, &rect, Colours::White, rotation, origin, scale);
+		return;
+	}
+	//cooked down texture, see Sprite::Draw
+	RECT rect = RECTF{ r.left * ts.x, r.top * ts.y, r.right * ts.x, r.bottom * ts.y };
+	batch.Draw(data.pTex, mPos, &rect, Colours::White, rotation, origin * ts, scale / ts);
+}
+
+void FrameAnim::Init(RenderProxy& proxy, uint16_t _start, uint16_t _stop, float _rate, bool _loop)
+{
+	start = _start;
+	stop = _stop;
+	rate = _rate;
+	loop = _loop;
+	elapsedSec = 0;
+	proxy.frame = start;
+}
+
+void FrameAnim::Update(RenderProxy& proxy, float dTime)
+{
+	elapsedSec += dTime;
+	if (elapsedSec <= 1.f / rate)
+		return;
+	elapsedSec = 0;
+	if (proxy.frame < stop)
+		++proxy.frame;
+	else if (loop)
+		proxy.frame = start;
+}
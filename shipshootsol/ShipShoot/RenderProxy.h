@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "RenderTypes.h"
+#include "SpriteBatch.h"
+#include "TexCache.h"
+
+/*
+Flicks a RenderProxy through some of its texture's frames, the same as
+Animate does for a Sprite but without holding on to it.
+*/
+struct FrameAnim
+{
+	uint16_t start = 0, stop = 0;	//first and last frame
+	float rate = 0;				//frames a second
+	float elapsedSec = 0;		//how long the current frame has been on screen
+	bool loop = false;
+
+	void Init(RenderProxy& proxy, uint16_t _start, uint16_t _stop, float _rate, bool _loop);
+	void Update(RenderProxy& proxy, float dTime);
+};
+static_assert(std::is_trivially_copyable<FrameAnim>::value, "FrameAnim must stay a plain value");
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+/*
+The plain data gameplay code needs to know where things are, with no D3D
+behind it: Vector2, RECTF, a texture handle and the RenderProxy itself.
+The game and the portable build (see CMakeLists.txt, which defines
+SHIPSHOOT_PORTABLE) both use this one, so Formation and ShooterIndex
+are built from the same types everywhere. Only Vector2 differs: the game
+has DirectXTK's, the portable build has just the arithmetic the
+gameplay code uses and nothing else, so anything more is a compile
+error there rather than a quiet difference.
+*/
+#ifdef SHIPSHOOT_PORTABLE
+namespace DirectX
+{
+	namespace SimpleMath
+	{
+		struct Vector2
+		{
+			float x, y;
+
+			Vector2() : x(0), y(0) {}
+			Vector2(float _x, float _y) : x(_x), y(_y) {}
+			Vector2 operator+(const Vector2& rhs) const { return Vector2(x + rhs.x, y + rhs.y); }
+			Vector2 operator-(const Vector2& rhs) const { return Vector2(x - rhs.x, y - rhs.y); }
+			Vector2 operator*(const Vector2& rhs) const { return Vector2(x * rhs.x, y * rhs.y); }
+			Vector2 operator*(float s) const { return Vector2(x * s, y * s); }
+			Vector2& operator+=(const Vector2& rhs) { x += rhs.x; y += rhs.y; return *this; }
+			Vector2& operator-=(const Vector2& rhs) { x -= rhs.x; y -= rhs.y; return *this; }
+			bool operator==(const Vector2& rhs) const { return x == rhs.x && y == rhs.y; }
+			bool operator!=(const Vector2& rhs) const { return !(*this == rhs); }
+		};
+	}
+}
+#else
+#include <windows.h>
+#include "SimpleMath.h"
+#endif
+static_assert(sizeof(DirectX::SimpleMath::Vector2) == 2 * sizeof(float), "Vector2 must be two floats");
+
+namespace DirectX
+{
+	class SpriteBatch;
+}
+struct ID3D11ShaderResourceView;
+class TexCache;
+
+//handy rectangle definer
+struct RECTF
+{
+	float left, top, right, bottom;
+#ifndef SHIPSHOOT_PORTABLE
+	operator RECT() {
+		return RECT{ (int)left,(int)top,(int)right,(int)bottom };
+	}
+#endif
+};
+
+//small number standing for a loaded texture, what RenderProxy keeps instead of pointers
+typedef uint16_t TexHandle;
+static const TexHandle NO_TEX_HANDLE = 0xffff;
+
+/*
+All a gameplay object needs to be drawn: which texture (a TexCache handle,
+not a pointer), which of its frames and where. Nothing refers back to
+anything so it's a plain value, copying one is a memcpy and a vector of
+them can be moved about freely. The texture's size is kept alongside so
+collisions don't need the cache. Sprite is still there for the screens
+and the scrolling background, it can colour, layer and scroll but costs
+three times as much to copy around.
+SetTex and Draw are in RenderProxy.cpp, the portable build has ones that
+do nothing (Portable/NullRender.cpp).
+*/
+struct RenderProxy
+{
+	static const uint16_t NO_FRAME = 0xffff;
+
+	DirectX::SimpleMath::Vector2 mPos = DirectX::SimpleMath::Vector2(0, 0);
+	DirectX::SimpleMath::Vector2 scale = DirectX::SimpleMath::Vector2(1, 1);
+	DirectX::SimpleMath::Vector2 origin = DirectX::SimpleMath::Vector2(0, 0);
+	DirectX::SimpleMath::Vector2 size = DirectX::SimpleMath::Vector2(0, 0);	//of the texture, before scaling
+	float rotation = 0;
+	TexHandle tex = NO_TEX_HANDLE;
+	uint16_t frame = NO_FRAME;		//index into the texture's frames, NO_FRAME for all of it
+
+	//texture loaded with cache.LoadTexture
+	void SetTex(const TexCache& cache, ID3D11ShaderResourceView& texture);
+	void Draw(DirectX::SpriteBatch& batch, const TexCache& cache) const;
+	DirectX::SimpleMath::Vector2 GetScreenSize() const { return scale * size; }
+};
+static_assert(std::is_trivially_copyable<RenderProxy>::value, "RenderProxy must stay a plain value");
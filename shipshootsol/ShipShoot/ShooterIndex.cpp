@@ -0,0 +1,62 @@
+
+#include "ShooterIndex.h"
+
+void ShooterIndex::Reset(const Formation& formation, int maxOthers)
+{
+	mShooters.clear();
+	mNumCols = formation.GetNumCols();
+	mShooters.reserve(mNumCols + maxOthers);
+	mColShooter.assign(mNumCols, -1);
+	for (int col = 0; col < mNumCols; ++col)
+	{
+		int slot = formation.GetFront(col);
+		if (slot < 0)
+			continue;
+		mColShooter[col] = GetNumShooters();
+		mShooters.push_back(Shooter{ slot, nullptr });
+	}
+}
+
+void ShooterIndex::OnKilled(const Formation& formation, int slot)
+{
+	int col = slot % mNumCols;
+	int i = mColShooter[col];
+	//one further back doesn't change who's at the front
+	if (i < 0 || mShooters[i].slot != slot)
+		return;
+	int front = formation.GetFront(col);
+	if (front >= 0)
+		mShooters[i].slot = front;
+	else
+		RemoveAt(i);
+}
+
+void ShooterIndex::Add(Enemy& enemy)
+{
+	mShooters.push_back(Shooter{ -1, &enemy });
+}
+
+bool ShooterIndex::Remove(Enemy& enemy)
+{
+	for (int i = 0; i < GetNumShooters(); ++i)
+		if (mShooters[i].pEnemy == &enemy)
+		{
+			RemoveAt(i);
+			return true;
+		}
+	return false;
+}
+
+void ShooterIndex::RemoveAt(int i)
+{
+	if (!mShooters[i].pEnemy)
+		mColShooter[mShooters[i].slot % mNumCols] = -1;
+	int last = GetNumShooters() - 1;
+	if (i != last)
+	{
+		mShooters[i] = mShooters[last];
+		if (!mShooters[i].pEnemy)
+			mColShooter[mShooters[i].slot % mNumCols] = i;
+	}
+	mShooters.pop_back();
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+
+#include "Formation.h"
+#include "Random.h"
+
+class Enemy;
+
+/*
+Every enemy that's allowed to shoot, the front one left in each
+formation column (nothing behind it can get a shot past) and anything
+moving by itself. It's kept up to date as enemies die or turn up
+rather than worked out when someone fires, so picking one is an index
+into a vector however big the formation is. The order isn't kept,
+removing one moves the last one into its place.
+*/
+class ShooterIndex
+{
+public:
+	//a formation slot, or pEnemy if it's not in the formation
+	struct Shooter
+	{
+		int slot;
+		Enemy* pEnemy;
+	};
+
+	//forget everyone and take the fronts of a new formation, with room
+	//for maxOthers to be added on top without going to the heap
+	void Reset(const Formation& formation, int maxOthers);
+	//after formation.Kill(slot), the one behind takes over the column
+	void OnKilled(const Formation& formation, int slot);
+	//not owned, Remove it before it's deleted
+	void Add(Enemy& enemy);
+	//false and nothing changes if it was never added or has gone already
+	bool Remove(Enemy& enemy);
+
+	int GetNumShooters() const { return static_cast<int>(mShooters.size()); }
+	const Shooter& Get(int i) const { return mShooters[i]; }
+private:
+	std::vector<Shooter> mShooters;
+	std::vector<int> mColShooter;	//where each column's front is in mShooters, -1 if it's empty
+	int mNumCols = 0;
+
+	void RemoveAt(int i);
+};
+
+/*
+Who fires next and how long until the one after, PlayMode asks when
+its timer runs out. Patterns only see the ShooterIndex, never the
+enemies themselves, so a new one is a few numbers or a small class and
+doesn't add a pass over the enemy list.
+*/
+class IFirePattern
+{
+public:
+	virtual ~IFirePattern() {}
+	//index into shooters, which isn't empty
+	virtual int Pick(const ShooterIndex& shooters, Random& random) = 0;
+	//seconds, numEnemies counts the ones that can't shoot too
+	virtual float GetInterval(const ShooterIndex& shooters, int numEnemies) = 0;
+};
+
+//any shooter at random, a shot every secsPerEnemy / numEnemies, the more there are the more they fire
+class RandomFirePattern : public IFirePattern
+{
+public:
+	explicit RandomFirePattern(float secsPerEnemy = 60) : mSecsPerEnemy(secsPerEnemy) {}
+	int Pick(const ShooterIndex& shooters, Random& random) override
+	{
+		return static_cast<int>(random.Below(shooters.GetNumShooters()));
+	}
+	float GetInterval(const ShooterIndex&, int numEnemies) override
+	{
+		return mSecsPerEnemy / (numEnemies > 0 ? numEnemies : 1);
+	}
+private:
+	float mSecsPerEnemy;
+};
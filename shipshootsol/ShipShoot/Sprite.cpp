@@ -68,7 +68,15 @@ Sprite& Sprite::operator=(const Sprite& rhs) {
 }
 void Sprite::Draw(SpriteBatch& batch)
 {
-	batch.Draw(mpTex, mPos, &(RECT)mTexRect, colour, rotation, origin, scale, DirectX::SpriteEffects::SpriteEffects_None, depth);
+	const Vector2& ts = mpTexData->texScale;
+	if (ts.x == 1 && ts.y == 1)
+	{
+		batch.Draw(mpTex, mPos, &(RECT)mTexRect, colour, rotation, origin, scale, DirectX::SpriteEffects::SpriteEffects_None, depth);
+		return;
+	}
+	//cooked down texture, everything is in original pixels so convert to real ones
+	RECTF r{ mTexRect.left * ts.x, mTexRect.top * ts.y, mTexRect.right * ts.x, mTexRect.bottom * ts.y };
+	batch.Draw(mpTex, mPos, &(RECT)r, colour, rotation, origin * ts, scale / ts, DirectX::SpriteEffects::SpriteEffects_None, depth);
 }
 void Sprite::SetTex(ID3D11ShaderResourceView& tex, const RECTF& texRect)
 {
@@ -93,7 +101,6 @@ void Sprite::Scroll(float x, float y) {
 
 void Sprite::SetFrame(int id) 
 {
-	const TexCache::Data& data = mD3D.GetCache().Get(mpTex);
-	SetTexRect(data.frames.at(id));
+	SetTexRect(mpTexData->frames.at(id));
 }
 
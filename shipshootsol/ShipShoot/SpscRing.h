@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+/*
+Fixed size queue for exactly one thread pushing and one thread popping,
+no locks. Each side only writes its own index and reads the other's, so
+the producer can be a message pump or a polling thread while the game
+drains it. Capacity is rounded up to a power of two, when it's full
+Push fails and the caller decides what to drop.
+*/
+template<typename T>
+class SpscRing
+{
+public:
+	SpscRing(size_t capacity)
+	{
+		size_t size = 2;
+		while (size < capacity)
+			size *= 2;
+		mItems.resize(size);
+		mMask = size - 1;
+	}
+	//producer side
+	bool Push(const T& item)
+	{
+		size_t head = mHead.load(std::memory_order_relaxed);
+		if (head - mTail.load(std::memory_order_acquire) > mMask)
+			return false;
+		mItems[head & mMask] = item;
+		mHead.store(head + 1, std::memory_order_release);
+		return true;
+	}
+	//consumer side, look at the oldest without taking it
+	const T* Peek() const
+	{
+		size_t tail = mTail.load(std::memory_order_relaxed);
+		if (tail == mHead.load(std::memory_order_acquire))
+			return nullptr;
+		return &mItems[tail & mMask];
+	}
+	//consumer side, drop the one Peek returned
+	void Pop()
+	{
+		size_t tail = mTail.load(std::memory_order_relaxed);
+		assert(tail != mHead.load(std::memory_order_relaxed));
+		mTail.store(tail + 1, std::memory_order_release);
+	}
+	bool Pop(T& item)
+	{
+		const T* p = Peek();
+		if (!p)
+			return false;
+		item = *p;
+		Pop();
+		return true;
+	}
+	//only a snapshot when the other side is busy
+	size_t GetSize() const { return mHead.load(std::memory_order_acquire) - mTail.load(std::memory_order_acquire); }
+	size_t GetCapacity() const { return mItems.size(); }
+private:
+	std::vector<T> mItems;
+	size_t mMask;
+	//on separate cache lines so the two threads don't fight over them
+	alignas(64) std::atomic<size_t> mHead{ 0 };
+	alignas(64) std::atomic<size_t> mTail{ 0 };
+};
@@ -0,0 +1,128 @@
+#include <cassert>
+#include <cmath>
+#include <fstream>
+
+#include "Stats.h"
+
+using namespace std;
+
+Histogram::Histogram(double minVal, double maxVal, int bucketsPerDecade)
+	: mMinVal(minVal), mMaxVal(maxVal), mPerDecade(bucketsPerDecade)
+{
+	assert(minVal > 0 && maxVal > minVal && bucketsPerDecade > 0);
+	mLogMin = log10(minVal);
+	int numDecades = static_cast<int>(ceil(log10(maxVal) - mLogMin));
+	mBuckets.resize(numDecades * bucketsPerDecade + 2, 0);
+}
+
+void Histogram::Add(double value)
+{
+	size_t idx;
+	if (value < mMinVal)
+		idx = 0;
+	else if (value >= mMaxVal)
+		idx = mBuckets.size() - 1;
+	else
+	{
+		idx = static_cast<size_t>((log10(value) - mLogMin) * mPerDecade) + 1;
+		if (idx > mBuckets.size() - 2)
+			idx = mBuckets.size() - 2;
+	}
+	++mBuckets[idx];
+
+	if (mCount == 0 || value < mMin)
+		mMin = value;
+	if (mCount == 0 || value > mMax)
+		mMax = value;
+	mSum += value;
+	++mCount;
+}
+
+void Histogram::Reset()
+{
+	for (auto& b : mBuckets)
+		b = 0;
+	mCount = 0;
+	mSum = mMin = mMax = 0;
+}
+
+double Histogram::GetBucketLower(size_t idx) const
+{
+	if (idx == 0)
+		return 0;
+	return pow(10.0, mLogMin + (idx - 1) / (double)mPerDecade);
+}
+
+double Histogram::GetBucketUpper(size_t idx) const
+{
+	if (idx >= mBuckets.size() - 1)
+		return mMax;
+	return pow(10.0, mLogMin + idx / (double)mPerDecade);
+}
+
+double Histogram::GetPercentile(double percent) const
+{
+	if (mCount == 0)
+		return 0;
+	uint64_t target = static_cast<uint64_t>(ceil(mCount * percent / 100.0));
+	if (target == 0)
+		target = 1;
+	uint64_t seen = 0;
+	for (size_t i = 0; i < mBuckets.size(); ++i)
+	{
+		seen += mBuckets[i];
+		if (seen < target)
+			continue;
+		//middle of the bucket, but never outside what we actually saw
+		double v = sqrt(GetBucketLower(i) * GetBucketUpper(i));
+		if (i == 0 || v < mMin)
+			v = mMin;
+		if (i == mBuckets.size() - 1 || v > mMax)
+			v = mMax;
+		return v;
+	}
+	return mMax;
+}
+
+
+Histogram& Stats::GetHistogram(const std::string& name)
+{
+	return mHistograms[name];
+}
+
+const Histogram* Stats::FindHistogram(const std::string& name) const
+{
+	auto it = mHistograms.find(name);
+	if (it == mHistograms.end())
+		return nullptr;
+	return &it->second;
+}
+
+void Stats::GetNames(std::vector<std::string>& names) const
+{
+	names.clear();
+	for (auto& h : mHistograms)
+		names.push_back(h.first);
+}
+
+void Stats::ResetAll()
+{
+	for (auto& h : mHistograms)
+		h.second.Reset();
+}
+
+bool Stats::Write(const std::string& fileName) const
+{
+	ofstream out(fileName);
+	if (!out)
+		return false;
+	out << "name count min mean p50 p95 p99 max\n";
+	for (auto& h : mHistograms)
+	{
+		const Histogram& hist = h.second;
+		out << h.first << " " << hist.GetCount() << " " << hist.GetMin() << " " << hist.GetMean() << " "
+			<< hist.GetPercentile(50) << " " << hist.GetPercentile(95) << " " << hist.GetPercentile(99) << " "
+			<< hist.GetMax() << "\n";
+	}
+	return out.good();
+}
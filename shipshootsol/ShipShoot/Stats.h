@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+
+/*
+Collects a spread of values (frame times, latencies, ...) without keeping
+every one. Values land in buckets that get wider as the values get bigger
+so the same histogram works for 0.01ms and 1000ms with the same accuracy
+in percent. Adding a value never allocates.
+*/
+class Histogram
+{
+public:
+	//minVal/maxVal - anything outside goes in an under/overflow bucket
+	//bucketsPerDecade - resolution, 20 means each bucket is ~12% wide
+	Histogram(double minVal = 0.01, double maxVal = 100000, int bucketsPerDecade = 20);
+	void Add(double value);
+	void Reset();
+	uint64_t GetCount() const { return mCount; }
+	double GetMin() const { return mCount ? mMin : 0; }
+	double GetMax() const { return mCount ? mMax : 0; }
+	double GetMean() const { return mCount ? mSum / mCount : 0; }
+	//e.g. 50, 95, 99 - accurate to the width of a bucket
+	double GetPercentile(double percent) const;
+	//raw access for anything that wants to draw it
+	const std::vector<uint64_t>& GetBuckets() const { return mBuckets; }
+	double GetBucketLower(size_t idx) const;
+	double GetBucketUpper(size_t idx) const;
+private:
+	double mMinVal, mMaxVal;
+	double mLogMin;
+	int mPerDecade;
+	std::vector<uint64_t> mBuckets;	//[0]=underflow, [size-1]=overflow
+	uint64_t mCount = 0;
+	double mSum = 0, mMin = 0, mMax = 0;
+};
+
+/*
+One place to find every histogram by name so any part of the game can
+record into one and any other part (debug output, overlays, tools) can
+read it back. Names are just strings like "frame_ms".
+*/
+class Stats
+{
+public:
+	Stats(Stats const&) = delete;
+	void operator=(Stats const&) = delete;
+	static Stats& Get()
+	{
+		static Stats instance;
+		return instance;
+	}
+	//get a histogram, it's made the first time it's asked for
+	//look it up once and hang on to the reference in anything called every frame
+	Histogram& GetHistogram(const std::string& name);
+	//find an existing one, nullptr if nobody has made it
+	const Histogram* FindHistogram(const std::string& name) const;
+	//names of everything recorded so far
+	void GetNames(std::vector<std::string>& names) const;
+	void ResetAll();
+	//one line per histogram: name count min mean p50 p95 p99 max
+	bool Write(const std::string& fileName) const;
+private:
+	std::map<std::string, Histogram> mHistograms;
+	Stats() {}
+};
@@ -2,6 +2,8 @@
 #include <filesystem>
 
 #include "TexCache.h"
+#include "AssetArchive.h"
+#include "AssetManifest.h"
 
 using namespace std;
 using namespace DirectX;
@@ -12,6 +14,8 @@ void TexCache::Release()
 	for (auto& pair : mCache) 
 		ReleaseCOM(pair.second.pTex);
 	mCache.clear();
+	mByHandle.clear();
+	mHandles.clear();
 }
 
 ID3D11ShaderResourceView* TexCache::LoadTexture(ID3D11Device*pDevice, const std::string& fileName, const std::string& texName, 
@@ -37,38 +41,45 @@ ID3D11ShaderResourceView* TexCache::LoadTexture(ID3D11Device*pDevice, const std:
 		path = mAssetPath + fileName;
 		pPath = &path;
 	}
-	std::wstring ws(pPath->begin(), pPath->end());
-	//load it
+	//use the cooked version if there is one
+	const AssetManifest::Entry* pCooked = AssetManifest::Get().Find(*pPath);
+	if (pCooked)
+		pPath = &pCooked->cooked;
+	//load it, straight out of the archive if it's in there
 	DDS_ALPHA_MODE alpha;
-	ID3D11ShaderResourceView *pT;
-	if (CreateDDSTextureFromFile(pDevice, ws.c_str(), nullptr, &pT, 0, &alpha) != S_OK)
+	ID3D11ShaderResourceView *pT = nullptr;
+	HRESULT hr;
+	AssetArchive::Slice slice = AssetArchive::Get().Find(*pPath);
+	if (slice)
+		hr = CreateDDSTextureFromMemory(pDevice, slice.pData, slice.size, nullptr, &pT, 0, &alpha);
+	else
+	{
+		std::wstring ws(pPath->begin(), pPath->end());
+		hr = CreateDDSTextureFromFile(pDevice, ws.c_str(), nullptr, &pT, 0, &alpha);
+	}
+	if (hr != S_OK)
 	{
 		DBOUT("Cannot load " << *pPath << "\n");
 		assert(false);
 	}
-	//save it
+	//save it, a cooked texture still looks like the original size to everyone else
 	assert(pT);
-	mCache.insert(MyMap::value_type(name,Data(fileName, pT, GetDimensions(pT), frames)));
-	return pT;
-}
-
-
-//slowly find a texture by handle
-
-const TexCache::Data & TexCache::Get(ID3D11ShaderResourceView * pTex) {
-
-	MyMap::iterator it = mCache.begin();
-	Data *p = nullptr;
-	while (it != mCache.end() && !p)
+	Vector2 dim = GetDimensions(pT);
+	Data data(fileName, pT, dim, frames);
+	if (pCooked && pCooked->width && pCooked->height)
 	{
-		if ((*it).second.pTex == pTex)
-			p = &(*it).second;
-		++it;
+		data.dim = Vector2((float)pCooked->width, (float)pCooked->height);
+		data.texScale = dim / data.dim;
 	}
-	assert(p);
-	return *p;
+	assert(mByHandle.size() < NO_HANDLE);
+	data.handle = static_cast<Handle>(mByHandle.size());
+	Data& saved = mCache.insert(MyMap::value_type(name, data)).first->second;
+	mByHandle.push_back(&saved);
+	mHandles[pT] = saved.handle;
+	return pT;
 }
 
+
 Vector2 TexCache::GetDimensions(ID3D11ShaderResourceView* pTex)
 {
 	assert(pTex);
@@ -1,25 +1,20 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <unordered_map>
 #include <d3d11.h>
 
 #include "D3DUtil.h"
-
-//handy rectangle definer
-struct RECTF
-{
-	float left, top, right, bottom;
-	operator RECT() {
-		return RECT{ (int)left,(int)top,(int)right,(int)bottom };
-	}
-};
+#include "RenderTypes.h"
 
 //we only ever want one unique texture to be loaded
 //it can then be shared between any meshes that need it
 class TexCache
 {
 public:
+	typedef TexHandle Handle;
+	static const Handle NO_HANDLE = NO_TEX_HANDLE;
 	//associate a file name with a texture resource
 	struct Data
 	{
@@ -40,6 +35,9 @@ public:
 		ID3D11ShaderResourceView* pTex = nullptr;
 		DirectX::SimpleMath::Vector2 dim;
 		std::vector<RECTF> frames;
+		//a cooked texture can be smaller than dim, real size = dim * texScale
+		DirectX::SimpleMath::Vector2 texScale = DirectX::SimpleMath::Vector2(1, 1);
+		Handle handle = NO_HANDLE;
 	};
 
 	//tidy up at the end
@@ -54,14 +52,29 @@ public:
 	Data& Get(const std::string& texName) {
 		return mCache.at(texName);
 	}
-	//slowly find a texture by handle
-	const Data& Get(ID3D11ShaderResourceView *pTex);
+	//find a texture by its resource
+	const Data& Get(ID3D11ShaderResourceView *pTex) const {
+		return Get(GetHandle(pTex));
+	}
+	Handle GetHandle(ID3D11ShaderResourceView *pTex) const {
+		auto it = mHandles.find(pTex);
+		assert(it != mHandles.end());
+		return it->second;
+	}
+	//fastest, just an index
+	const Data& Get(Handle handle) const {
+		assert(handle < mByHandle.size());
+		return *mByHandle[handle];
+	}
 
 private:
 	DirectX::SimpleMath::Vector2 GetDimensions(ID3D11ShaderResourceView* pTex);
 	//array of texture data
 	typedef std::unordered_map<std::string, Data> MyMap;
 	MyMap mCache;
+	//the map's entries don't move, so these point straight at them
+	std::vector<Data*> mByHandle;
+	std::unordered_map<ID3D11ShaderResourceView*, Handle> mHandles;
 
 	//some data sub folder with all the textures in
 	std::string mAssetPath;
@@ -0,0 +1,119 @@
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "WavFile.h"
+
+using namespace std;
+
+namespace WavFile
+{
+
+bool Decode(const uint8_t *pBytes, const size_t numBytes, Data &data, const unsigned int maxChannels, std::string *pError)
+{
+	if (!pBytes || numBytes < 12 || memcmp(pBytes, "RIFF", 4) != 0 || memcmp(pBytes + 8, "WAVE", 4) != 0)
+	{
+		if (pError)
+			*pError = "not a wav file";
+		return false;
+	}
+
+	//walk the chunks looking for the format and the samples
+	uint16_t format = 0, numChannels = 0, bits = 0;
+	uint32_t rate = 0;
+	const uint8_t *pData = nullptr;
+	uint32_t dataBytes = 0;
+	size_t at = 12;
+	while (at + 8 <= numBytes)
+	{
+		uint32_t chunkSize;
+		memcpy(&chunkSize, pBytes + at + 4, 4);
+		const uint8_t *pChunk = pBytes + at + 8;
+		size_t avail = numBytes - (at + 8);
+		if (memcmp(pBytes + at, "fmt ", 4) == 0 && chunkSize >= 16 && avail >= 16)
+		{
+			memcpy(&format, pChunk, 2);
+			memcpy(&numChannels, pChunk + 2, 2);
+			memcpy(&rate, pChunk + 4, 4);
+			memcpy(&bits, pChunk + 14, 2);
+			//WAVE_FORMAT_EXTENSIBLE keeps the real format at the start of the guid
+			if (format == 0xFFFE && chunkSize >= 26 && avail >= 26)
+				memcpy(&format, pChunk + 24, 2);
+		}
+		else if (memcmp(pBytes + at, "data", 4) == 0)
+		{
+			pData = pChunk;
+			dataBytes = static_cast<uint32_t>(min<size_t>(chunkSize, avail));
+		}
+		at += 8 + static_cast<size_t>(chunkSize) + (chunkSize & 1);	//chunks are word aligned
+	}
+	bool pcm = (format == 1 && (bits == 8 || bits == 16 || bits == 24 || bits == 32));
+	bool flt = (format == 3 && bits == 32);
+	if (!pData || numChannels == 0 || rate == 0 || (!pcm && !flt))
+	{
+		if (pError)
+		{
+			stringstream ss;
+			ss << "unsupported format=" << format << " bits=" << bits;
+			*pError = ss.str();
+		}
+		return false;
+	}
+
+	unsigned int bytesPerSample = bits / 8;
+	unsigned int numFrames = dataBytes / (bytesPerSample * numChannels);
+	unsigned int outChannels = numChannels > maxChannels ? maxChannels : numChannels;
+	data.rate = rate;
+	data.numChannels = outChannels;
+	data.numFrames = numFrames;
+	data.samples.resize(numFrames * outChannels);
+	for (unsigned int f = 0; f < numFrames; ++f)
+	{
+		for (unsigned int c = 0; c < outChannels; ++c)
+		{
+			const uint8_t *p = pData + (f * numChannels + c) * bytesPerSample;
+			float s = 0;
+			if (flt)
+				memcpy(&s, p, 4);
+			else if (bits == 8)
+				s = (p[0] - 128) / 128.f;
+			else if (bits == 16)
+				s = static_cast<int16_t>(p[0] | (p[1] << 8)) / 32768.f;
+			else if (bits == 24)
+				s = static_cast<int32_t>((uint32_t(p[0]) << 8) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 24)) / 2147483648.f;
+			else
+				s = static_cast<int32_t>(uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24)) / 2147483648.f;
+			data.samples[f * outChannels + c] = s;
+		}
+	}
+	return true;
+}
+
+bool Write16(const std::string &fileName, const int16_t *pSamples, const unsigned int numFrames,
+	const unsigned int numChannels, const unsigned int rate)
+{
+	ofstream out(fileName, ios::binary | ios::trunc);
+	if (!out)
+		return false;
+	auto put32 = [&out](uint32_t v) { out.write(reinterpret_cast<const char*>(&v), 4); };
+	auto put16 = [&out](uint16_t v) { out.write(reinterpret_cast<const char*>(&v), 2); };
+	const uint16_t bits = 16;
+	uint32_t dataBytes = numFrames * numChannels * sizeof(int16_t);
+	out.write("RIFF", 4);
+	put32(36 + dataBytes);
+	out.write("WAVEfmt ", 8);
+	put32(16);
+	put16(1);	//pcm
+	put16(static_cast<uint16_t>(numChannels));
+	put32(rate);
+	put32(rate * numChannels * bits / 8);
+	put16(static_cast<uint16_t>(numChannels * bits / 8));
+	put16(bits);
+	out.write("data", 4);
+	put32(dataBytes);
+	out.write(reinterpret_cast<const char*>(pSamples), dataBytes);
+	return out.good();
+}
+
+}
@@ -0,0 +1,32 @@
+#ifndef WAVFILE_H
+#define WAVFILE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+Reading and writing uncompressed wav files without going through fmod,
+for the software mixer and the asset cooker. Anything pcm (8/16/24/32 bit)
+or 32bit float can be read, it all comes out as float.
+*/
+namespace WavFile
+{
+	struct Data
+	{
+		unsigned int rate = 0;
+		unsigned int numChannels = 0;
+		unsigned int numFrames = 0;
+		std::vector<float> samples;		//interleaved if more than one channel
+	};
+
+	//the whole file is in memory, anything over maxChannels is dropped
+	//pError gets a reason if it fails
+	bool Decode(const uint8_t *pBytes, const size_t numBytes, Data &data, const unsigned int maxChannels = 2,
+		std::string *pError = nullptr);
+	//a plain 16bit pcm file
+	bool Write16(const std::string &fileName, const int16_t *pSamples, const unsigned int numFrames,
+		const unsigned int numChannels, const unsigned int rate);
+}
+
+#endif
@@ -36,7 +36,7 @@ LRESULT WinUtil::RealDefaultMssgHandler(HWND hwnd, UINT msg, WPARAM wParam, LPAR
 	case WM_ACTIVATE:
 		if (LOWORD(wParam) == WA_INACTIVE)
 		{
-			mWinData.appPaused = true;
+			mWinData.appPaused = !mWinData.neverPause;
 		}
 		else
 		{
@@ -225,28 +225,14 @@ bool WinUtil::BeginLoop(bool& canUpdateRender)
 
 float WinUtil::EndLoop(bool didUpdateRender)
 {
-	if (!didUpdateRender)
-		return 0;
-	float deltaTime = 0;
-	if (!mWinData.appPaused)
-	{
-		__int64 countsPerSec;
-		QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSec);
-		double secondsPerCount = 1.0 / (double)countsPerSec;
-		static __int64 sTime1 = 0;
-		__int64 time2;
-		QueryPerformanceCounter((LARGE_INTEGER*)&time2);
-		if (sTime1 != 0)
-			deltaTime = (float)((time2 - sTime1)*secondsPerCount);
-		sTime1 = time2;
-		AddSecToClock(deltaTime);
-
-	}
-	else
+	if (!didUpdateRender || mWinData.appPaused)
 	{
-		Sleep(100);
+		//nothing to do until windows says something, so wake as soon as it does
+		MsgWaitForMultipleObjects(0, nullptr, FALSE, PAUSED_WAIT_MS, QS_ALLINPUT);
+		mPacer.Reset();
+		return 0;
 	}
-	return deltaTime;
+	return mPacer.Wait();
 }
 
 int WinUtil::Run(void(*pUpdate)(float), void(*pRender)(float))
@@ -254,10 +240,6 @@ int WinUtil::Run(void(*pUpdate)(float), void(*pRender)(float))
 	MSG msg = { 0 };
 	assert(pUpdate && pRender);
 
-	__int64 countsPerSec;
-	QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSec);
-	double secondsPerCount = 1.0 / (double)countsPerSec;
-
 	float deltaTime = 0;
 	while (msg.message != WM_QUIT)
 	{
@@ -277,17 +259,12 @@ int WinUtil::Run(void(*pUpdate)(float), void(*pRender)(float))
 					pUpdate(deltaTime);
 				pRender(deltaTime);
 
-				static __int64 sTime1=0;
-				__int64 time2;
-				QueryPerformanceCounter((LARGE_INTEGER*)&time2);
-				if(sTime1!=0)
-					deltaTime = (float)((time2 - sTime1)*secondsPerCount);
-				sTime1 = time2;
-				AddSecToClock(deltaTime);
+				deltaTime = mPacer.Wait();
 			}
 			else
 			{
-				Sleep(100);
+				MsgWaitForMultipleObjects(0, nullptr, FALSE, PAUSED_WAIT_MS, QS_ALLINPUT);
+				mPacer.Reset();
 			}
 		}
 	}
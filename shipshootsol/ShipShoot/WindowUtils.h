@@ -7,6 +7,8 @@
 #include <sstream>
 #include <assert.h>
 
+#include "FramePacer.h"
+
 class MyD3D;
 
 class WinUtil
@@ -47,6 +49,13 @@ public:
 		return mWinData.clientHeight;
 	}
 	void ChooseRes(int& w, int& h, int defaults[], int numPairs);
+	//EndLoop waits on this to hold the frame rate down
+	FramePacer& GetPacer() { return mPacer; }
+	//keep going when the window loses focus or is hidden, for runs nobody is watching
+	void SetNeverPause(bool on) {
+		mWinData.neverPause = on;
+		mWinData.appPaused = false;
+	}
 
 private:
 	struct WinData
@@ -58,12 +67,16 @@ private:
 		bool      minimized = false;
 		bool      maximized = false;
 		bool      resizing = false;
+		bool      neverPause = false;
 		std::string mainWndCaption;
 		int clientWidth;
 		int clientHeight;
 	};
 	WinData mWinData;
 	MyD3D *mpMyD3D;
+	FramePacer mPacer;
+	//longest to wait for a message while paused before looking again
+	enum { PAUSED_WAIT_MS = 100 };
 	
 	WinUtil() 
 		:mpMyD3D(nullptr) 
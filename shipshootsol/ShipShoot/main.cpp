@@ -1,11 +1,23 @@
 #include <windows.h>
+#include <psapi.h>
 #include <string>
 #include <cassert>
 #include <d3d11.h>
 #include <vector>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cstdio>
 
 #include "WindowUtils.h"
 #include "Game.h"
+#include "AudioMix.h"
+#include "AudioMgrOffline.h"
+#include "Stats.h"
+#include "AssetArchive.h"
+#include "AssetManifest.h"
+#include "Profiler.h"
+#include "AllocTracker.h"
 
 using namespace std;
 using namespace DirectX;
@@ -15,6 +27,9 @@ using namespace DirectX::SimpleMath;
 
 
 
+//the real keyboard/mouse/pads if we're using them, raw input arrives through the window
+static Win32InputSource* spLiveInput = nullptr;
+
 //if ALT+ENTER or resize or drag window we might want do
 //something like pause the game perhaps, but we definitely
 //need to let D3D know what's happened (OnResize_Default).
@@ -40,7 +55,8 @@ LRESULT CALLBACK MainWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 			break;
 		}
 	case WM_INPUT:
-		Game::sMKIn.MessageEvent((HRAWINPUT)lParam);
+		if (spLiveInput)
+			spLiveInput->MessageEvent((HRAWINPUT)lParam);
 		break;
 	}
 
@@ -48,10 +64,164 @@ LRESULT CALLBACK MainWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 	return WinUtil::DefaultMssgHandler(hwnd, msg, wParam, lParam);
 }
 
+//look for a switch on the command line, optionally grab the word after it
+//e.g. "-offlineaudio session.wav"
+bool GetArg(const string& cmdLine, const string& name, string* pValue = nullptr)
+{
+	istringstream ss(cmdLine);
+	string word;
+	while (ss >> word)
+	{
+		if (word != name)
+			continue;
+		if (pValue && !(ss >> *pValue))
+			return false;
+		return true;
+	}
+	return false;
+}
+
+//time the software mixing kernels with each instruction set the cpu has
+//results go to the debug output and bench_mix.txt so a headless run can read them
+void BenchMix()
+{
+	ofstream out("bench_mix.txt");
+	const AudioMix::Isa isas[]{ AudioMix::Isa::SCALAR, AudioMix::Isa::SSE2, AudioMix::Isa::AVX2 };
+	for (auto isa : isas)
+	{
+		if (static_cast<int>(isa) > static_cast<int>(AudioMix::GetBestIsa()))
+			break;
+		AudioMix::BenchResult res = AudioMix::Benchmark(isa, 64, 512, 2000);
+		DBOUT("mix " << AudioMix::GetIsaName(res.isa) << " voices=" << res.numVoices << " frames=" << res.framesPerBlock
+			<< " wall ms=" << res.wallMs << " voices/ms=" << res.voicesPerMs);
+		out << AudioMix::GetIsaName(res.isa) << " " << res.voicesPerMs << " voices/ms\n";
+	}
+}
+
+//what a profiler zone costs, to bench_profile.txt like BenchMix
+void BenchProfile()
+{
+	ofstream out("bench_profile.txt");
+	Profiler::BenchResult res = Profiler::Benchmark(1000000);
+	Profiler::Get().Clear();
+	DBOUT("profile zones=" << res.numZones << " ns/zone=" << res.nsPerZone << " ns/empty loop=" << res.nsPerEmptyLoop);
+	out << res.nsPerZone << " ns/zone\n";
+}
+
+//a very simple automated player for "-bot", signs in, then keeps starting
+//games, weaving about and shooting, space also gets it past game over
+static void BotPlayer(ScriptedInputSource& src, uint64_t tick)
+{
+	if (tick == 1)
+	{
+		src.Tap(1, VK_B);
+		src.Tap(3, VK_O);
+		src.Tap(5, VK_T);
+	}
+	if (tick % 240 == 10)
+		src.Tap(tick, VK_RETURN, 2);
+	if (tick % 30 == 0)
+		src.Tap(tick, VK_SPACE, 2);
+	if (tick % 120 == 0)
+		src.Tap(tick, (tick / 120) % 2 ? VK_LEFT : VK_RIGHT, 100);
+}
+
+//"-allocgate 600" plays a session headless and fails if any of 600 frames after
+//the warm-up allocates, where they did goes in the report
+//only the main thread is checked, and frames where the game starts, ends or
+//files a score are skipped, see AllocTracker
+const uint64_t ALLOCGATE_WARMUP = 240;
+const char ALLOCGATE_REPORT[] = "alloc_gate.txt";
+
+//the gate's over, 0 if every frame it watched stayed off the heap
+int FinishAllocGate(uint64_t numFrames)
+{
+	AllocTracker& allocs = AllocTracker::Get();
+	allocs.StopCapture();
+	allocs.WriteReport(ALLOCGATE_REPORT);
+	bool ok = allocs.GetNumCapturedFrames() >= numFrames && allocs.GetNumAllocatingFrames() == 0;
+	DBOUT("Alloc gate " << (ok ? "passed" : "FAILED") << ": " << allocs.GetNumCapturedFrames() << "/" << numFrames
+		<< " frames, " << allocs.GetNumAllocatingFrames() << " allocated, see " << ALLOCGATE_REPORT);
+	return ok ? 0 : 1;
+}
+
+//"-soak 2000" has the bot play that many games (more than the warm-up) back to
+//back, headless, and fails if memory is still growing once it's warmed up,
+//figures after every game go in the report so a slow leak shows up as a trend
+//its scores go in a leaderboard of their own that starts empty every run
+const int SOAK_WARMUP_GAMES = 5;
+const uint64_t SOAK_LIVE_SLACK = 256;			//allocations
+const size_t SOAK_RSS_SLACK = 16 * 1024 * 1024;	//bytes
+const char SOAK_REPORT[] = "soak.txt";
+const char SOAK_LEADERBOARD[] = "soak_leaderboard.dat";
+
+struct SoakSample
+{
+	int game = 0;
+	uint64_t numLive = 0;		//allocations not yet freed
+	size_t rss = 0;				//working set, bytes
+};
+
+SoakSample TakeSoakSample(int game)
+{
+	SoakSample s;
+	s.game = game;
+	s.numLive = AllocTracker::Get().GetNumLive();
+	PROCESS_MEMORY_COUNTERS mem{};
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &mem, sizeof(mem)))
+		s.rss = mem.WorkingSetSize;
+	return s;
+}
+
+//0 if nothing grew between the end of the warm-up and the last game
+int FinishSoak(const SoakSample& warm, const SoakSample& last, int numGames)
+{
+	bool ok = last.game >= numGames && warm.game > 0 &&
+		last.numLive <= warm.numLive + SOAK_LIVE_SLACK && last.rss <= warm.rss + SOAK_RSS_SLACK;
+	DBOUT("Soak " << (ok ? "passed" : "FAILED") << ": " << last.game << "/" << numGames << " games, live allocations "
+		<< warm.numLive << " -> " << last.numLive << ", working set " << warm.rss / 1024 << "KB -> " << last.rss / 1024
+		<< "KB, see " << SOAK_REPORT);
+	return ok ? 0 : 1;
+}
+
+//frame rate cap when nobody asks for a different one
+const double DEFAULT_FPS = 120;
+
+//everything the game loads, packed into one file next to the exe
+const char ASSET_ARCHIVE[] = "assets.pak";
+
+//build the archive from the loose files and say how it went
+int PackAssets(const string& outFile)
+{
+	size_t numFiles = 0;
+	bool ok = AssetArchive::Pack({ "data", "sfx", "music", "cooked" }, { ".dds", ".spritefont", ".wav", ".ogg", ".mp3", ".wma", ".txt" },
+		outFile, &numFiles);
+	DBOUT("Packed " << numFiles << " files into " << outFile << (ok ? "" : " FAILED"));
+	return ok ? 0 : 1;
+}
+
 //main entry point for the game
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance,
 				   PSTR cmdLine, int showCmd)
 {
+	auto startTime = chrono::steady_clock::now();
+	PROFILE_THREAD("main");
+	if (GetArg(cmdLine, "-benchmix"))
+	{
+		BenchMix();
+		return 0;
+	}
+	if (GetArg(cmdLine, "-benchprofile"))
+	{
+		BenchProfile();
+		return 0;
+	}
+	if (GetArg(cmdLine, "-packassets"))
+		return PackAssets(ASSET_ARCHIVE);
+	//loose files are the fallback, or force them while working on assets
+	bool packed = !GetArg(cmdLine, "-looseassets") && AssetArchive::Get().Open(ASSET_ARCHIVE);
+	//whatever AssetCooker has made gets used instead of the originals
+	AssetManifest::Get().Load("cooked/manifest.txt");
 
 	int w(700), h(700);
 	//int defaults[] = { 640,480, 800,600, 1024,768, 1280,1024 };
@@ -59,27 +229,193 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance,
 	if (!WinUtil::Get().InitMainWindow(w, h, hInstance, "Fezzy", MainWndProc, true))
 		assert(false);
 
+	//needs a session to play, "-warmup 100" if it settles down sooner or later than usual
+	string gateFrames, gateWarmup;
+	const bool allocGate = GetArg(cmdLine, "-allocgate", &gateFrames);
+	const uint64_t numGateFrames = allocGate ? stoull(gateFrames) : 0;
+	const uint64_t gateStart = GetArg(cmdLine, "-warmup", &gateWarmup) ? stoull(gateWarmup) : ALLOCGATE_WARMUP;
+	if (allocGate && !GetArg(cmdLine, "-replay") && !GetArg(cmdLine, "-bot"))
+	{
+		DBOUT("-allocgate needs -replay or -bot");
+		return 1;
+	}
+	string soakGames;
+	const bool soak = GetArg(cmdLine, "-soak", &soakGames);
+	const int numSoakGames = soak ? stoi(soakGames) : 0;
+	//its buffers grow as it records, which isn't the game allocating
+	if (allocGate || soak)
+		Profiler::Get().SetEnabled(false);
+
+	//"-headless" renders on the cpu and never shows anything, pair it with -bot or -replay
+	const bool headless = GetArg(cmdLine, "-headless") || allocGate || soak;
+	if (headless)
+	{
+		WinUtil::Get().SetNeverPause(true);
+		ShowWindow(WinUtil::Get().GetMainWnd(), SW_HIDE);
+	}
 	MyD3D d3d;
-	if (!d3d.InitDirect3D(OnResize))
+	if (!d3d.InitDirect3D(OnResize, headless))
 		assert(false);
 	WinUtil::Get().SetD3D(d3d);
 	d3d.GetCache().SetAssetPath("data/");
-	Game game(d3d);
+
+	//offline audio runs the game on a fixed tick as fast as it can go, the audio
+	//manager mixes one tick per update into a wav instead of using the sound card
+	//"-latencycheck 3" pretends there's a sound card with 3 ticks queued and
+	//checks every latency measurement against that
+	const float OFFLINE_TICK = 1 / 60.f;
+	string offlineWav, queued;
+	bool offline = GetArg(cmdLine, "-offlineaudio", &offlineWav);
+	shared_ptr<IAudioMgr> audio;
+	shared_ptr<LatencyCheckSink> checker;
+	if (offline)
+	{
+		shared_ptr<IAudioSink> sink = make_shared<WavFileSink>(offlineWav);
+		if (GetArg(cmdLine, "-latencycheck", &queued))
+			sink = checker = make_shared<LatencyCheckSink>(stoi(queued), sink);
+		audio = make_shared<AudioMgrOffline>(sink, OFFLINE_TICK);
+		if (checker)
+			audio->GetLatencyProbe().SetListener(checker.get());
+	}
+
+	//"-seed n" for a different session that still repeats, "-stream k" for the
+	//kth of several run side by side with the same seed that mustn't match
+	string seed, stream;
+	Random random(GetArg(cmdLine, "-seed", &seed) ? stoull(seed) : Random::DEFAULT_SEED);
+	for (int i = GetArg(cmdLine, "-stream", &stream) ? stoi(stream) : 0; i > 0; --i)
+		random.Jump();
+
+	//"-replay file" plays back what "-record file" saved, random numbers and all,
+	//"-bot" plays by itself, neither needs the real clock so they run flat out
+	unique_ptr<IInputSource> input;
+	string replayFile, recordFile;
+	if (GetArg(cmdLine, "-replay", &replayFile))
+	{
+		auto recorded = make_unique<RecordedInputSource>(Game::TICK_HZ);
+		if (recorded->Load(replayFile))
+		{
+			random.SetState(recorded->GetRandomState());
+			input = move(recorded);
+		}
+		else
+			DBOUT("Cannot replay " << replayFile);
+	}
+	else if (GetArg(cmdLine, "-bot") || soak)
+	{
+		auto bot = make_unique<ScriptedInputSource>(Game::TICK_HZ);
+		bot->SetBot(BotPlayer);
+		input = move(bot);
+	}
+	if (!input)
+	{
+		auto live = make_unique<Win32InputSource>(WinUtil::Get().GetMainWnd());
+		spLiveInput = live.get();
+		input = move(live);
+	}
+	const bool realTime = input->IsRealTime() && !offline;
+	Game game(d3d, move(input), audio);
+	game.SetRandom(random);
+	game.SetVirtualClock(!realTime);
+	if (soak)
+	{
+		remove(SOAK_LEADERBOARD);
+		remove((string(SOAK_LEADERBOARD) + ".log").c_str());
+		game.SetLeaderboardFile(SOAK_LEADERBOARD);
+	}
+	//Present doesn't wait for vsync, so hold the frame rate down ourselves unless
+	//we're meant to be running flat out, "-fps 0" to run uncapped anyway
+	string fps;
+	WinUtil::Get().GetPacer().SetTargetHz(!realTime ? 0 : GetArg(cmdLine, "-fps", &fps) ? stod(fps) : DEFAULT_FPS);
+	if (GetArg(cmdLine, "-record", &recordFile) && !game.RecordInput(recordFile))
+		DBOUT("Cannot record to " << recordFile);
+	//"-latency" follows presses through to the screen, results in the -stats file
+	if (GetArg(cmdLine, "-latency"))
+		game.MeasureInputLatency();
 
 	bool canUpdateRender;
 	float dTime = 0;
+	bool firstFrame = true;
+	uint64_t numFrames = 0;
+	SoakSample soakWarm, soakLast;
+	FILE* pSoakFile = soak ? fopen(SOAK_REPORT, "w") : nullptr;
+	if (pSoakFile)
+		fprintf(pSoakFile, "game live_allocs working_set_kb\n");
 	while (WinUtil::Get().BeginLoop(canUpdateRender))
 	{
 		if (canUpdateRender && dTime>0)
 		{
 			game.Update(dTime);
 			game.Render(dTime);
+			if (firstFrame)
+			{
+				//how long from launch until something was on screen
+				double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+				Stats::Get().GetHistogram("first_frame_ms").Add(ms);
+				DBOUT("First frame after " << ms << "ms from " << (packed ? "asset archive" : "loose files"));
+				firstFrame = false;
+			}
+			//everything from here on should come out of what's already allocated
+			if (allocGate && ++numFrames == gateStart)
+				AllocTracker::Get().StartCapture();
+			else if (allocGate && numFrames == gateStart + numGateFrames)
+				PostQuitMessage(0);
+			//a game has just ended and everything it made should be gone
+			if (soak && game.GetNumGamesPlayed() != soakLast.game)
+			{
+				soakLast = TakeSoakSample(game.GetNumGamesPlayed());
+				if (pSoakFile)
+					fprintf(pSoakFile, "%d %llu %llu\n", soakLast.game, static_cast<unsigned long long>(soakLast.numLive),
+						static_cast<unsigned long long>(soakLast.rss / 1024));
+				if (soakLast.game == SOAK_WARMUP_GAMES)
+					soakWarm = soakLast;
+				if (soakLast.game >= numSoakGames)
+					PostQuitMessage(0);
+			}
 		}
 		dTime = WinUtil::Get().EndLoop(canUpdateRender);
+		if (offline && canUpdateRender)
+			dTime = OFFLINE_TICK;
+		else if (!realTime && canUpdateRender)
+			dTime = 1.f / Game::TICK_HZ;
+		//a replay that's run out has nothing more to show
+		if (game.GetInputSource().IsFinished())
+			PostQuitMessage(0);
 	}
 
+	if (const InputLatencyProbe* pLatency = game.GetInputLatency())
+	{
+		DBOUT("Input latency: " << pLatency->GetNumMeasured() << " presses, " << pLatency->GetNumDropped() << " dropped");
+		for (const char* stage : { "input_wait_ms", "input_sim_ms", "input_render_ms", "input_present_ms", "input_total_ms" })
+		{
+			const Histogram* pHist = Stats::Get().FindHistogram(stage);
+			if (pHist && pHist->GetCount())
+				DBOUT("  " << stage << " p50=" << pHist->GetPercentile(50) << " p99=" << pHist->GetPercentile(99) << " max=" << pHist->GetMax());
+		}
+	}
+	//before anything's shut down so the counts are only the game's
+	int result = allocGate ? FinishAllocGate(numGateFrames) : 0;
+	if (soak)
+	{
+		if (pSoakFile)
+			fclose(pSoakFile);
+		result |= FinishSoak(soakWarm, soakLast, numSoakGames);
+	}
 	game.Release();
+	spLiveInput = nullptr;
 	d3d.ReleaseD3D(true);	
-	return 0;
+
+	if (checker)
+		DBOUT("Latency check: " << checker->GetNumChecked() << " checked, " << checker->GetNumFailed()
+			<< " failed, worst error " << checker->GetWorstErrorSec() * 1000 << "ms, "
+			<< checker->GetNumUnderruns() << " underruns");
+	//frame times, audio latency, everything recorded
+	string statsFile;
+	if (GetArg(cmdLine, "-stats", &statsFile))
+		Stats::Get().Write(statsFile);
+	//"-profile trace.json" saves every zone at exit, F9 saves to Game::PROFILE_FILE any time
+	string profileFile;
+	if (SHIPSHOOT_PROFILING && GetArg(cmdLine, "-profile", &profileFile))
+		Profiler::Get().WriteChromeTrace(profileFile);
+	return result;
 }
 
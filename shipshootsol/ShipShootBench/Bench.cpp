@@ -0,0 +1,82 @@
+#include <cstdio>
+#include <algorithm>
+
+#include "Bench.h"
+#include "Clock.h"
+
+using namespace std;
+
+//never fewer than this many batches, however slow
+static const size_t MIN_BATCHES = 5;
+
+BenchSuite::BenchSuite(double minMs, unsigned int maxIters)
+	: mMinMs(minMs), mMaxIters(max(1u, maxIters))
+{
+}
+
+bool BenchSuite::Wants(const std::string& name) const
+{
+	return mFilter.empty() || name.find(mFilter) != string::npos;
+}
+
+void BenchSuite::Run(const std::string& name, int count, const std::function<void()>& setup, const std::function<void()>& run)
+{
+	if (!Wants(name))
+		return;
+	//one untimed batch to warm caches and let anything lazy happen
+	setup();
+	for (unsigned int i = 0; i < mMaxIters; ++i)
+		run();
+
+	vector<double> batchNs;
+	int64_t totalNs = 0;
+	while (totalNs < Clock::FromMs(mMinMs) || batchNs.size() < MIN_BATCHES)
+	{
+		setup();
+		int64_t start = Clock::NowNs();
+		for (unsigned int i = 0; i < mMaxIters; ++i)
+			run();
+		int64_t ns = Clock::NowNs() - start;
+		totalNs += ns;
+		batchNs.push_back(ns / static_cast<double>(mMaxIters));
+	}
+	Result res;
+	res.name = name;
+	res.count = count;
+	res.iterations = batchNs.size() * mMaxIters;
+	res.nsMin = *min_element(batchNs.begin(), batchNs.end());
+	nth_element(batchNs.begin(), batchNs.begin() + batchNs.size() / 2, batchNs.end());
+	res.nsPerIter = batchNs[batchNs.size() / 2];
+	mResults.push_back(res);
+	printf("%-24s %6d %12.1f ns/iter %10.2f ns/entity\n", name.c_str(), count, res.nsPerIter, res.nsPerEntity());
+}
+
+void BenchSuite::AddSize(const std::string& name, size_t bytes)
+{
+	mSizes.emplace_back(name, bytes);
+	printf("sizeof %-17s %6zu\n", name.c_str(), bytes);
+}
+
+bool BenchSuite::WriteJson(const std::string& fileName, const std::string& label) const
+{
+	FILE* pFile = fopen(fileName.c_str(), "w");
+	if (!pFile)
+		return false;
+	//names and labels are ours, nothing in them needs escaping apart from quotes
+	string safeLabel = label;
+	replace(safeLabel.begin(), safeLabel.end(), '"', '\'');
+	fprintf(pFile, "{\n\"label\": \"%s\",\n\"results\": [\n", safeLabel.c_str());
+	for (size_t i = 0; i < mResults.size(); ++i)
+	{
+		const Result& r = mResults[i];
+		fprintf(pFile, "  {\"name\": \"%s\", \"count\": %d, \"iterations\": %llu, \"ns_per_iter\": %.1f, \"ns_min\": %.1f, \"ns_per_entity\": %.3f}%s\n",
+			r.name.c_str(), r.count, static_cast<unsigned long long>(r.iterations), r.nsPerIter, r.nsMin, r.nsPerEntity(),
+			i + 1 < mResults.size() ? "," : "");
+	}
+	fprintf(pFile, "],\n\"sizes\": {");
+	for (size_t i = 0; i < mSizes.size(); ++i)
+		fprintf(pFile, "%s\"%s\": %zu", i ? ", " : "", mSizes[i].first.c_str(), mSizes[i].second);
+	fprintf(pFile, "}\n}\n");
+	bool ok = !ferror(pFile);
+	return fclose(pFile) == 0 && ok;
+}
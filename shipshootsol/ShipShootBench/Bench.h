@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+#include <utility>
+
+/*
+Times small pieces of game code over and over and keeps the results so
+they can be written out as json and compared between commits. Each
+benchmark is run in batches, a setup function puts the world back how
+the benchmark wants it before every batch (untimed), then the run
+function is called up to maxIters times. Batches continue until minMs
+of timed work is done, the median batch is what's reported, so the odd
+batch that gets interrupted by the OS doesn't count.
+*/
+class BenchSuite
+{
+public:
+	struct Result
+	{
+		std::string name;
+		int count;				//entities involved, whatever that means for the benchmark
+		uint64_t iterations;	//run calls timed in total
+		double nsPerIter;		//median of the batches
+		double nsMin;			//fastest batch, per iteration
+		double nsPerEntity() const { return count > 0 ? nsPerIter / count : nsPerIter; }
+	};
+
+	//minMs - timed work per benchmark, maxIters - most run calls between setups
+	BenchSuite(double minMs = 100, unsigned int maxIters = 120);
+	//only run benchmarks with this in their name, empty = all
+	void SetFilter(const std::string& filter) { mFilter = filter; }
+	bool Wants(const std::string& name) const;
+	void Run(const std::string& name, int count, const std::function<void()>& setup, const std::function<void()>& run);
+	const std::vector<Result>& GetResults() const { return mResults; }
+	//not timed, written with the results so layout changes show up next to them
+	void AddSize(const std::string& name, size_t bytes);
+	//label - anything to tell runs apart, e.g. a commit hash
+	bool WriteJson(const std::string& fileName, const std::string& label) const;
+private:
+	double mMinMs;
+	unsigned int mMaxIters;
+	std::string mFilter;
+	std::vector<Result> mResults;
+	std::vector<std::pair<std::string, size_t>> mSizes;
+};
@@ -0,0 +1,238 @@
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+#include "CoreBench.h"
+#include "Formation.h"
+#include "ShooterIndex.h"
+#include "Random.h"
+#include "Leaderboard.h"
+#include "InputQueue.h"
+#include "SpscRing.h"
+#include "FrameArena.h"
+#include "AudioMix.h"
+
+using namespace std;
+using namespace DirectX::SimpleMath;
+
+//entity counts each benchmark is run with
+static const int COUNTS[]{ 10, 100, 1000 };
+//results go here so the optimiser can't throw the work away
+static volatile int sink;
+
+//what CollidePlayerBullets did before the formation was a bitboard, every enemy from the back
+static int ScanHitTest(const Formation& formation, const Vector2& pos, const Vector2& size)
+{
+	Vector2 enemySize = formation.GetEnemySize();
+	for (int slot = formation.GetNumSlots() - 1; slot >= 0; --slot)
+	{
+		if (!formation.IsAlive(slot))
+			continue;
+		Vector2 enemyPos = formation.GetPos(slot);
+		if (pos.x < enemyPos.x + enemySize.x &&
+			pos.x + size.x > enemyPos.x &&
+			pos.y < enemyPos.y + enemySize.y &&
+			pos.y + size.y > enemyPos.y)
+			return slot;
+	}
+	return -1;
+}
+
+//bullets against formations from the game's size up, with every third enemy already shot
+static void BenchFormation(BenchSuite& suite, const RenderProxy& enemyProto, const Vector2& bulletSize, float dTime)
+{
+	if (!suite.Wants("formation"))
+		return;
+	struct Layout { int numCols, numRows; };
+	const Layout layouts[]{ { 6, 5 }, { 11, 5 }, { 32, 16 }, { 64, 64 } };
+	const int NUM_BULLETS = 256;
+	for (const Layout& layout : layouts)
+	{
+		Formation formation;
+		Vector2 gap(70, 40);
+		formation.Init(enemyProto, Vector2(100, 50), gap, layout.numCols, layout.numRows);
+		for (int slot = 0; slot < formation.GetNumSlots(); slot += 3)
+			formation.Kill(slot);
+		//spread over the formation and a bit round it, most miss like they do in a game
+		vector<Vector2> bullets;
+		Vector2 area(layout.numCols * gap.x + 200, layout.numRows * gap.y + 200);
+		for (int i = 0; i < NUM_BULLETS; ++i)
+			bullets.push_back(Vector2(0.f + (i % 16) * area.x / 16, (i / 16) * area.y / 16));
+		int n = formation.GetNumSlots();
+		auto none = []() {};
+		suite.Run("formation_hit_scan", n, none, [&]() {
+			for (const Vector2& pos : bullets)
+				sink = ScanHitTest(formation, pos, bulletSize);
+		});
+		suite.Run("formation_hit_bitboard", n, none, [&]() {
+			for (const Vector2& pos : bullets)
+				sink = formation.HitTest(pos, bulletSize);
+		});
+		suite.Run("formation_front", n, none, [&]() {
+			for (int col = 0; col < formation.GetNumCols(); ++col)
+				sink = formation.GetFront(col);
+		});
+		//wide enough that it never reaches a side, it's the same work either way
+		RECTF playArea{ -1e6f, 0, 1e6f, 1e6f };
+		formation.SetSpeed(100);
+		suite.Run("formation_update", n, none, [&]() { formation.Update(dTime, playArea); });
+	}
+}
+
+//who fires next from n enemies laid out like PlayModeBench does, and starting a level
+static void BenchShooters(BenchSuite& suite, const RenderProxy& enemyProto)
+{
+	if (!suite.Wants("shooter"))
+		return;
+	for (int n : COUNTS)
+	{
+		Formation formation;
+		int numCols = (std::max)(10, n / 25);
+		int numRows = (n + numCols - 1) / numCols;
+		formation.Init(enemyProto, Vector2(100, 50), Vector2(40, 40), numCols, numRows);
+		for (int slot = n; slot < formation.GetNumSlots(); ++slot)
+			formation.Kill(slot);
+		ShooterIndex shooters;
+		RandomFirePattern pattern;
+		Random random;
+		suite.Run("shooter_index_pick", n, [&]() { shooters.Reset(formation, 0); random.Seed(1); }, [&]() {
+			sink = pattern.Pick(shooters, random);
+		});
+		suite.Run("shooter_index_reset", n, []() {}, [&]() { shooters.Reset(formation, 0); });
+	}
+}
+
+//n numbers each
+static void BenchRandom(BenchSuite& suite)
+{
+	if (!suite.Wants("random"))
+		return;
+	Random random;
+	for (int n : COUNTS)
+	{
+		suite.Run("random_next", n, [&]() { random.Seed(1); }, [&]() {
+			uint64_t sum = 0;
+			for (int i = 0; i < n; ++i)
+				sum += random.Next();
+			sink = static_cast<int>(sum);
+		});
+		suite.Run("random_below", n, [&]() { random.Seed(1); }, [&]() {
+			uint32_t sum = 0;
+			for (int i = 0; i < n; ++i)
+				sum += random.Below(1000);
+			sink = static_cast<int>(sum);
+		});
+	}
+}
+
+//in memory only, the disk side is PersistWorker's and isn't what's being timed
+static void BenchLeaderboard(BenchSuite& suite)
+{
+	if (!suite.Wants("leaderboard"))
+		return;
+	const int NUM_ENTRIES = 100000;
+	Random random;
+	for (int n : COUNTS)
+	{
+		unique_ptr<Leaderboard> board;
+		suite.Run("leaderboard_add", n, [&]() { board = make_unique<Leaderboard>(); random.Seed(1); }, [&]() {
+			for (int i = 0; i < n; ++i)
+				board->Add("BENCH", random.Range(0, 100000));
+		});
+		board = make_unique<Leaderboard>();
+		random.Seed(1);
+		for (int i = 0; i < NUM_ENTRIES; ++i)
+			board->Add("BENCH", random.Range(0, 100000));
+		suite.Run("leaderboard_rank", n, []() {}, [&]() {
+			uint64_t sum = 0;
+			for (int i = 0; i < n; ++i)
+				sum += board->GetRank(i * 100);
+			sink = static_cast<int>(sum);
+		});
+	}
+}
+
+//n key events in and out again, what a tick costs with a lot of input
+static void BenchInput(BenchSuite& suite)
+{
+	if (!suite.Wants("input") && !suite.Wants("spsc"))
+		return;
+	InputQueue input(InputQueue::CAPACITY);
+	SpscRing<InputEvent> ring(InputQueue::CAPACITY);
+	int64_t timeNs = 0;
+	for (int n : COUNTS)
+	{
+		suite.Run("input_queue", n, []() {}, [&]() {
+			for (int i = 0; i < n; ++i)
+				input.PushKey(static_cast<uint16_t>('A' + i % 26), i % 2 == 0, ++timeNs);
+			input.ConsumeUntil(timeNs);
+		});
+		suite.Run("spsc_ring", n, []() {}, [&]() {
+			InputEvent e{};
+			for (int i = 0; i < n; ++i)
+				ring.Push(e);
+			while (ring.Pop(e))
+				++sink;
+		});
+	}
+}
+
+//n short strings, then the end of the frame
+static void BenchFrameArena(BenchSuite& suite)
+{
+	if (!suite.Wants("frame_arena"))
+		return;
+	FrameArena arena(1 << 20);
+	for (int n : COUNTS)
+	{
+		suite.Run("frame_arena_format", n, []() {}, [&]() {
+			for (int i = 0; i < n; ++i)
+				sink = arena.Format("%d", i)[0];
+			arena.Reset();
+		});
+	}
+}
+
+//n voices of a block each into a stereo bus, and the bus out to 16bit, with every kernel set the cpu has
+static void BenchMix(BenchSuite& suite)
+{
+	if (!suite.Wants("mix"))
+		return;
+	const unsigned int FRAMES = 256;
+	vector<float> voice(FRAMES), bus(FRAMES * 2);
+	vector<int16_t> out(FRAMES * 2);
+	for (unsigned int i = 0; i < FRAMES; ++i)
+		voice[i] = (i % 64) / 32.f - 1;
+	AudioMix::Isa was = AudioMix::GetIsa();
+	AudioMix::Isa best = AudioMix::GetBestIsa();
+	for (AudioMix::Isa isa : { AudioMix::Isa::SCALAR, AudioMix::Isa::SSE2, AudioMix::Isa::AVX2 })
+	{
+		if (isa > best)
+			break;
+		AudioMix::SetIsa(isa);
+		string isaName = AudioMix::GetIsaName(isa);
+		for (int n : COUNTS)
+		{
+			suite.Run("mix_mono_to_stereo_" + isaName, n, [&]() { fill(bus.begin(), bus.end(), 0.f); }, [&]() {
+				for (int i = 0; i < n; ++i)
+					AudioMix::MixMonoToStereo(bus.data(), voice.data(), FRAMES, 0.01f, 0.02f);
+			});
+		}
+		suite.Run("mix_float_to_int16_" + isaName, FRAMES * 2, []() {}, [&]() {
+			AudioMix::FloatToInt16(bus.data(), out.data(), FRAMES * 2);
+		});
+	}
+	AudioMix::SetIsa(was);
+}
+
+void RunCoreBenches(BenchSuite& suite, const RenderProxy& enemyProto, const Vector2& bulletSize, float dTime)
+{
+	BenchFormation(suite, enemyProto, bulletSize, dTime);
+	BenchShooters(suite, enemyProto);
+	BenchRandom(suite);
+	BenchLeaderboard(suite);
+	BenchInput(suite);
+	BenchFrameArena(suite);
+	BenchMix(suite);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Bench.h"
+#include "RenderTypes.h"
+
+/*
+The benchmarks that only need gameplay code with nothing from D3D or
+FMOD behind it: the formation, the shooter index, random numbers, the
+leaderboard, input, the frame arena and the mixing kernels. The game's
+ShipShootBench runs them after its own and the portable build runs
+them by themselves (PortableMain.cpp), so they give the same numbers on
+any platform.
+*/
+//enemyProto - what a formation enemy looks like on screen
+//bulletSize - a player bullet on screen
+//dTime - one game tick
+void RunCoreBenches(BenchSuite& suite, const RenderProxy& enemyProto, const DirectX::SimpleMath::Vector2& bulletSize, float dTime);
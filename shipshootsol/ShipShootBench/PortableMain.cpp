@@ -0,0 +1,61 @@
+#include <string>
+#include <cstdio>
+
+#include "Bench.h"
+#include "CoreBench.h"
+
+using namespace std;
+using namespace DirectX::SimpleMath;
+
+//the game's tick rate, Game.h can't be included without D3D
+static const float DT = 1.f / 60;
+
+//look for a switch, optionally grab the word after it
+static bool GetArg(int argc, char* argv[], const string& name, string* pValue = nullptr)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (name != argv[i])
+			continue;
+		if (pValue && i + 1 >= argc)
+			return false;
+		if (pValue)
+			*pValue = argv[i + 1];
+		return true;
+	}
+	return false;
+}
+
+/*
+ShipShootBenchPortable [-out bench.json] [-label text] [-filter name] [-quick]
+The benchmarks in CoreBench built without D3D or FMOD, see CMakeLists.txt.
+Nothing is loaded, the sizes are the game's own written in: the enemy
+texture at half size and a player bullet rotated like ShipShootBench
+works it out. -out is relative to wherever it's run from.
+*/
+int main(int argc, char* argv[])
+{
+	string outFile = "bench.json", label, filter;
+	GetArg(argc, argv, "-out", &outFile);
+	GetArg(argc, argv, "-label", &label);
+	GetArg(argc, argv, "-filter", &filter);
+	//"-quick" for a rough idea in a few seconds
+	BenchSuite suite(GetArg(argc, argv, "-quick") ? 10 : 100);
+	suite.SetFilter(filter);
+	suite.AddSize("RenderProxy", sizeof(RenderProxy));
+
+	RenderProxy enemyProto;
+	enemyProto.size = Vector2(124, 108);		//shipYellow_manned.dds
+	enemyProto.scale = Vector2(0.5f, 0.5f);
+	//missile.dds is 220x48 at 0.75, 4 frames across
+	Vector2 bulletSize(48 * 0.75f, 220 * 0.75f / 4);
+	RunCoreBenches(suite, enemyProto, bulletSize, DT);
+
+	if (!suite.WriteJson(outFile, label))
+	{
+		printf("Cannot write %s\n", outFile.c_str());
+		return 1;
+	}
+	printf("%zu results in %s\n", suite.GetResults().size(), outFile.c_str());
+	return 0;
+}
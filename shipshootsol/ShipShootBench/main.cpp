@@ -0,0 +1,270 @@
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+
+#include "Bench.h"
+#include "CoreBench.h"
+#include "WindowUtils.h"
+#include "Game.h"
+#include "AudioMgrOffline.h"
+
+using namespace std;
+using namespace DirectX;
+using namespace DirectX::SimpleMath;
+
+//every benchmark steps the simulation by one game tick
+static const float DT = 1.f / Game::TICK_HZ;
+//entity counts each benchmark is run with
+static const int COUNTS[]{ 10, 100, 1000 };
+//results go here so the optimiser can't throw the work away
+static volatile int sink;
+
+//the mixer still runs, the result goes nowhere
+class NullSink : public IAudioSink
+{
+public:
+	bool Open(const unsigned int rate, const unsigned int numChannels) override { return true; }
+	double Write(const int16_t* pSamples, const unsigned int numFrames, const uint64_t bufferIdx, const double mixedSec) override { return mixedSec; }
+	void Close() override {}
+};
+
+/*
+Fills a PlayMode with however many of each thing a benchmark asks for
+and calls the private parts of its tick one at a time, it's a friend.
+Everything is placed so nothing collides unless the benchmark wants it
+to, so the counts stay put for a whole batch.
+*/
+class PlayModeBench
+{
+public:
+	PlayModeBench(MyD3D& d3d, shared_ptr<SpriteFont> font, IAudioMgr& audio)
+		: mPM(d3d, font, &audio, mInput, mRandom)
+	{
+	}
+	~PlayModeBench()
+	{
+		SetEnemies(0);
+	}
+	//a formation along the top ten or more wide, squashed up if there are lots
+	void SetEnemies(int n)
+	{
+		mPM.mEnemies.clear();
+		int numCols = max(10, n / 25);
+		int numRows = (n + numCols - 1) / numCols;
+		Vector2 gap(min(40.f, 500.f / numCols), numRows > 5 ? 200.f / numRows : 40.f);
+		mPM.mFormation.Init(mPM.mEnemyProto, Vector2(100, 50), gap, numCols, numRows);
+		for (int slot = n; slot < mPM.mFormation.GetNumSlots(); ++slot)
+			mPM.mFormation.Kill(slot);
+		mPM.mShooters.Reset(mPM.mFormation, 0);
+		mPM.mFormation.SetSpeed(mPM.ENEMY_SPEED);
+		//no boss turning up and no enemy firing unless the benchmark says so
+		mPM.mBossTimer = 1e6f;
+		mPM.mEnemyBulletTimer = 1e6f;
+	}
+	//player bullets along the bottom, enemy bullets across the middle
+	void SetBullets(int numPlayer, int numEnemy)
+	{
+		mPM.mPlayerBullets.clear();
+		mPM.mEnemyBullets.clear();
+		for (int i = 0; i < numPlayer; ++i)
+			mPM.mPlayerBullets.emplace_back(Vector2(20.f + (i % 60) * 11, 680.f), -1);
+		for (int i = 0; i < numEnemy; ++i)
+			mPM.mEnemyBullets.emplace_back(Vector2(20.f + (i % 60) * 11, 300.f), 1);
+		mPM.mRespawnTimer = 0;
+		mPM.mLives = 3;
+	}
+	void SetShields()
+	{
+		mPM.InitShields();
+	}
+	Shield& GetShield() { return mPM.mShields.front(); }
+	const RenderProxy& GetEnemyProto() const { return mPM.mEnemyProto; }
+	std::vector<Bullet>& GetPlayerBullets() { return mPM.mPlayerBullets; }
+
+	void UpdateEnemies() { mPM.UpdateEnemies(DT); }
+	//who'd fire next, without firing
+	int PickShooter() { return mPM.mpFirePattern->Pick(mPM.mShooters, mPM.mRandom); }
+	void UpdateBullets() { mPM.UpdateBullets(DT); }
+	void CollidePlayerBullets() { mPM.CollidePlayerBullets(); }
+	void CollideEnemyBullets() { mPM.CollideEnemyBullets(); }
+	void CollideShields() { mPM.CollideShields(); }
+	//the whole tick, events and all
+	void Update() { mPM.Update(Game::TICK_NS); }
+	//so every batch of a full tick plays out the same
+	void SeedRandom(uint64_t seed) { mRandom.Seed(seed); }
+	//the offline mixer never runs here, so nothing finishes playing by itself
+	void StopSounds() { mPM.mAudio->GetSfxMgr()->Stop(); }
+private:
+	InputQueue mInput;		//nobody presses anything
+	Random mRandom;
+	PlayMode mPM;
+};
+
+//gameplay, one PlayMode reused for everything
+static void BenchPlayMode(BenchSuite& suite, PlayModeBench& pm)
+{
+	for (int n : COUNTS)
+	{
+		suite.Run("enemy_update", n, [&]() { pm.SetEnemies(n); }, [&]() { pm.UpdateEnemies(); });
+		suite.Run("shooter_pick", n, [&]() { pm.SetEnemies(n); }, [&]() { sink = pm.PickShooter(); });
+		suite.Run("bullet_update", n, [&]() { pm.SetEnemies(0); pm.SetBullets(n, n); }, [&]() { pm.UpdateBullets(); });
+		//the collision passes with n of everything
+		suite.Run("collide_player_bullets", n, [&]() { pm.SetEnemies(n); pm.SetBullets(n, n); }, [&]() { pm.CollidePlayerBullets(); });
+		suite.Run("collide_enemy_bullets", n, [&]() { pm.SetBullets(0, n); }, [&]() { pm.CollideEnemyBullets(); });
+		suite.Run("collide_shields", n, [&]() { pm.SetShields(); pm.SetBullets(n, n); }, [&]() { pm.CollideShields(); });
+		suite.Run("shield_check", n, [&]() { pm.SetShields(); pm.SetBullets(n, 0); }, [&]() {
+			Shield& shield = pm.GetShield();
+			for (Bullet& b : pm.GetPlayerBullets())
+				shield.CheckCollision(b);
+		});
+		//animated bullets change frame every update
+		suite.Run("animate_update", n, [&]() { pm.SetBullets(n, 0); }, [&]() {
+			for (Bullet& b : pm.GetPlayerBullets())
+				b.anim.Update(b.bullet, 1.f);
+		});
+		//everything at once, collisions and all, the same game every batch
+		suite.Run("playmode_tick", n, [&]() {
+			pm.SeedRandom(1);
+			pm.StopSounds();
+			pm.SetShields();
+			pm.SetEnemies(n);
+			pm.SetBullets(n, n);
+		}, [&]() { pm.Update(); });
+	}
+	pm.SetEnemies(0);
+	pm.SetBullets(0, 0);
+}
+
+//a cache of n textures, found by name and by handle
+static void BenchTexCache(BenchSuite& suite, MyD3D& d3d)
+{
+	if (!suite.Wants("texcache"))
+		return;
+	for (int n : COUNTS)
+	{
+		TexCache cache;
+		cache.SetAssetPath("data/");
+		vector<string> names;
+		vector<ID3D11ShaderResourceView*> handles;
+		for (int i = 0; i < n; ++i)
+		{
+			names.push_back("bench" + to_string(i));
+			handles.push_back(cache.LoadTexture(&d3d.GetDevice(), "shield.dds", names.back()));
+		}
+		auto none = []() {};
+		suite.Run("texcache_get_name", n, none, [&]() {
+			for (const string& name : names)
+				cache.Get(name);
+		});
+		suite.Run("texcache_get_handle", n, none, [&]() {
+			for (ID3D11ShaderResourceView* p : handles)
+				cache.Get(p);
+		});
+		cache.Release();
+	}
+}
+
+//finding sounds by name, what the game does when anything plays
+static void BenchAudio(BenchSuite& suite, IAudioMgr& audio)
+{
+	const char* names[]{ "laser", "bang", "nothing" };
+	for (int n : COUNTS)
+	{
+		suite.Run("audio_name_lookup", n, []() {}, [&]() {
+			int idx;
+			for (int i = 0; i < n; ++i)
+				audio.GetSfxMgr()->Exists(names[i % 3], &idx);
+		});
+	}
+}
+
+static LRESULT CALLBACK BenchWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+	return WinUtil::DefaultMssgHandler(hwnd, msg, wParam, lParam);
+}
+
+static void OnResize(int screenWidth, int screenHeight, MyD3D& d3d)
+{
+	d3d.OnResize_Default(screenWidth, screenHeight);
+}
+
+//look for a switch, optionally grab the word after it
+static bool GetArg(int argc, char* argv[], const string& name, string* pValue = nullptr)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (name != argv[i])
+			continue;
+		if (pValue && i + 1 >= argc)
+			return false;
+		if (pValue)
+			*pValue = argv[i + 1];
+		return true;
+	}
+	return false;
+}
+
+/*
+ShipShootBench [-out bench.json] [-label text] [-filter name] [-quick]
+Runs from anywhere, it moves to the folder it's in (bin) to find the game's
+data, so -out is relative to bin too. Rendering is on the cpu (WARP) with a
+hidden window, nothing is shown.
+*/
+int main(int argc, char* argv[])
+{
+	char exePath[MAX_PATH];
+	if (GetModuleFileName(nullptr, exePath, MAX_PATH))
+	{
+		string dir(exePath);
+		dir = dir.substr(0, dir.find_last_of("\\/"));
+		SetCurrentDirectory(dir.c_str());
+	}
+	string outFile = "bench.json", label, filter;
+	GetArg(argc, argv, "-out", &outFile);
+	GetArg(argc, argv, "-label", &label);
+	GetArg(argc, argv, "-filter", &filter);
+	//"-quick" for a rough idea in a few seconds
+	BenchSuite suite(GetArg(argc, argv, "-quick") ? 10 : 100);
+	suite.SetFilter(filter);
+	//what gameplay objects cost to copy and keep in a vector
+	suite.AddSize("Sprite", sizeof(Sprite));
+	suite.AddSize("RenderProxy", sizeof(RenderProxy));
+	suite.AddSize("Bullet", sizeof(Bullet));
+	suite.AddSize("Enemy", sizeof(Enemy));
+
+	if (!WinUtil::Get().InitMainWindow(700, 700, GetModuleHandle(nullptr), "ShipShootBench", BenchWndProc, true))
+		return 1;
+	WinUtil::Get().SetNeverPause(true);
+	ShowWindow(WinUtil::Get().GetMainWnd(), SW_HIDE);
+	MyD3D d3d;
+	if (!d3d.InitDirect3D(OnResize, true))
+		return 1;
+	WinUtil::Get().SetD3D(d3d);
+	d3d.GetCache().SetAssetPath("data/");
+	File::initialiseSystem();
+	AudioMgrOffline audio(make_shared<NullSink>(), DT);
+	if (!audio.Initialise())
+		return 1;
+
+	{
+		PlayModeBench pm(d3d, make_shared<SpriteFont>(&d3d.GetDevice(), L"data/fonts/comic.spritefont"), audio);
+		BenchPlayMode(suite, pm);
+		Vector2 bulletSize = Bullet::proto.GetScreenSize();
+		bulletSize = Vector2(bulletSize.y, bulletSize.x / 4);	//rotated 4 frame animation, like the game
+		RunCoreBenches(suite, pm.GetEnemyProto(), bulletSize, DT);
+	}
+	BenchTexCache(suite, d3d);
+	BenchAudio(suite, audio);
+
+	audio.Shutdown();
+	d3d.ReleaseD3D(true);
+	if (!suite.WriteJson(outFile, label))
+	{
+		printf("Cannot write %s\n", outFile.c_str());
+		return 1;
+	}
+	printf("%zu results in %s\n", suite.GetResults().size(), outFile.c_str());
+	return 0;
+}
@@ -0,0 +1,103 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "Check.h"
+#include "AllocTracker.h"
+#include "InputSource.h"
+
+/*
+What -allocgate -bot relies on, without the game around it: the bot's
+input reaches the queue without allocating once it's going, another
+thread's allocations don't count against the frame and a frame that
+isn't steady is dropped, allocations and all.
+*/
+
+static const int TICK_HZ = 60;
+static const int64_t TICK_NS = Clock::NS_PER_SEC / TICK_HZ;
+
+//the keys main.cpp's BotPlayer taps, as often
+static void Bot(ScriptedInputSource& src, uint64_t tick)
+{
+	if (tick == 1)
+	{
+		src.Tap(1, 'B');
+		src.Tap(3, 'O');
+		src.Tap(5, 'T');
+	}
+	if (tick % 240 == 10)
+		src.Tap(tick, 0x0d, 2);
+	if (tick % 30 == 0)
+		src.Tap(tick, ' ', 2);
+	if (tick % 120 == 0)
+		src.Tap(tick, (tick / 120) % 2 ? 0x25 : 0x27, 100);
+}
+
+int main()
+{
+	ScriptedInputSource bot(TICK_HZ);
+	bot.SetBot(Bot);
+	InputQueue input;
+	bot.Start(0);
+	AllocTracker& allocs = AllocTracker::Get();
+	const uint64_t WARMUP = 240, FRAMES = 600, UNSTEADY = 500;
+
+	//one tick a frame like a -bot run
+	uint64_t tick = 0;
+	auto step = [&]() {
+		++tick;
+		bot.Poll(input, tick * TICK_NS);
+		input.ConsumeUntil(tick * TICK_NS);
+	};
+	while (tick < WARMUP)
+	{
+		step();
+		allocs.EndFrame();
+	}
+
+	//started before capturing, starting a thread allocates on the one starting it
+	std::atomic<bool> go{ false };
+	std::thread other([&]() {
+		while (!go)
+			std::this_thread::yield();
+		delete new std::vector<int>(100);
+		go = false;
+	});
+	std::vector<int>* pSetup = nullptr;
+	uint64_t numPressed = 0;
+	allocs.StartCapture();
+	while (tick < WARMUP + FRAMES)
+	{
+		step();
+		numPressed += input.WasPressed(' ');
+		if (tick == WARMUP + 50)
+		{
+			go = true;
+			while (go)
+				std::this_thread::yield();
+		}
+		//what a frame that changes mode looks like
+		bool steady = tick != UNSTEADY;
+		if (!steady)
+			pSetup = new std::vector<int>(10);
+		allocs.EndFrame(steady);
+	}
+	allocs.StopCapture();
+	other.join();
+	CHECK(numPressed == FRAMES / 30);
+	CHECK(allocs.GetNumCapturedFrames() == FRAMES - 1);
+	CHECK(allocs.GetNumAllocatingFrames() == 0);
+	CHECK(allocs.GetNumCaptured() == 0);
+
+	//and a steady frame that does allocate is caught, two for a new vector with something in it
+	allocs.StartCapture();
+	delete pSetup;
+	pSetup = new std::vector<int>(1);
+	allocs.EndFrame();
+	allocs.StopCapture();
+	CHECK(allocs.GetNumCapturedFrames() == 1);
+	CHECK(allocs.GetNumAllocatingFrames() == 1);
+	CHECK(allocs.GetNumCaptured() == 2);
+	delete pSetup;
+	return CheckResult("AllocGateTests");
+}
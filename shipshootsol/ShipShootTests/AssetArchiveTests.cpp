@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Check.h"
+#include "AssetArchive.h"
+#include "Random.h"
+
+/*
+A folder of made up assets packed, opened and every file found again
+however its path is spelt, byte for byte and aligned, plus List and the
+files that shouldn't be in there. Then a cut short archive, which must
+not open.
+*/
+
+namespace fs = std::filesystem;
+
+static const char* FOLDER = "archive_test";
+static const char* ARCHIVE = "archive_test.pak";
+
+struct Asset
+{
+	std::string path;		//as written to disk
+	std::vector<uint8_t> bytes;
+};
+
+static void WriteBytes(const std::string& fileName, const std::vector<uint8_t>& bytes)
+{
+	std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+	out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+//the other way up from the disk, "archive_test/Sub/x.dds" -> "ARCHIVE_TEST\\sUB\\X.DDS"
+static std::string Respell(const std::string& path)
+{
+	std::string s;
+	for (char c : path)
+	{
+		if (c == '/')
+			s += '\\';
+		else if (c >= 'a' && c <= 'z')
+			s += c - 'a' + 'A';
+		else if (c >= 'A' && c <= 'Z')
+			s += c - 'A' + 'a';
+		else
+			s += c;
+	}
+	return s;
+}
+
+int main()
+{
+	std::error_code ec;
+	fs::remove_all(FOLDER, ec);
+	fs::create_directories(std::string(FOLDER) + "/Sub", ec);
+
+	//sizes from empty up past a page, none a multiple of the alignment on purpose
+	Random random(5);
+	std::vector<Asset> assets;
+	for (int i = 0; i < 200; ++i)
+	{
+		Asset asset;
+		const char* ext = i % 3 == 0 ? ".wav" : i % 3 == 1 ? ".dds" : ".DDS";
+		asset.path = std::string(FOLDER) + (i % 4 == 0 ? "/Sub/" : "/") + "Asset" + std::to_string(i) + ext;
+		asset.bytes.resize(i == 0 ? 0 : random.Below(5000));
+		for (uint8_t& b : asset.bytes)
+			b = static_cast<uint8_t>(random.Below(256));
+		WriteBytes(asset.path, asset.bytes);
+		assets.push_back(asset);
+	}
+	WriteBytes(std::string(FOLDER) + "/notes.txt", { 'n', 'o' });
+
+	size_t numFiles = 0;
+	CHECK(AssetArchive::Pack({ FOLDER, "no_such_folder" }, { ".dds", ".wav" }, ARCHIVE, &numFiles));
+	CHECK(numFiles == assets.size());
+	AssetArchive& archive = AssetArchive::Get();
+	CHECK(archive.Open(ARCHIVE));
+	CHECK(archive.GetNumFiles() == assets.size());
+
+	int numMissing = 0, numWrong = 0, numUnaligned = 0;
+	for (const Asset& asset : assets)
+	{
+		for (const std::string& path : { asset.path, Respell(asset.path), "./" + asset.path })
+		{
+			AssetArchive::Slice slice = archive.Find(path);
+			if (!slice)
+			{
+				++numMissing;
+				continue;
+			}
+			numWrong += slice.size != asset.bytes.size() || memcmp(slice.pData, asset.bytes.data(), slice.size) != 0;
+			numUnaligned += reinterpret_cast<uintptr_t>(slice.pData) % 16 != 0;
+		}
+	}
+	CHECK(numMissing == 0);
+	CHECK(numWrong == 0);
+	CHECK(numUnaligned == 0);
+	CHECK(!archive.Find(std::string(FOLDER) + "/notes.txt"));
+	CHECK(!archive.Find(std::string(FOLDER) + "/Asset1.wav"));
+	CHECK(!archive.Find(""));
+
+	//only the top folder, in the order they were packed (sorted by path on disk)
+	std::vector<std::string> listed, expected;
+	archive.List(std::string(FOLDER) + "\\", ".WAV", listed);
+	std::vector<std::string> sorted;
+	for (const Asset& asset : assets)
+		if (asset.path.find("/Sub/") == std::string::npos && asset.path.compare(asset.path.size() - 4, 4, ".wav") == 0)
+			sorted.push_back(asset.path);
+	std::sort(sorted.begin(), sorted.end());
+	for (const std::string& path : sorted)
+		expected.push_back(AssetArchive::Normalise(path));
+	CHECK(listed == expected);
+	archive.List(std::string(FOLDER) + "/sub", ".dds", listed);
+	CHECK(listed.size() == 33);
+	archive.Close();
+	CHECK(!archive.Find(assets[1].path));
+
+	//cut off partway through the index
+	{
+		std::ifstream in(ARCHIVE, std::ios::binary);
+		std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		in.close();
+		bytes.resize(100);
+		WriteBytes(ARCHIVE, bytes);
+	}
+	CHECK(!archive.Open(ARCHIVE));
+	CHECK(!archive.IsOpen());
+	CHECK(!archive.Open("no_such_archive.pak"));
+
+	fs::remove_all(FOLDER, ec);
+	fs::remove(ARCHIVE, ec);
+	return CheckResult("AssetArchiveTests");
+}
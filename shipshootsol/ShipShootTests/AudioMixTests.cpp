@@ -0,0 +1,135 @@
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Check.h"
+#include "AudioMix.h"
+#include "Random.h"
+
+using namespace AudioMix;
+
+/*
+Every kernel under every isa the cpu has, against the plain C++ one,
+bit for bit: lengths that leave a tail after the last full vector,
+buffers that start off a 16 byte boundary and samples well past full
+scale so the clipping is tested too.
+*/
+
+//noise from -range to range
+static std::vector<float> Noise(Random& random, size_t n, float range)
+{
+	std::vector<float> v(n);
+	for (float& f : v)
+		f = (random.Float01() * 2 - 1) * range;
+	return v;
+}
+
+static bool Same(const std::vector<float>& a, const std::vector<float>& b)
+{
+	return a.size() == b.size() && memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+//everything one isa makes from the same input, kept so it can be compared with scalar
+struct Outputs
+{
+	std::vector<std::vector<float>> floats;
+	std::vector<std::vector<int16_t>> ints;
+	std::vector<double> positions;
+};
+
+static Outputs RunAll(Isa isa, uint64_t seed)
+{
+	SetIsa(isa);
+	Random random(seed);
+	Outputs out;
+	//odd lengths either side of the 4 and 8 wide loops, plus one long one
+	std::vector<unsigned int> lengths;
+	for (unsigned int n = 0; n <= 37; ++n)
+		lengths.push_back(n);
+	lengths.push_back(1021);
+	for (unsigned int n : lengths)
+		for (unsigned int offset = 0; offset < 4; ++offset)
+		{
+			//offset floats in, so the data isn't where the allocator lined it up
+			std::vector<float> bus = Noise(random, n * 2 + offset, 1);
+			std::vector<float> mono = Noise(random, n + offset, 1);
+			std::vector<float> stereo = Noise(random, n * 2 + offset, 1);
+			float left = random.Float01(), right = random.Float01();
+			ApplyGain(bus.data() + offset, n * 2, 0.7f);
+			//the bus is always even, the mono sound gives gain its odd tails
+			ApplyGain(mono.data() + offset, n, 1.3f);
+			out.floats.push_back(mono);
+			MixMonoToStereo(bus.data() + offset, mono.data() + offset, n, left, right);
+			MixStereoToStereo(bus.data() + offset, stereo.data() + offset, n, right, left);
+			out.floats.push_back(bus);
+
+			//clipping, exactly full scale and halfway between two int16s
+			std::vector<float> loud = Noise(random, n + offset, 3);
+			for (unsigned int i = offset; i < loud.size(); i += 5)
+				loud[i] = i % 2 ? 1.f : -1.f;
+			for (unsigned int i = offset + 2; i < loud.size(); i += 7)
+				loud[i] = (static_cast<int>(random.Below(2000)) - 1000 + 0.5f) / 32767.f;
+			std::vector<int16_t> ints(n + offset, 0);
+			FloatToInt16(loud.data() + offset, ints.data() + offset, n);
+			out.ints.push_back(ints);
+			std::vector<float> back(n + offset, 0);
+			Int16ToFloat(ints.data() + offset, back.data() + offset, n);
+			out.floats.push_back(back);
+
+			//up, down and a step that doesn't land on whole samples
+			for (double step : { 0.37, 1.0, 1.7 })
+			{
+				double pos = random.Float01();
+				std::vector<float> resampled(n + offset, 0);
+				unsigned int written = ResampleLinear(mono.data() + offset, n, pos, step, resampled.data() + offset, n);
+				resampled.resize(offset + written);
+				out.floats.push_back(resampled);
+				out.positions.push_back(pos);
+			}
+		}
+
+	//the polyphase dot both ways, on a length that doesn't divide into its taps
+	std::vector<float> sound = Noise(random, 4099, 1);
+	for (auto rates : { std::make_pair(22050u, 48000u), std::make_pair(48000u, 22050u), std::make_pair(44100u, 48000u) })
+	{
+		PolyphaseResampler resampler(rates.first, rates.second);
+		std::vector<float> mono, stereo;
+		resampler.Process(sound.data(), static_cast<unsigned int>(sound.size()), mono);
+		resampler.Process(sound.data(), static_cast<unsigned int>(sound.size() / 2), 2, stereo);
+		out.floats.push_back(mono);
+		out.floats.push_back(stereo);
+	}
+	return out;
+}
+
+int main()
+{
+	Isa best = GetBestIsa();
+	Outputs scalar = RunAll(Isa::SCALAR, 9);
+	//what the scalar clip gives for the extremes, so scalar itself is checked as well
+	{
+		const float extremes[] = { 2.f, -2.f, 1.f, -1.f, 0.f, 1e9f, -1e9f };
+		int16_t got[7];
+		FloatToInt16(extremes, got, 7);
+		CHECK(got[0] == 32767 && got[1] == -32767 && got[2] == 32767 && got[3] == -32767);
+		CHECK(got[4] == 0 && got[5] == 32767 && got[6] == -32767);
+	}
+	for (Isa isa : { Isa::SSE2, Isa::AVX2 })
+	{
+		if (static_cast<int>(isa) > static_cast<int>(best))
+			break;
+		Outputs vec = RunAll(isa, 9);
+		CHECK(GetIsa() == isa);
+		int numDiffer = 0;
+		for (size_t i = 0; i < scalar.floats.size(); ++i)
+			numDiffer += !Same(vec.floats[i], scalar.floats[i]);
+		for (size_t i = 0; i < scalar.ints.size(); ++i)
+			numDiffer += vec.ints[i] != scalar.ints[i];
+		numDiffer += vec.positions != scalar.positions;
+		printf("%s: %d of %zu outputs differ from scalar\n", GetIsaName(isa), numDiffer,
+			scalar.floats.size() + scalar.ints.size() + 1);
+		CHECK(numDiffer == 0);
+	}
+	printf("best isa %s\n", GetIsaName(best));
+	return CheckResult("AudioMixTests");
+}
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include "Check.h"
+#include "AudioSink.h"
+#include "Random.h"
+
+/*
+The latency check fed by a stand-in for the offline mixer, ticks that
+aren't a whole number of frames and sounds landing anywhere in a buffer.
+Done right every measurement passes, a mixer that stalls gets an
+underrun and still passes, and mixers that tell the probe the wrong
+thing are caught. Then the wav a WavFileSink leaves behind.
+*/
+
+static const unsigned int RATE = 22050;
+static const float TICK_SEC = 1 / 60.f;	//367.5 frames, so buffers alternate 367 and 368
+static const unsigned int QUEUED = 3;
+
+//what the mixer hands the probe once a buffer has gone to the sink
+enum class Tell { SINK, MIXED, PREVIOUS };
+
+//passes measurements on to the check and keeps how late each one was
+class Latencies : public AudioLatencyProbe::IListener
+{
+public:
+	explicit Latencies(LatencyCheckSink& check) : mCheck(check) {}
+	void OnLatency(const AudioLatencyProbe::Record& rec)
+	{
+		mCheck.OnLatency(rec);
+		mWorstLate = (std::max)(mWorstLate, rec.audibleSec - rec.pickupSec);
+	}
+	double mWorstLate = 0;
+private:
+	LatencyCheckSink& mCheck;
+};
+
+//numTicks of a few sounds a tick, the mixer falls stallTicks behind at tick 100
+static void Run(LatencyCheckSink& check, Latencies& latencies, Tell tell, int numTicks, int stallTicks = 0)
+{
+	AudioLatencyProbe probe;
+	probe.SetListener(&latencies);
+	CHECK(check.Open(RATE, 2));
+	Random random(17);
+	std::vector<int16_t> pcm;
+	uint64_t framesRendered = 0;
+	double stallSec = 0, lastAudibleSec = 0;
+	unsigned int nextHandle = 0;
+	for (uint64_t bufferIdx = 0; bufferIdx < static_cast<uint64_t>(numTicks); ++bufferIdx)
+	{
+		uint64_t endFrame = static_cast<uint64_t>((bufferIdx + 1) * (double)TICK_SEC * RATE + 0.5);
+		unsigned int numFrames = static_cast<unsigned int>(endFrame - framesRendered);
+		if (bufferIdx == 100)
+			stallSec = stallTicks * TICK_SEC;
+		double bufferSec = framesRendered / (double)RATE + stallSec;
+		//played since the last tick, picked up somewhere in this buffer
+		for (int i = random.Below(4); i > 0; --i)
+		{
+			unsigned int handle = nextHandle++;
+			probe.OnTrigger(handle, 0, bufferSec - random.Float01() * TICK_SEC);
+			probe.OnPickup(handle, bufferSec, bufferIdx, random.Below(numFrames));
+		}
+		pcm.assign(numFrames * 2, 0);
+		double audibleSec = check.Write(pcm.data(), numFrames, bufferIdx, bufferSec);
+		double toldSec = tell == Tell::SINK ? audibleSec : tell == Tell::MIXED ? bufferSec : lastAudibleSec;
+		probe.OnBufferOut(bufferIdx, toldSec, 1.0 / RATE);
+		lastAudibleSec = audibleSec;
+		framesRendered = endFrame;
+	}
+	check.Close();
+	CHECK(probe.GetNumMeasured() == check.GetNumChecked());
+	CHECK(probe.GetNumDropped() == 0);
+}
+
+static std::vector<uint8_t> ReadBytes(const std::string& fileName)
+{
+	std::ifstream in(fileName, std::ios::binary);
+	return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+int main()
+{
+	const int NUM_TICKS = 3000;
+	//a buffer is 16.7ms, a sound at its very end waits for nearly all of it on top of the 3 in front
+	const double MOST_LATE = (QUEUED + 1) * 368.0 / RATE;
+	{
+		LatencyCheckSink check(QUEUED);
+		Latencies latencies(check);
+		Run(check, latencies, Tell::SINK, NUM_TICKS);
+		CHECK(check.GetNumChecked() > NUM_TICKS);
+		CHECK(check.GetNumFailed() == 0);
+		CHECK(check.GetWorstErrorSec() < 1e-6);
+		CHECK(check.GetNumUnderruns() == 0);
+		CHECK(latencies.mWorstLate > QUEUED * 367.0 / RATE && latencies.mWorstLate < MOST_LATE);
+	}
+
+	//5 ticks behind runs the 3 queued dry, once
+	{
+		LatencyCheckSink check(QUEUED);
+		Latencies latencies(check);
+		Run(check, latencies, Tell::SINK, NUM_TICKS, 5);
+		CHECK(check.GetNumUnderruns() == 1);
+		CHECK(check.GetNumFailed() == 0);
+		CHECK(latencies.mWorstLate < MOST_LATE);
+	}
+	//and 2 behind doesn't, there was enough queued to cover it
+	{
+		LatencyCheckSink check(QUEUED);
+		Latencies latencies(check);
+		Run(check, latencies, Tell::SINK, NUM_TICKS, 2);
+		CHECK(check.GetNumUnderruns() == 0);
+		CHECK(check.GetNumFailed() == 0);
+	}
+
+	//told when it was mixed, or when the buffer before it will be heard
+	for (Tell tell : { Tell::MIXED, Tell::PREVIOUS })
+	{
+		LatencyCheckSink check(QUEUED);
+		Latencies latencies(check);
+		Run(check, latencies, tell, 200);
+		CHECK(check.GetNumChecked() > 0 && check.GetNumFailed() == check.GetNumChecked());
+		CHECK(check.GetWorstErrorSec() > 0.01);
+	}
+
+	//passed on to the next sink, the wav has the right header and everything written
+	{
+		const std::string fileName = "audio_sink_test.wav";
+		auto wav = std::make_shared<WavFileSink>(fileName);
+		LatencyCheckSink check(QUEUED, wav);
+		Latencies latencies(check);
+		Run(check, latencies, Tell::SINK, 60);
+		std::vector<uint8_t> bytes = ReadBytes(fileName);
+		const uint32_t dataBytes = 22050 * 2 * sizeof(int16_t);		//60 ticks is a second
+		uint32_t riffBytes = 0, rate = 0, fileDataBytes = 0;
+		uint16_t numChannels = 0;
+		CHECK(bytes.size() == 44 + dataBytes);
+		if (bytes.size() >= 44)
+		{
+			memcpy(&riffBytes, &bytes[4], 4);
+			memcpy(&numChannels, &bytes[22], 2);
+			memcpy(&rate, &bytes[24], 4);
+			memcpy(&fileDataBytes, &bytes[40], 4);
+		}
+		CHECK(memcmp(bytes.data(), "RIFF", 4) == 0 && memcmp(&bytes[8], "WAVEfmt ", 8) == 0);
+		CHECK(riffBytes == 36 + dataBytes);
+		CHECK(numChannels == 2 && rate == RATE);
+		CHECK(fileDataBytes == dataBytes);
+		remove(fileName.c_str());
+	}
+	return CheckResult("AudioSinkTests");
+}
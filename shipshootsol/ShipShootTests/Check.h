@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdio>
+
+/*
+Just enough for the portable tests (see CMakeLists.txt) without a
+framework to install. CHECK carries on after a failure so one run
+shows everything that's wrong, a test's main returns CheckResult().
+*/
+inline int& CheckFailures()
+{
+	static int numFailed = 0;
+	return numFailed;
+}
+
+#define CHECK(cond) ((cond) ? (void)0 : (void)(fprintf(stderr, "%s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #cond), ++CheckFailures()))
+
+//0 if every CHECK passed
+inline int CheckResult(const char* name)
+{
+	if (CheckFailures())
+		printf("%s: %d FAILED\n", name, CheckFailures());
+	else
+		printf("%s: passed\n", name);
+	return CheckFailures() ? 1 : 0;
+}
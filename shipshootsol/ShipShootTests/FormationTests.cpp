@@ -0,0 +1,108 @@
+#include <cmath>
+
+#include "Check.h"
+#include "Formation.h"
+#include "Random.h"
+
+using namespace DirectX::SimpleMath;
+
+/*
+The bitboard HitTest and GetFront against plain scans of every slot, on
+layouts from the game's up to the full 64 rows, with enemies being shot
+and the block moving between boxes. Spacing smaller than an enemy (so
+neighbours overlap) is in there too, that's where picking the right one
+of several matters. Some boxes are put a float's width either side of
+an enemy's edges, where the range HitTest searches is easiest to get
+wrong.
+*/
+
+//every alive slot from the back, what CollidePlayerBullets did before the bitboard
+static int ScanHitTest(const Formation& formation, const Vector2& pos, const Vector2& size)
+{
+	Vector2 enemySize = formation.GetEnemySize();
+	for (int slot = formation.GetNumSlots() - 1; slot >= 0; --slot)
+	{
+		if (!formation.IsAlive(slot))
+			continue;
+		Vector2 enemyPos = formation.GetPos(slot);
+		if (pos.x < enemyPos.x + enemySize.x &&
+			pos.x + size.x > enemyPos.x &&
+			pos.y < enemyPos.y + enemySize.y &&
+			pos.y + size.y > enemyPos.y)
+			return slot;
+	}
+	return -1;
+}
+
+static int ScanFront(const Formation& formation, int col, int numRows)
+{
+	for (int row = numRows - 1; row >= 0; --row)
+	{
+		int slot = row * formation.GetNumCols() + col;
+		if (formation.IsAlive(slot))
+			return slot;
+	}
+	return -1;
+}
+
+int main()
+{
+	struct Layout { int numCols, numRows; float gapX, gapY; };
+	const Layout layouts[]{ { 6, 5, 70, 40 }, { 11, 5, 40, 30 }, { 10, 64, 40, 3 }, { 40, 25, 12.5f, 8 }, { 1, 1, 5, 5 }, { 64, 64, 70, 40 } };
+	Random random(3);
+	RenderProxy proto;
+	proto.size = Vector2(124, 108);
+	proto.scale = Vector2(0.5f, 0.5f);
+	const RECTF playArea{ 30, 0, 670, 700 };
+	int numTests = 0, numHits = 0, numWrong = 0, numWrongFront = 0;
+	for (const Layout& layout : layouts)
+		for (int rep = 0; rep < 20; ++rep)
+		{
+			Formation formation;
+			Vector2 origin(100 + random.Float01() * 50, 50 + random.Float01() * 50);
+			formation.Init(proto, origin, Vector2(layout.gapX, layout.gapY), layout.numCols, layout.numRows);
+			formation.SetSpeed(100);
+			for (int i = 0; i < 4000; ++i)
+			{
+				if (random.Below(20) == 0)
+				{
+					int slot = random.Below(formation.GetNumSlots());
+					if (formation.IsAlive(slot))
+						formation.Kill(slot);
+				}
+				if (random.Below(10) == 0)
+					formation.Update(random.Float01(), playArea);
+				//round the block and a bit past it, most miss
+				Vector2 area(layout.numCols * layout.gapX + 100, layout.numRows * layout.gapY + 100);
+				Vector2 pos(formation.GetPos(0).x - 50 + random.Float01() * area.x, formation.GetPos(0).y - 50 + random.Float01() * area.y);
+				Vector2 size(random.Float01() * 20, random.Float01() * 20);
+				if (random.Below(2) == 0)
+				{
+					//just touching, or just not, one of an enemy's four sides
+					Vector2 enemyPos = formation.GetPos(random.Below(formation.GetNumSlots()));
+					Vector2 enemySize = formation.GetEnemySize();
+					float nudge = random.Below(2) ? INFINITY : -INFINITY;
+					pos = enemyPos + Vector2(random.Float01() * enemySize.x, random.Float01() * enemySize.y);
+					switch (random.Below(4))
+					{
+					case 0: pos.x = std::nextafter(enemyPos.x - size.x, nudge); break;
+					case 1: pos.x = std::nextafter(enemyPos.x + enemySize.x, nudge); break;
+					case 2: pos.y = std::nextafter(enemyPos.y - size.y, nudge); break;
+					default: pos.y = std::nextafter(enemyPos.y + enemySize.y, nudge); break;
+					}
+				}
+				int slot = formation.HitTest(pos, size);
+				++numTests;
+				numHits += slot >= 0;
+				numWrong += slot != ScanHitTest(formation, pos, size);
+				for (int col = 0; col < layout.numCols; ++col)
+					numWrongFront += formation.GetFront(col) != ScanFront(formation, col, layout.numRows);
+			}
+		}
+	printf("%d boxes, %d hit\n", numTests, numHits);
+	CHECK(numWrong == 0);
+	CHECK(numWrongFront == 0);
+	//or it's only tested missing
+	CHECK(numHits > numTests / 10);
+	return CheckResult("FormationTests");
+}
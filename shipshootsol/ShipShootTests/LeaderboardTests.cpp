@@ -0,0 +1,276 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Check.h"
+#include "Leaderboard.h"
+#include "LeaderboardClient.h"
+#include "Random.h"
+#include "../LeaderboardServer/LeaderboardServer.h"
+
+/*
+What's left after a crash: a snapshot, the journal written since and
+maybe a torn or corrupted record at the end of it. Each case is loaded
+from copies of the files taken while the board was still open and
+checked against a plain list of every score added.
+Then equal scores on the server, spread over its shards and across a
+restart, still come back in the order they were submitted, and a
+client that loses its server can tell a score that never went from one
+that may have arrived.
+*/
+
+namespace fs = std::filesystem;
+
+static const char* FILE_NAME = "leaderboard_test.dat";
+static const char* CRASH_NAME = "leaderboard_crash.dat";
+
+//bit at a time, nothing shared with the table in Leaderboard.cpp
+static uint32_t ReferenceCrc32(const uint8_t* p, size_t numBytes)
+{
+	uint32_t crc = 0xFFFFFFFFu;
+	for (size_t i = 0; i < numBytes; ++i)
+	{
+		crc ^= p[i];
+		for (int bit = 0; bit < 8; ++bit)
+			crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+	}
+	return crc ^ 0xFFFFFFFFu;
+}
+
+static std::vector<uint8_t> ReadBytes(const std::string& fileName)
+{
+	std::ifstream in(fileName, std::ios::binary);
+	return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+static void WriteBytes(const std::string& fileName, const std::vector<uint8_t>& bytes)
+{
+	std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+	out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+static void RemoveFiles(const std::string& fileName)
+{
+	std::error_code ec;
+	for (const char* ext : { "", ".log", ".bad" })
+		fs::remove(fileName + ext, ec);
+}
+
+//where each journal record starts, they're uint16 length | entry | uint32 crc of the entry
+static std::vector<size_t> RecordOffsets(const std::vector<uint8_t>& journal)
+{
+	std::vector<size_t> offsets;
+	size_t at = 0;
+	while (at + 2 <= journal.size())
+	{
+		uint16_t len;
+		memcpy(&len, &journal[at], 2);
+		if (at + 2 + len + 4 > journal.size())
+			break;
+		offsets.push_back(at);
+		at += 2 + len + 4;
+	}
+	return offsets;
+}
+
+//the first numScores of scores, in the order they were added
+static bool Matches(const Leaderboard& board, const std::vector<int32_t>& scores, size_t numScores)
+{
+	if (board.GetNumEntries() != numScores)
+		return false;
+	std::vector<int32_t> sorted(scores.begin(), scores.begin() + numScores);
+	std::stable_sort(sorted.begin(), sorted.end(), std::greater<int32_t>());
+	size_t i = 0;
+	for (const Leaderboard::Entry& e : board.GetTop())
+		if (i >= sorted.size() || e.score != sorted[i++])
+			return false;
+	if (i != std::min<size_t>(sorted.size(), 10))
+		return false;
+	for (int32_t score : { -5, 0, 1, 250, 499, 500, 999, 1000, 5000 })
+	{
+		uint64_t rank = 1 + std::count_if(sorted.begin(), sorted.end(), [&](int32_t s) { return s > (std::max)(score, 0); });
+		if (board.GetRank(score) != rank)
+			return false;
+	}
+	return true;
+}
+
+//open the crash copies as if the game had just restarted
+static bool Reopen(Leaderboard& board, const std::vector<uint8_t>& snapshot, const std::vector<uint8_t>& journal)
+{
+	RemoveFiles(CRASH_NAME);
+	WriteBytes(CRASH_NAME, snapshot);
+	WriteBytes(std::string(CRASH_NAME) + ".log", journal);
+	return board.Open(CRASH_NAME);
+}
+
+int main()
+{
+	const uint8_t CHECK_VALUE[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+	CHECK(ReferenceCrc32(CHECK_VALUE, sizeof(CHECK_VALUE)) == 0xCBF43926u);
+
+	//half in the snapshot, half only in the journal
+	const size_t NUM_SCORES = 400;
+	RemoveFiles(FILE_NAME);
+	Random random(11);
+	std::vector<int32_t> scores;
+	std::vector<uint8_t> snapshot, journal;
+	{
+		Leaderboard board;
+		CHECK(board.Open(FILE_NAME));
+		for (size_t i = 0; i < NUM_SCORES; ++i)
+		{
+			scores.push_back(random.Below(1000));
+			CHECK(board.Add("P" + std::to_string(i), scores.back()));
+			if (i == NUM_SCORES / 2 - 1)
+				CHECK(board.Compact());
+		}
+		CHECK(board.GetNumJournalRecords() == NUM_SCORES / 2);
+		snapshot = ReadBytes(FILE_NAME);
+		journal = ReadBytes(std::string(FILE_NAME) + ".log");
+	}
+	std::vector<size_t> offsets = RecordOffsets(journal);
+	CHECK(offsets.size() == NUM_SCORES / 2);
+
+	//every record's crc is the crc of its entry
+	int numBadCrcs = 0;
+	for (size_t at : offsets)
+	{
+		uint16_t len;
+		uint32_t crc;
+		memcpy(&len, &journal[at], 2);
+		memcpy(&crc, &journal[at + 2 + len], 4);
+		numBadCrcs += crc != ReferenceCrc32(&journal[at + 2], len);
+	}
+	CHECK(numBadCrcs == 0);
+
+	//a clean close, then the crash with everything written
+	{
+		Leaderboard board;
+		CHECK(board.Open(FILE_NAME));
+		CHECK(Matches(board, scores, NUM_SCORES));
+		CHECK(board.GetNumJournalRecords() == 0);
+	}
+	{
+		Leaderboard board;
+		CHECK(Reopen(board, snapshot, journal));
+		CHECK(Matches(board, scores, NUM_SCORES));
+	}
+
+	//torn last record, only it goes and what's added afterwards isn't lost behind it
+	{
+		std::vector<uint8_t> torn(journal.begin(), journal.end() - 3);
+		Leaderboard board;
+		CHECK(Reopen(board, snapshot, torn));
+		CHECK(Matches(board, scores, NUM_SCORES - 1));
+		scores[NUM_SCORES - 1] = 999;
+		CHECK(board.Add("LAST", 999));
+	}
+	{
+		Leaderboard board;
+		CHECK(board.Open(CRASH_NAME));
+		CHECK(Matches(board, scores, NUM_SCORES));
+		CHECK(!board.GetTop().empty() && board.GetTop().begin()->score == 999);
+	}
+
+	//a corrupted record stops the replay there, even though the ones after it are fine
+	const size_t BAD = 50;
+	{
+		std::vector<uint8_t> corrupt = journal;
+		corrupt[offsets[BAD] + 3] ^= 0x40;
+		Leaderboard board;
+		CHECK(Reopen(board, snapshot, corrupt));
+		CHECK(Matches(board, scores, NUM_SCORES / 2 + BAD));
+	}
+	//same with the crc itself
+	{
+		std::vector<uint8_t> corrupt = journal;
+		size_t nextAt = BAD + 1 < offsets.size() ? offsets[BAD + 1] : journal.size();
+		corrupt[nextAt - 1] ^= 0x01;
+		Leaderboard board;
+		CHECK(Reopen(board, snapshot, corrupt));
+		CHECK(Matches(board, scores, NUM_SCORES / 2 + BAD));
+	}
+
+	//a bad snapshot is put aside and the journal still loads
+	{
+		std::vector<uint8_t> corrupt = snapshot;
+		corrupt[corrupt.size() / 2] ^= 0x10;
+		Leaderboard board;
+		CHECK(Reopen(board, corrupt, journal));
+		CHECK(fs::exists(std::string(CRASH_NAME) + ".bad"));
+		CHECK(board.GetNumEntries() == NUM_SCORES / 2);
+	}
+
+	RemoveFiles(FILE_NAME);
+	RemoveFiles(CRASH_NAME);
+
+	//a tie in every shard, fed to them back to front
+	const char* SERVER_DIR = "leaderboard_server_test";
+	const char* SERVER_SOCKET = "leaderboard_server_test.sock";
+	const size_t NUM_SHARDS = 4;
+	std::error_code ec;
+	fs::remove_all(SERVER_DIR, ec);
+	std::vector<LeaderboardProtocol::Score> top;
+	{
+		LeaderboardServer server(SERVER_DIR, NUM_SHARDS);
+		CHECK(server.Start(SERVER_SOCKET));
+		for (size_t i = 0; i < NUM_SHARDS * 2; ++i)
+		{
+			LeaderboardProtocol::Score tie{ "T" + std::to_string(i), 500 };
+			server.Submit(&tie, 1, NUM_SHARDS - 1 - i % NUM_SHARDS);
+		}
+		server.Stop();
+	}
+	{
+		LeaderboardServer server(SERVER_DIR, NUM_SHARDS);
+		CHECK(server.Start(SERVER_SOCKET));
+		LeaderboardProtocol::Score tie{ "LATE", 500 };
+		server.Submit(&tie, 1, NUM_SHARDS - 1);
+		server.GetTop(NUM_SHARDS * 2 + 1, top);
+		server.Stop();
+	}
+	CHECK(top.size() == NUM_SHARDS * 2 + 1);
+	int numOutOfOrder = 0;
+	for (size_t i = 0; i < top.size(); ++i)
+		numOutOfOrder += top[i].name != (i < NUM_SHARDS * 2 ? "T" + std::to_string(i) : std::string("LATE"));
+	CHECK(numOutOfOrder == 0);
+	fs::remove_all(SERVER_DIR, ec);
+
+	//a server that reads the score and dies before answering might have stored it
+	remove(SERVER_SOCKET);
+	{
+		LocalSocket fake;
+		CHECK(fake.Listen(SERVER_SOCKET));
+		std::thread reader([&]() {
+			LocalSocket conn = fake.Accept();
+			LeaderboardProtocol::MsgType type;
+			std::vector<uint8_t> body;
+			Receive(conn, type, body);
+		});
+		LeaderboardClient client;
+		CHECK(client.Connect(SERVER_SOCKET, 1000));
+		client.Queue("MAYBE", 1);
+		CHECK(!client.Flush());
+		CHECK(client.GetNumUnknown() == 1);
+		reader.join();
+	}
+	//one that hung up before the score went certainly didn't
+	remove(SERVER_SOCKET);
+	{
+		LocalSocket fake;
+		CHECK(fake.Listen(SERVER_SOCKET));
+		LeaderboardClient client;
+		CHECK(client.Connect(SERVER_SOCKET, 1000));
+		fake.Accept().Close();
+		client.Queue("NEVER", 1);
+		CHECK(!client.Flush());
+		CHECK(client.GetNumUnknown() == 0);
+	}
+	remove(SERVER_SOCKET);
+	return CheckResult("LeaderboardTests");
+}
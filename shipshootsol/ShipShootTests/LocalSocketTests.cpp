@@ -0,0 +1,81 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "Check.h"
+#include "LocalSocket.h"
+
+/*
+Listen mustn't take the path off a server that's still running, but
+must take over a socket file left by one that died. Then a round trip
+through a connection, a receive that times out and Shutdown waking up
+a blocked Accept.
+*/
+
+static const char* PATH = "local_socket_test.sock";
+
+int main()
+{
+	remove(PATH);
+	{
+		LocalSocket server;
+		CHECK(server.Listen(PATH));
+		//a second server is turned away, all the first sees is it checking and hanging up
+		LocalSocket second;
+		CHECK(!second.Listen(PATH));
+		CHECK(!second.IsOpen());
+		char got[8] = {};
+		LocalSocket check = server.Accept();
+		CHECK(check.IsOpen() && !check.RecvAll(got, 1));
+		LocalSocket client;
+		CHECK(client.Connect(PATH, 1000));
+
+		LocalSocket conn = server.Accept();
+		CHECK(conn.IsOpen());
+		const char hello[] = "hello";
+		CHECK(client.SendAll(hello, sizeof(hello)));
+		CHECK(conn.RecvAll(got, sizeof(hello)));
+		CHECK(memcmp(got, hello, sizeof(hello)) == 0);
+
+		//nothing coming, it gives up instead of hanging
+		conn.SetTimeout(50);
+		CHECK(!conn.RecvAll(got, 1));
+
+		std::thread waker([&]() {
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			server.Shutdown();
+		});
+		CHECK(!server.Accept().IsOpen());
+		waker.join();
+	}
+	//closing the server took its file with it
+	{
+		LocalSocket client;
+		CHECK(!client.Connect(PATH, 100));
+	}
+
+#ifndef _WIN32
+	//what a server that died leaves behind, a socket file nothing is listening on
+	int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	sockaddr_un addr{};
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, PATH, sizeof(addr.sun_path) - 1);
+	CHECK(bind(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+	close(sock);
+	{
+		LocalSocket server;
+		CHECK(server.Listen(PATH));
+		LocalSocket client;
+		CHECK(client.Connect(PATH, 1000));
+	}
+#endif
+	remove(PATH);
+	return CheckResult("LocalSocketTests");
+}
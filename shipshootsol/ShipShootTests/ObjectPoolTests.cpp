@@ -0,0 +1,100 @@
+#include <vector>
+
+#include "Check.h"
+#include "AllocTracker.h"
+#include "ObjectPool.h"
+#include "Random.h"
+
+/*
+What the soak run leans on the pools for: hours of things being made
+and lost in any order never touch the heap while there's room, every
+object is destroyed, one handed out as its base class goes back to the
+right pool and running out falls back to new, counted.
+*/
+
+class Shape
+{
+public:
+	explicit Shape(int id) : mId(id) { ++sNumLive; }
+	virtual ~Shape() { --sNumLive; }
+	virtual int Get() const { return mId; }
+	static int sNumLive;
+protected:
+	int mId;
+};
+int Shape::sNumLive = 0;
+
+//bigger than its base, so a slot of the wrong size would show
+class Boss : public Shape
+{
+public:
+	explicit Boss(int id) : Shape(id) { mPad[0] = id; }
+	int Get() const override { return mId * 100 + static_cast<int>(mPad[0] - mId); }
+private:
+	double mPad[8];
+};
+
+int main()
+{
+	const size_t CAPACITY = 64;
+	ObjectPool<Shape> shapes(CAPACITY);
+	ObjectPool<Boss> bosses(2);
+	std::vector<PoolPtr<Shape>> live;
+	live.reserve(CAPACITY + 8);
+	Random random(23);
+
+	//a long churn that stays inside the pool, with the order things go in shuffled
+	AllocTracker& allocs = AllocTracker::Get();
+	allocs.StartCapture();
+	int numWrong = 0;
+	for (int i = 0; i < 200000; ++i)
+	{
+		if (live.size() < CAPACITY && (live.empty() || random.Below(2) == 0))
+		{
+			live.push_back(shapes.Make(i));
+			numWrong += live.back()->Get() != i;
+		}
+		else
+		{
+			size_t at = random.Below(static_cast<uint32_t>(live.size()));
+			live[at] = std::move(live.back());
+			live.pop_back();
+		}
+		if (i % 1000 == 999)
+			allocs.EndFrame();
+	}
+	allocs.StopCapture();
+	CHECK(numWrong == 0);
+	CHECK(allocs.GetNumCaptured() == 0);
+	CHECK(shapes.GetNumOverflows() == 0);
+	CHECK(shapes.GetNumLive() == live.size());
+	CHECK(Shape::sNumLive == static_cast<int>(live.size()));
+	live.clear();
+	CHECK(shapes.GetNumLive() == 0);
+	CHECK(Shape::sNumLive == 0);
+
+	//one past full comes from the heap and still goes back properly
+	for (size_t i = 0; i < CAPACITY + 1; ++i)
+		live.push_back(shapes.Make(static_cast<int>(i)));
+	CHECK(shapes.GetNumOverflows() == 1);
+	CHECK(shapes.GetNumLive() == CAPACITY + 1);
+	live.clear();
+	CHECK(shapes.GetNumLive() == 0);
+	CHECK(Shape::sNumLive == 0);
+
+	//bosses held as shapes, next to plain new ones, all in one list
+	live.push_back(bosses.Make<Shape>(1));
+	live.push_back(shapes.Make(2));
+	live.push_back(bosses.Make<Shape>(3));
+	live.push_back(PoolPtr<Shape>(new Boss(4)));
+	CHECK(live[0]->Get() == 100 && live[1]->Get() == 2 && live[2]->Get() == 300 && live[3]->Get() == 400);
+	CHECK(bosses.GetNumLive() == 2 && shapes.GetNumLive() == 1);
+	live.erase(live.begin());
+	CHECK(bosses.GetNumLive() == 1);
+	live.push_back(bosses.Make<Shape>(5));
+	CHECK(bosses.GetNumOverflows() == 0);
+	live.clear();
+	CHECK(bosses.GetNumLive() == 0 && shapes.GetNumLive() == 0);
+	CHECK(Shape::sNumLive == 0);
+	return CheckResult("ObjectPoolTests");
+}
@@ -0,0 +1,148 @@
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Check.h"
+#include "PersistWorker.h"
+
+/*
+The worker held up by a job that waits for a go, so what's queued behind
+it is known: jobs with the same key coalesce into the first one's place,
+empty keys never do, a full queue makes the submitter wait, Flush waits
+for the job that's running too and after Stop jobs run straight away.
+*/
+
+//blocks the worker until Release
+class Gate
+{
+public:
+	std::function<bool()> Job()
+	{
+		return [this]() {
+			mRunning = true;
+			while (!mOpen)
+				std::this_thread::yield();
+			return true;
+		};
+	}
+	void WaitRunning()
+	{
+		while (!mRunning)
+			std::this_thread::yield();
+	}
+	void Release() { mOpen = true; }
+private:
+	std::atomic<bool> mRunning{ false }, mOpen{ false };
+};
+
+static std::string ReadText(const std::string& fileName)
+{
+	std::ifstream in(fileName, std::ios::binary);
+	return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+int main()
+{
+	//only the worker touches ran until a Flush
+	std::vector<std::string> ran;
+	auto log = [&](const std::string& what, bool ok = true) {
+		return [&ran, what, ok]() { ran.push_back(what); return ok; };
+	};
+
+	//coalescing and order
+	{
+		PersistWorker worker;
+		Gate gate;
+		worker.Submit("", gate.Job());
+		gate.WaitRunning();
+		worker.Submit("a", log("a1"));
+		worker.Submit("", log("x1"));
+		worker.Submit("b", log("b1"));
+		worker.Submit("a", log("a2"));
+		worker.Submit("", log("x2"));
+		worker.Submit("b", log("b2", false));
+		worker.Submit("a", log("a3"));
+		CHECK(worker.GetNumCoalesced() == 3);
+		gate.Release();
+		worker.Flush();
+		CHECK((ran == std::vector<std::string>{ "a3", "x1", "b2", "x2" }));
+		CHECK(worker.GetNumRun() == 5);
+		CHECK(worker.GetNumFailed() == 1);
+
+		//once a job has started a new one with its key goes behind it
+		Gate again;
+		ran.clear();
+		worker.Submit("a", again.Job());
+		again.WaitRunning();
+		worker.Submit("a", log("a4"));
+		CHECK(worker.GetNumCoalesced() == 3);
+		again.Release();
+		worker.Flush();
+		CHECK((ran == std::vector<std::string>{ "a4" }));
+	}
+
+	//a full queue makes Submit wait, it must not have got in while the worker is held up
+	{
+		PersistWorker worker(2);
+		Gate gate;
+		worker.Submit("", gate.Job());
+		gate.WaitRunning();
+		worker.Submit("k", [] { return true; });
+		worker.Submit("", [] { return true; });
+		std::atomic<bool> submitted{ false };
+		std::thread submitter([&]() {
+			worker.Submit("", [] { return true; });
+			submitted = true;
+		});
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		CHECK(!submitted);
+		//a waiting key still coalesces without needing space
+		worker.Submit("k", [] { return true; });
+		gate.Release();
+		submitter.join();
+		worker.Flush();
+		CHECK(submitted);
+		CHECK(worker.GetNumRun() == 4);
+		CHECK(worker.GetNumCoalesced() == 1);
+	}
+
+	//the last of several writes to one file is what's on disk
+	{
+		const std::string fileName = "persist_worker_test.txt";
+		PersistWorker worker;
+		Gate gate;
+		worker.Submit("", gate.Job());
+		gate.WaitRunning();
+		for (const char* text : { "one", "two", "three" })
+			worker.WriteFile(fileName, std::vector<uint8_t>(text, text + strlen(text)));
+		gate.Release();
+		worker.Flush();
+		CHECK(worker.GetNumCoalesced() == 2);
+		CHECK(worker.GetNumRun() == 2);
+		CHECK(ReadText(fileName) == "three");
+		CHECK(!std::filesystem::exists(fileName + ".tmp"));
+		std::error_code ec;
+		std::filesystem::remove(fileName, ec);
+	}
+
+	//everything queued before Stop runs, anything after runs on the caller
+	{
+		PersistWorker worker;
+		ran.clear();
+		for (int i = 0; i < 100; ++i)
+			worker.Submit("", log("q"));
+		worker.Stop();
+		CHECK(ran.size() == 100);
+		std::thread::id ranOn;
+		worker.Submit("a", [&]() { ranOn = std::this_thread::get_id(); return false; });
+		CHECK(ranOn == std::this_thread::get_id());
+		CHECK(worker.GetNumRun() == 101);
+		CHECK(worker.GetNumFailed() == 1);
+	}
+	return CheckResult("PersistWorkerTests");
+}
@@ -0,0 +1,118 @@
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "Check.h"
+#include "ShooterIndex.h"
+
+using namespace DirectX::SimpleMath;
+
+/*
+The shooter index kept up to date as enemies die and bosses come and
+go, checked after every change against working out who can shoot from
+scratch: the front of every column plus every boss. Then the random
+pattern, which should pick every column about as often.
+*/
+
+//the index only ever holds a pointer to one
+class Enemy
+{
+};
+
+//who can shoot, slots for the formation and -1 - (boss number) for the rest
+typedef std::multiset<long long> Shooters;
+
+static Shooters FromScratch(const Formation& formation, const std::vector<std::unique_ptr<Enemy>>& bosses, const std::vector<Enemy*>& all)
+{
+	Shooters shooters;
+	for (int col = 0; col < formation.GetNumCols(); ++col)
+	{
+		int slot = formation.GetFront(col);
+		if (slot >= 0)
+			shooters.insert(slot);
+	}
+	for (auto& pBoss : bosses)
+		for (size_t i = 0; i < all.size(); ++i)
+			if (all[i] == pBoss.get())
+				shooters.insert(-1 - static_cast<long long>(i));
+	return shooters;
+}
+
+static Shooters FromIndex(const ShooterIndex& index, const std::vector<Enemy*>& all)
+{
+	Shooters shooters;
+	for (int i = 0; i < index.GetNumShooters(); ++i)
+	{
+		const ShooterIndex::Shooter& shooter = index.Get(i);
+		if (!shooter.pEnemy)
+		{
+			shooters.insert(shooter.slot);
+			continue;
+		}
+		for (size_t j = 0; j < all.size(); ++j)
+			if (all[j] == shooter.pEnemy)
+				shooters.insert(-1 - static_cast<long long>(j));
+	}
+	return shooters;
+}
+
+int main()
+{
+	const int MAX_BOSSES = 2;
+	Random random(7);
+	RenderProxy proto;
+	proto.size = Vector2(10, 10);
+	int numChanges = 0, numWrong = 0;
+	for (int rep = 0; rep < 200; ++rep)
+	{
+		int numCols = 1 + random.Below(20), numRows = 1 + random.Below(10);
+		Formation formation;
+		formation.Init(proto, Vector2(0, 0), Vector2(10, 10), numCols, numRows);
+		ShooterIndex index;
+		index.Reset(formation, MAX_BOSSES);
+		std::vector<std::unique_ptr<Enemy>> bosses;
+		std::vector<Enemy*> all;		//every boss there's been, so each has a number
+		while (!formation.IsEmpty())
+		{
+			if (random.Below(10) == 0 && bosses.size() < MAX_BOSSES)
+			{
+				bosses.push_back(std::make_unique<Enemy>());
+				all.push_back(bosses.back().get());
+				index.Add(*bosses.back());
+			}
+			if (random.Below(10) == 0 && !bosses.empty())
+			{
+				size_t i = random.Below(static_cast<uint32_t>(bosses.size()));
+				numWrong += !index.Remove(*bosses[i]);
+				//a second time finds nothing and leaves the rest alone
+				numWrong += index.Remove(*bosses[i]);
+				bosses.erase(bosses.begin() + i);
+			}
+			int slot = random.Below(formation.GetNumSlots());
+			if (!formation.IsAlive(slot))
+				continue;
+			formation.Kill(slot);
+			index.OnKilled(formation, slot);
+			++numChanges;
+			numWrong += FromIndex(index, all) != FromScratch(formation, bosses, all);
+		}
+	}
+	printf("%d kills checked\n", numChanges);
+	CHECK(numChanges > 1000);
+	CHECK(numWrong == 0);
+
+	//6 columns, 60000 picks, each column's share should be within 5% of 10000
+	Formation formation;
+	formation.Init(proto, Vector2(0, 0), Vector2(10, 10), 6, 5);
+	ShooterIndex index;
+	index.Reset(formation, 0);
+	RandomFirePattern pattern;
+	int perCol[6] = {};
+	for (int i = 0; i < 60000; ++i)
+		++perCol[index.Get(pattern.Pick(index, random)).slot % 6];
+	for (int n : perCol)
+		CHECK(n > 9500 && n < 10500);
+	CHECK(pattern.GetInterval(index, 30) == 2);
+	CHECK(pattern.GetInterval(index, 0) == 60);
+	return CheckResult("ShooterIndexTests");
+}